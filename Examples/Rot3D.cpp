@@ -4,6 +4,7 @@
 #include "Support/Settings.h"
 #include "Support/Timer.h"
 #include "Support/debug.h"
+#include "Support/CoExecutor.h"
 #include "Kernels/Rot3D.h"
 
 using namespace V3DLib;
@@ -15,7 +16,7 @@ using KernelType = decltype(rot3D_1);  // All kernel functions except scalar hav
 // Command line handling
 // ============================================================================
 
-std::vector<const char *> const kernel_id = { "2", "3", "1", "1a", "cpu" };  // First is default
+std::vector<const char *> const kernel_id = { "2", "3", "1", "1a", "cpu", "co" };  // First is default
 
 CmdParameters params = {
   "Rot3D\n"
@@ -147,6 +148,55 @@ void run_qpu_kernel_3() {
 }
 
 
+/**
+ * Run kernel 2 on the QPUs and the scalar version on the host cores at the same time
+ *
+ * The split between the two is calibrated during the first few runs.
+ */
+void run_co_kernel() {
+  auto k = compile(rot3D_2);
+  k.setNumQPUs(settings.num_qpus);
+
+  Float::Array x(settings.num_vertices), y(settings.num_vertices);
+  init_arrays(x, y);
+
+  float const cosTheta = cosf(settings.THETA);
+  float const sinTheta = sinf(settings.THETA);
+
+  auto gpu = [&] (int begin, int end) {
+    k.load(end, cosTheta, sinTheta, &x, &y);
+    settings.process(k);
+  };
+
+  auto cpu = [&] (int begin, int end) {
+    rot3D(end - begin, cosTheta, sinTheta, x.ptr() + begin, y.ptr() + begin);
+  };
+
+  CoExecutor co(16*settings.num_qpus);
+
+  if (!settings.compile_only) {
+    int const CALIBRATION_RUNS = 4;
+    for (int i = 0; i < CALIBRATION_RUNS; i++) {
+      co.run(settings.num_vertices, gpu, cpu);
+    }
+    init_arrays(x, y);
+  }
+
+  Timer timer;  // Time the run only
+  if (!settings.compile_only) {
+    co.run(settings.num_vertices, gpu, cpu);
+  }
+  timer.end(!settings.silent);
+
+  if (!settings.silent) {
+    printf("QPUs handled %d of %d vertices, %d host threads.\n",
+      co.last_split(), settings.num_vertices, co.num_threads());
+  }
+
+  disp_arrays(x, y);
+}
+
+
 /**
  * Run a kernel as specified by the passed kernel index
  */
@@ -157,6 +207,7 @@ void run_kernel(int kernel_index) {
     case 2: run_qpu_kernel(rot3D_1);  break;  
     case 3: run_qpu_kernel(rot3D_1a); break;  
     case 4: run_scalar_kernel();      break;
+    case 5: run_co_kernel();          break;
   }
 
   auto name = kernel_id[kernel_index];
@@ -181,6 +181,22 @@ std::string BaseKernel::get_errors() const {
 }
 
 
+/**
+ * Get the compiled code for storage in a kernel blob
+ *
+ * The parameter signature is filled in by `Kernel`, which knows the parameter types.
+ */
+KernelBlob BaseKernel::blob() {
+  assertq(!has_errors(), "Can not create kernel blob, there were errors during compile");
+
+  KernelBlob ret;
+  if (has_vc4()) vc4().to_blob(ret.vc4);
+  if (has_v3d()) v3d().to_blob(ret.v3d);
+
+  return ret;
+}
+
+
 std::string BaseKernel::info() const {
   std::string ret;
 
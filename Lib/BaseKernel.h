@@ -53,6 +53,8 @@ namespace V3DLib {
  *    the vc4 kernel driver is always used, even if only assembling for v3d.
  */
 class BaseKernel {
+  friend class CoSchedule;
+
 public:
   BaseKernel();
   BaseKernel(BaseKernel &&k) = default;
@@ -83,6 +85,7 @@ public:
   bool has_errors() const;
   std::string get_errors() const;
   std::string info() const;
+  KernelBlob blob();
 
 protected:
   int m_numQPUs = 1;               // Number of QPUs to run on
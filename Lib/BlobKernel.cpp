@@ -0,0 +1,91 @@
+#include "BlobKernel.h"
+#include "Support/basics.h"
+#include "Support/Platform.h"
+#include "v3d/Invoke.h"
+
+namespace V3DLib {
+
+using ::operator<<;  // C++ weirdness
+
+BaseBlobKernel::BaseBlobKernel(KernelBlob const &blob, std::string const &signature) :
+  m_blob(blob)
+#ifdef QPU_MODE
+  , m_v3d_code(m_v3d_code_bo)
+#endif  // QPU_MODE
+{
+  if (m_blob.signature != signature) {
+    std::string msg;
+    msg << "Kernel blob has parameters (" << m_blob.signature << "), "
+        << "expected (" << signature << ")";
+    error(msg, true);
+  }
+
+  if (!has_vc4() && !has_v3d()) {
+    error("Kernel blob contains no code", true);
+  }
+}
+
+
+/**
+ * Invoke the kernel on the QPUs.
+ *
+ * There is no fallback to the emulator, see class header.
+ */
+void BaseBlobKernel::call() {
+  assertq(uniforms.size() == m_blob.num_uniforms, "Kernel blob: parameters not loaded");
+
+#ifdef QPU_MODE
+  if (Platform::use_main_memory()) {
+    error("Main memory selected, kernel blobs can only run on the QPUs", true);
+  }
+
+  if (Platform::has_vc4()) {
+    call_vc4();
+  } else {
+    call_v3d();
+  }
+#else
+  error("Kernel blobs can only run on the QPUs, QPU_MODE not enabled", true);
+#endif  // QPU_MODE
+}
+
+
+#ifdef QPU_MODE
+
+void BaseBlobKernel::call_vc4() {
+  assertq(has_vc4(), "Kernel blob contains no code for vc4", true);
+
+  if (!m_vc4_code.allocated()) {
+    m_vc4_code.alloc((uint32_t) m_blob.vc4.code.size());
+    m_vc4_code.copyFrom(m_blob.vc4.code);
+  }
+
+  MailBoxInvoke::invoke(m_numQPUs, m_vc4_code, uniforms);
+}
+
+
+void BaseBlobKernel::call_v3d() {
+  assertq(has_v3d(), "Kernel blob contains no code for v3d", true);
+
+  if (m_numQPUs != 1 && m_numQPUs != 8) {
+    error("Num QPU's must be 1 or 8", true);
+  }
+
+  auto const &target = m_blob.v3d;
+
+  if (!m_v3d_code.allocated()) {
+    m_v3d_code_bo.alloc((uint32_t) (sizeof(uint64_t)*target.code.size()));
+    m_v3d_code.alloc((uint32_t) target.code.size());
+    m_v3d_code.copyFrom(target.code);
+  }
+
+  if (!m_devnull.allocated()) {
+    m_devnull.alloc(v3d::devnull_size(target.local_rows));  // Also holds the atomics configurations and local arrays
+  }
+
+  v3d::invoke(m_numQPUs, target.num_threads, m_devnull, m_v3d_code, uniforms, target.uses_barrier);
+}
+
+#endif  // QPU_MODE
+
+}  // namespace V3DLib
@@ -0,0 +1,74 @@
+#ifndef _V3DLIB_BLOBKERNEL_H_
+#define _V3DLIB_BLOBKERNEL_H_
+#include "Kernel.h"
+#include "Common/KernelBlob.h"
+#include "vc4/Invoke.h"
+#include "v3d/BufferObject.h"
+
+namespace V3DLib {
+
+/**
+ * Kernel loaded from a precompiled kernel blob
+ *
+ * This runs the opcodes in the blob as is; the DSL front end and the
+ * compiler are not used. The kernel can only be run on the QPUs,
+ * since the emulator and interpreter need the compiled code.
+ */
+class BaseBlobKernel : private MailBoxInvoke {
+public:
+  BaseBlobKernel(KernelBlob const &blob, std::string const &signature);
+  BaseBlobKernel(BaseBlobKernel const &k) = delete;
+
+  bool has_vc4() const { return m_blob.vc4.present; }
+  bool has_v3d() const { return m_blob.v3d.present; }
+
+  BaseBlobKernel &setNumQPUs(int n) { m_numQPUs = n; return *this; }
+  int numQPUs() const { return m_numQPUs; }
+
+  void call();
+
+protected:
+  IntList uniforms;                // Parameters to be passed to kernel
+
+private:
+  KernelBlob m_blob;
+  int        m_numQPUs = 1;
+  Code       m_vc4_code;
+
+#ifdef QPU_MODE
+  v3d::BufferObject m_v3d_code_bo;
+  Code              m_v3d_code;    // Declared after its buffer object, so that it is released first
+  Data              m_devnull;
+
+  void call_vc4();
+  void call_v3d();
+#endif  // QPU_MODE
+};
+
+
+/**
+ * Typed kernel from a blob
+ *
+ * The parameter types must be the same as those of the `Kernel` the blob was created from.
+ */
+template <typename... ts>
+class BlobKernel : public BaseBlobKernel {
+public:
+  BlobKernel(KernelBlob const &blob) : BaseBlobKernel(blob, param_signature<ts...>()) {}
+
+  /**
+   * Load uniform values.
+   *
+   * Same as `Kernel::load()`.
+   */
+  template <typename... us>
+  BlobKernel &load(us... args) {
+    uniforms.clear();
+    nothing(passParam<ts, us>(uniforms, args)...);
+    return *this;
+  }
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_BLOBKERNEL_H_
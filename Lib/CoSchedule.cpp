@@ -0,0 +1,175 @@
+#include "CoSchedule.h"
+#include "Support/basics.h"
+#include "Support/Platform.h"
+#include "Target/BufferObject.h"
+#include "Target/Emulator.h"
+
+namespace V3DLib {
+namespace {
+
+int const BARRIER_SEMA = 10;  // First semaphore of `barrier()`
+int const ATOMIC_SEMA  = 14;  // Mutex of the atomics
+
+
+/**
+ * @return true if the vc4 code of the kernel uses the given semaphore
+ */
+bool uses_semaphore(BaseKernel &k, int sema_id) {
+  auto const &code = k.vc4().targetCode();
+
+  for (int i = 0; i < code.size(); i++) {
+    auto const &instr = code[i];
+    if ((instr.tag == InstrTag::SINC || instr.tag == InstrTag::SDEC) && instr.semaId == sema_id) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // anon namespace
+
+
+/**
+ * Add a kernel to run on the given number of QPUs
+ */
+CoSchedule &CoSchedule::add(BaseKernel &k, int numQPUs) {
+  assertq(numQPUs > 0, "CoSchedule: need at least one QPU per kernel", true);
+  assertq(!k.has_errors(), "CoSchedule: kernel has compile errors", true);
+
+  assertq(this->numQPUs() + numQPUs <= Platform::max_qpus(), "CoSchedule: more QPUs assigned than available", true);
+
+  if (Platform::has_vc4()) {
+    // The semaphores are shared by all kernels in the launch
+    for (auto const &job : m_jobs) {
+      assertq(!uses_semaphore(k, BARRIER_SEMA) || !uses_semaphore(*job.kernel, BARRIER_SEMA),
+        "CoSchedule: at most one kernel may use barrier()", true);
+      assertq(!uses_semaphore(k, ATOMIC_SEMA) || !uses_semaphore(*job.kernel, ATOMIC_SEMA),
+        "CoSchedule: at most one kernel may use atomics", true);
+    }
+  }
+
+  Job job;
+  job.kernel  = &k;
+  job.numQPUs = numQPUs;
+  m_jobs.push_back(job);
+  return *this;
+}
+
+
+int CoSchedule::numQPUs() const {
+  int ret = 0;
+
+  for (auto const &job : m_jobs) {
+    ret += job.numQPUs;
+  }
+
+  return ret;
+}
+
+
+/**
+ * @return true if the kernel at the given index has completed on the last run
+ */
+bool CoSchedule::done(int index) const {
+  assert(0 <= index && index < size());
+  return m_jobs[index].done;
+}
+
+
+/**
+ * @return number of emulation steps till the kernel at given index was done,
+ *         -1 if the last run was not on the emulator.
+ */
+int CoSchedule::steps(int index) const {
+  assert(0 <= index && index < size());
+  return m_jobs[index].steps;
+}
+
+
+void CoSchedule::reset() {
+  assertq(!m_jobs.empty(), "CoSchedule: no kernels to run", true);
+
+  for (auto &job : m_jobs) {
+    assertq(job.kernel->uniforms.size() != 0, "CoSchedule: parameters not loaded for kernel", true);
+    job.done  = false;
+    job.steps = -1;
+  }
+}
+
+
+/**
+ * Run all kernels on the emulator
+ */
+void CoSchedule::emu() {
+  reset();
+
+  std::vector<EmuJob> jobs(m_jobs.size());
+  for (int i = 0; i < size(); i++) {
+    BaseKernel &k = *m_jobs[i].kernel;
+    jobs[i].numQPUs  = m_jobs[i].numQPUs;
+    jobs[i].instrs   = &k.vc4().targetCode();
+    jobs[i].maxReg   = k.vc4().numVars();
+    jobs[i].uniforms = &k.uniforms;
+  }
+
+  emulate(jobs, getBufferObject());
+
+  for (int i = 0; i < size(); i++) {
+    m_jobs[i].done  = true;
+    m_jobs[i].steps = jobs[i].steps;
+  }
+}
+
+
+/**
+ * Run all kernels, as for `BaseKernel::call()`
+ */
+void CoSchedule::call() {
+#ifdef QPU_MODE
+  if (Platform::use_main_memory()) {
+    warning("Main memory selected in QPU mode, running on emulator instead of QPU.");
+    emu();
+  } else {
+    qpu();
+  }
+#else
+  emu();
+#endif
+}
+
+
+#ifdef QPU_MODE
+
+/**
+ * Run all kernels on the QPUs
+ */
+void CoSchedule::qpu() {
+  reset();
+
+  if (Platform::has_vc4()) {
+    std::vector<MailBoxLaunch> launches(m_jobs.size());
+    for (int i = 0; i < size(); i++) {
+      BaseKernel &k = *m_jobs[i].kernel;
+      launches[i].code    = &k.m_vc4_driver->code();
+      launches[i].params  = &k.uniforms;
+      launches[i].numQPUs = m_jobs[i].numQPUs;
+    }
+
+    bool ok = m_invoke.invoke(launches);
+
+    for (auto &job : m_jobs) {
+      job.done = ok;
+    }
+  } else {
+    // v3d jobs run a single kernel, run them in sequence
+    for (auto &job : m_jobs) {
+      job.kernel->v3d().invoke(job.numQPUs, job.kernel->uniforms);
+      job.done = true;
+    }
+  }
+}
+
+#endif  // QPU_MODE
+
+}  // namespace V3DLib
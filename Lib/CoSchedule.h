@@ -0,0 +1,79 @@
+#ifndef _V3DLIB_COSCHEDULE_H_
+#define _V3DLIB_COSCHEDULE_H_
+#include <vector>
+#include "BaseKernel.h"
+#include "vc4/Invoke.h"
+
+namespace V3DLib {
+
+/**
+ * Runs several compiled kernels at the same time, each on its own QPUs
+ *
+ * Normally, a kernel occupies all QPUs it is launched on, and kernels run one after
+ * the other. With a co-schedule, a light kernel can run next to a heavy one:
+ *
+ *    auto pre  = compile(preprocess);
+ *    auto gemm = compile(gemm_kernel);
+ *    pre.load(&in, &tmp);
+ *    gemm.load(&a, &b, &c);
+ *
+ *    CoSchedule sched;
+ *    sched.add(pre, 2).add(gemm, 10);
+ *    sched.call();
+ *
+ * The parameters last loaded into a kernel are used. Within a kernel, `me()` and
+ * `numQPUs()` are relative to the QPUs assigned to that kernel.
+ *
+ * - vc4: all kernels are started in a single launch, with separate launch messages per QPU.
+ *        `call()` returns when all kernels are done.
+ * - emulator: same as vc4. The number of emulation steps till each kernel was done
+ *             is available with `steps()`.
+ * - v3d: a job always runs a single kernel, so the kernels are run one after the other.
+ *
+ * On vc4, the kernels share the semaphores and the VPM:
+ *
+ * - Kernel termination uses semaphore 15 for all kernels, so a kernel may be held up
+ *   at termination by another kernel finishing.
+ * - `barrier()` uses semaphores 10-13, with `me() == 0` of a kernel coordinating. The QPUs
+ *   of two kernels using it would release each other. At most one of the kernels may use it.
+ * - The atomics use semaphore 14 as mutex (see `Source/Atomic.h`). At most one of the kernels may use them.
+ * - Local arrays and persistent kernels address VPM rows independent of the hardware QPU,
+ *   so at most one of the kernels may use them. This is not checked.
+ *
+ * `add()` rejects kernels which would share `barrier()` or atomics with a kernel added before.
+ * Regular loads and stores, `store_masked()` and pipelined loads address the VPM
+ * by the hardware QPU number, and do not conflict.
+ */
+class CoSchedule {
+public:
+  CoSchedule &add(BaseKernel &k, int numQPUs);
+  void clear() { m_jobs.clear(); }
+  int size() const { return (int) m_jobs.size(); }
+  int numQPUs() const;
+
+  void emu();
+  void call();
+#ifdef QPU_MODE
+  void qpu();
+#endif  // QPU_MODE
+
+  bool done(int index) const;
+  int steps(int index) const;
+
+private:
+  struct Job {
+    BaseKernel *kernel = nullptr;
+    int numQPUs        = 1;
+    bool done          = false;
+    int steps          = -1;       // Number of emulation steps, -1 if not run on emulator
+  };
+
+  std::vector<Job> m_jobs;
+  MailBoxCoInvoke  m_invoke;
+
+  void reset();
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_COSCHEDULE_H_
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// Binary format for precompiled kernels
+//
+// All values are stored as little-endian 32-bit words, opcodes as two words,
+// low word first:
+//
+//   magic, version
+//   signature length, signature characters (padded to a multiple of 4)
+//   num uniforms
+//   vc4 section
+//   v3d section
+//
+// A section consists of a present flag, and if present:
+//
+//   numVars, num threads, local rows, uses barrier, code size, opcodes
+//
+///////////////////////////////////////////////////////////////////////////////
+#include "KernelBlob.h"
+#include <cstdio>
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace {
+
+using Buffer = std::vector<uint8_t>;
+
+void put(Buffer &buf, uint32_t val) {
+  for (int i = 0; i < 4; i++) {
+    buf.push_back((uint8_t) (val >> (8*i)));
+  }
+}
+
+
+void put_section(Buffer &buf, KernelBlob::Target const &target) {
+  put(buf, target.present);
+  if (!target.present) return;
+
+  put(buf, (uint32_t) target.numVars);
+  put(buf, (uint32_t) target.num_threads);
+  put(buf, (uint32_t) target.local_rows);
+  put(buf, target.uses_barrier);
+  put(buf, (uint32_t) target.code.size());
+
+  for (auto op : target.code) {
+    put(buf, (uint32_t) op);
+    put(buf, (uint32_t) (op >> 32));
+  }
+}
+
+
+/**
+ * Reads words from a blob buffer, with bounds checking
+ */
+class Reader {
+public:
+  Reader(Buffer const &buf) : m_buf(buf) {}
+
+  bool ok() const { return m_ok; }
+
+  uint32_t get() {
+    if (m_offset + 4 > m_buf.size()) {
+      m_ok = false;
+      return 0;
+    }
+
+    uint32_t ret = 0;
+    for (int i = 0; i < 4; i++) {
+      ret |= ((uint32_t) m_buf[m_offset++]) << (8*i);
+    }
+
+    return ret;
+  }
+
+  std::string get_string(uint32_t size) {
+    std::string ret;
+    if (m_offset + size > m_buf.size()) {
+      m_ok = false;
+      return ret;
+    }
+
+    ret.assign((char const *) &m_buf[m_offset], size);
+    m_offset += (size + 3) & ~3u;
+    return ret;
+  }
+
+  void get_section(KernelBlob::Target &target) {
+    target = KernelBlob::Target();
+    target.present = (get() != 0);
+    if (!target.present) return;
+
+    target.numVars      = (int) get();
+    target.num_threads  = (int) get();
+    target.local_rows   = (int) get();
+    target.uses_barrier = (get() != 0);
+
+    uint32_t size = get();
+    if (!m_ok || 8ull*size > m_buf.size() - m_offset) {
+      m_ok = false;
+      return;
+    }
+
+    target.code.resize(size);
+    for (auto &op : target.code) {
+      uint64_t lo = get();
+      uint64_t hi = get();
+      op = (hi << 32) | lo;
+    }
+  }
+
+  bool at_end() const { return m_offset == m_buf.size(); }
+
+private:
+  Buffer const &m_buf;
+  size_t m_offset = 0;
+  bool   m_ok = true;
+};
+
+}  // anon namespace
+
+
+std::vector<uint8_t> KernelBlob::serialize() const {
+  Buffer buf;
+
+  put(buf, MAGIC);
+  put(buf, VERSION);
+
+  put(buf, (uint32_t) signature.size());
+  buf.insert(buf.end(), signature.begin(), signature.end());
+  while (buf.size() % 4 != 0) buf.push_back(0);
+
+  put(buf, (uint32_t) num_uniforms);
+  put_section(buf, vc4);
+  put_section(buf, v3d);
+
+  return buf;
+}
+
+
+/**
+ * Fill this blob from serialized data.
+ *
+ * @return true if successful, false if the data is not a valid blob for this version
+ */
+bool KernelBlob::deserialize(std::vector<uint8_t> const &buf) {
+  Reader r(buf);
+
+  if (r.get() != MAGIC) {
+    error("Kernel blob: not a kernel blob");
+    return false;
+  }
+
+  uint32_t version = r.get();
+  if (version != VERSION) {
+    std::string msg;
+    msg << "Kernel blob: version " << (int) version << " not supported, expected " << (int) VERSION;
+    error(msg);
+    return false;
+  }
+
+  signature    = r.get_string(r.get());
+  num_uniforms = (int) r.get();
+  r.get_section(vc4);
+  r.get_section(v3d);
+
+  if (!r.ok() || !r.at_end()) {
+    error("Kernel blob: data is truncated or corrupt");
+    return false;
+  }
+
+  return true;
+}
+
+
+bool KernelBlob::save(char const *filename) const {
+  assert(filename != nullptr);
+
+  FILE *f = fopen(filename, "wb");
+  if (f == nullptr) {
+    std::string msg;
+    msg << "Kernel blob: could not open file '" << filename << "' for writing";
+    error(msg);
+    return false;
+  }
+
+  Buffer buf = serialize();
+  bool ret = (fwrite(buf.data(), 1, buf.size(), f) == buf.size());
+  fclose(f);
+
+  if (!ret) {
+    std::string msg;
+    msg << "Kernel blob: could not write file '" << filename << "'";
+    error(msg);
+  }
+
+  return ret;
+}
+
+
+bool KernelBlob::load(char const *filename) {
+  assert(filename != nullptr);
+
+  FILE *f = fopen(filename, "rb");
+  if (f == nullptr) {
+    std::string msg;
+    msg << "Kernel blob: could not open file '" << filename << "' for reading";
+    error(msg);
+    return false;
+  }
+
+  Buffer buf;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    buf.insert(buf.end(), chunk, chunk + n);
+  }
+  fclose(f);
+
+  return deserialize(buf);
+}
+
+}  // namespace V3DLib
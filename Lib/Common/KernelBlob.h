@@ -0,0 +1,47 @@
+#ifndef _V3DLIB_COMMON_KERNELBLOB_H_
+#define _V3DLIB_COMMON_KERNELBLOB_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace V3DLib {
+
+/**
+ * Precompiled kernel, as stored in a kernel blob file
+ *
+ * This contains everything needed to launch a kernel on the QPUs,
+ * without having to run the compiler. See `BlobKernel` for running it.
+ *
+ * The uniform layout is fixed per target; only the kernel parameters
+ * vary per kernel:
+ *
+ *   - vc4: QPU id, num QPUs, <kernel params>, dummy value
+ *   - v3d: QPU id, num QPUs, devnull address, <kernel params>, done address
+ */
+struct KernelBlob {
+  static uint32_t const MAGIC   = 0x4b443356;  // 'V3DK' in little-endian
+  static uint32_t const VERSION = 1;
+
+  struct Target {
+    bool present       = false;
+    int  numVars       = 0;
+    int  num_threads   = 1;      // v3d only
+    int  local_rows    = 0;      // v3d only, number of vectors used by local arrays
+    bool uses_barrier  = false;  // v3d only
+    std::vector<uint64_t> code;  // opcodes
+  };
+
+  std::string signature;         // Parameter types of the kernel, comma-separated
+  int         num_uniforms = 0;  // Number of uniform values for the kernel parameters
+  Target      vc4;
+  Target      v3d;
+
+  std::vector<uint8_t> serialize() const;
+  bool deserialize(std::vector<uint8_t> const &buf);
+  bool save(char const *filename) const;
+  bool load(char const *filename);
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_COMMON_KERNELBLOB_H_
@@ -0,0 +1,151 @@
+#ifndef _V3DLIB_COMMON_LAYOUT2D_H_
+#define _V3DLIB_COMMON_LAYOUT2D_H_
+#include <cstdint>
+#include "../Support/basics.h"
+
+namespace V3DLib {
+
+/**
+ * Memory layout of the elements of a 2D shared array
+ *
+ * - ROW_MAJOR - rows stored one after the other, without padding. This is the default.
+ * - PADDED    - row-major, but with a row pitch which is a multiple of 16.
+ *               Useful to keep row starts aligned, or to offset rows against the TMU cache sets.
+ * - BLOCKED   - 16x16 tiles, stored row by row. Within a tile, the elements are row-major.
+ * - MORTON    - 16x16 tiles, stored in Morton (Z-)order. Within a tile, the elements are row-major.
+ *
+ * For all layouts, 16 consecutive columns starting at a multiple of 16 are consecutive
+ * in memory. Kernels can therefore load and store whole vectors per row, as with row-major.
+ * Going down a column stays within a tile of 1KB for the tiled layouts, which is
+ * much more friendly to the TMU cache than striding over whole rows.
+ *
+ * The address calculation is determined by the layout type and the pitch.
+ * For the tiled layouts, the pitch is the number of columns rounded up to a multiple of 16.
+ * The morton layout does not use the pitch.
+ *
+ * The padding elements are not part of the array; they are zeroed on allocation.
+ * The morton layout needs the most padding for arrays which are far from square.
+ */
+class Layout2D {
+public:
+  enum Type {
+    ROW_MAJOR,
+    PADDED,
+    BLOCKED,
+    MORTON
+  };
+
+  static int const TILE = 16;
+
+  /**
+   * @param pitch  Only for PADDED; row pitch in elements. If 0, use the columns
+   *               rounded up to a multiple of 16.
+   */
+  Layout2D(Type type = ROW_MAJOR, int pitch = 0) : m_type(type), m_pitch(pitch) {
+    assertq(type == PADDED || pitch == 0, "Layout2D: pitch can only be specified for the padded layout", true);
+    assertq(pitch >= 0 && pitch % TILE == 0, "Layout2D: pitch must be a multiple of 16", true);
+  }
+
+  /**
+   * Set the dimensions of the array to lay out.
+   */
+  void init(int rows, int columns) {
+    assert(rows > 0);
+    assert(columns > 0);
+
+    m_rows    = rows;
+    m_columns = columns;
+
+    switch (m_type) {
+      case ROW_MAJOR:
+        m_pitch = columns;
+        break;
+      case PADDED:
+        if (m_pitch == 0) m_pitch = round_up(columns);
+        assertq(m_pitch >= columns, "Layout2D: pitch is smaller than the number of columns", true);
+        break;
+      case BLOCKED:
+      case MORTON:
+        m_pitch = round_up(columns);
+        break;
+    }
+  }
+
+  Type type()  const { return m_type; }
+  int pitch()  const { return m_pitch; }
+  bool is_row_major() const { return m_type == ROW_MAJOR; }
+  bool has_padding() const { return size() != m_rows*m_columns; }
+
+
+  /**
+   * Number of elements needed for the layout, including padding.
+   */
+  int size() const {
+    switch (m_type) {
+      case ROW_MAJOR:
+      case PADDED:
+        return m_rows*m_pitch;
+      case BLOCKED:
+        return round_up(m_rows)*m_pitch;
+      case MORTON:
+        return (morton((m_rows - 1)/TILE, (m_pitch - 1)/TILE) + 1)*TILE*TILE;
+    }
+
+    assert(false);
+    return -1;
+  }
+
+
+  /**
+   * Calculate the index of an element in memory.
+   *
+   * Same calculation as `LayoutPtr::offset()` in the kernels.
+   */
+  int offset(int row, int col) const {
+    switch (m_type) {
+      case ROW_MAJOR:
+      case PADDED:
+        return row*m_pitch + col;
+      case BLOCKED:
+        return (row/TILE)*TILE*m_pitch + (col/TILE)*TILE*TILE + in_tile(row, col);
+      case MORTON:
+        return morton(row/TILE, col/TILE)*TILE*TILE + in_tile(row, col);
+    }
+
+    assert(false);
+    return -1;
+  }
+
+
+  /**
+   * Interleave the bits of the row and column tile indexes.
+   *
+   * The column bits are in the even positions.
+   */
+  static int morton(int tile_row, int tile_col) {
+    assert(0 <= tile_row && tile_row < (1 << 15));
+    assert(0 <= tile_col && tile_col < (1 << 15));
+    return (int) ((spread((uint32_t) tile_row) << 1) | spread((uint32_t) tile_col));
+  }
+
+private:
+  Type m_type;
+  int m_pitch   = 0;
+  int m_rows    = 0;
+  int m_columns = 0;
+
+  static int round_up(int n) { return TILE*((n + TILE - 1)/TILE); }
+  static int in_tile(int row, int col) { return (row % TILE)*TILE + (col % TILE); }
+
+  static uint32_t spread(uint32_t x) {
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+  }
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_COMMON_LAYOUT2D_H_
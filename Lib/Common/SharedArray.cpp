@@ -23,6 +23,17 @@ bool BaseSharedArray::allocated() const {
 }
 
 
+/**
+ * The memory reserved on the heap is padded to a multiple of 16 elements.
+ *
+ * This allows kernels to read and write the final partial vector of an array as a whole,
+ * without touching other allocations.
+ */
+uint32_t BaseSharedArray::mem_size() const {
+  return m_element_size*(16*((m_size + 15)/16));
+}
+
+
 /**
  * @param n number of 4-byte elements to allocate (so NOT memory size!)
  */
@@ -35,8 +46,8 @@ void BaseSharedArray::alloc(uint32_t n) {
     m_heap = &getBufferObject();
   }
 
-  m_phyaddr = m_heap->alloc_array((uint32_t) (m_element_size*n), m_usraddr);
   m_size = n;
+  m_phyaddr = m_heap->alloc_array(mem_size(), m_usraddr);
   assert(allocated());
 }
 
@@ -51,7 +62,7 @@ void BaseSharedArray::dealloc() {
     assert(allocated());
     assert(m_heap != nullptr);
     if (!m_is_heap_view) { 
-      m_heap->dealloc_array(m_phyaddr, (uint32_t) (m_element_size*m_size));
+      m_heap->dealloc_array(m_phyaddr, mem_size());
     }
 
     m_phyaddr = 0;
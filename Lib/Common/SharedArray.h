@@ -2,6 +2,7 @@
 #define _V3DLIB_COMMON_SHAREDARRAY_H_
 #include <vector>
 #include "BufferObject.h"
+#include "Layout2D.h"
 #include "../Support/basics.h"
 #include "../Support/Platform.h"  // has_vc4
 
@@ -38,6 +39,8 @@ private:
 
   BaseSharedArray(BaseSharedArray const &a) = delete;  // Disallow copy
 
+  uint32_t mem_size() const;
+
 };
 
 
@@ -188,6 +191,13 @@ protected:
 };
 
 
+/**
+ * 2D array in shared memory
+ *
+ * The elements can be laid out in different ways, see `Layout2D`.
+ * Element access from the host is the same for all layouts.
+ * Kernels need to use `LayoutPtr` if the layout is not row-major.
+ */
 template <typename T>
 class Shared2DArray : private SharedArray<T> {
   using Parent = SharedArray<T>;
@@ -198,36 +208,38 @@ public:
   // made public for Complex::Array2D. In all other cases should be regarded as private
   // TODO examine if this can be enforced
   struct Row {
-    Row(Shared2DArray const *parent, int row, int row_size) :
-      m_parent(const_cast<Parent *>((Parent const *) parent)),
-      m_row(row),
-      m_row_size(row_size) {}
+    Row(Shared2DArray const *parent, int row) :
+      m_parent(const_cast<Shared2DArray *>(parent)),
+      m_row(row) {}
 
-    T operator[] (int col) const { return (*m_parent)[m_row*m_row_size + col]; }
-    T &operator[] (int col)      { return (*m_parent)[m_row*m_row_size + col]; }
+    T operator[] (int col) const { return m_parent->at(m_row, col); }
+    T &operator[] (int col)      { return m_parent->at(m_row, col); }
 
-    Parent *m_parent;
+    Shared2DArray *m_parent;
     int m_row;
-    int m_row_size;
   };
 
   Shared2DArray() = default;
 
-  Shared2DArray(int rows, int columns) : Parent(rows*columns),  m_rows(rows), m_columns(columns) {
-    validate();
+  Shared2DArray(int rows, int columns, Layout2D const &layout = Layout2D()) {
+    alloc(rows, columns, layout);
   }
 
   Shared2DArray(int dimension) : Shared2DArray(dimension, dimension) {}  // for square array
 
-  void alloc(uint32_t rows, uint32_t columns) {
+  void alloc(uint32_t rows, uint32_t columns, Layout2D const &layout = Layout2D()) {
     m_rows = rows;
     m_columns = columns;
-    validate();
+    m_layout = layout;
+    m_layout.init(rows, columns);
+
+    Parent::alloc(m_layout.size());
 
-    Parent::alloc(rows*columns);
+    if (m_layout.has_padding()) {
+      Parent::fill(T());
+    }
   }
 
-  using Parent::fill;
   using Parent::getAddress;
   using Parent::allocated;
 
@@ -235,6 +247,16 @@ public:
 
   int rows()    const { return m_rows; }
   int columns() const { return m_columns; }
+  Layout2D const &layout() const { return m_layout; }
+  int pitch() const { return m_layout.pitch(); }
+
+  void fill(T val) {
+    for (int r = 0; r < m_rows; r++) {
+      for (int c = 0; c < m_columns; c++) {
+        at(r, c) = val;
+      }
+    }
+  }
 
   /**
    * Copy values from square array `a` to array `b`, tranposing the array in the process
@@ -252,22 +274,49 @@ public:
     }
   }
 
+
+  /**
+   * Copy the values of another array, converting between layouts if necessary.
+   */
+  void copy_from(Shared2DArray const &rhs) {
+    assertq(m_rows == rhs.m_rows && m_columns == rhs.m_columns,
+      "copy_from(): can only copy if arrays have same dimensions", true);
+
+    for (int r = 0; r < m_rows; r++) {
+      for (int c = 0; c < m_columns; c++) {
+        at(r, c) = rhs.at(r, c);
+      }
+    }
+  }
+
+
   bool is_square() const {
     return m_rows == m_columns;
   }
 
+  /**
+   * Arrays are equal if the elements are equal, regardless of layout
+   */
   bool operator==(Shared2DArray const &rhs) const { 
-    return ((Parent &) *this) == rhs;
+    if (m_rows != rhs.m_rows || m_columns != rhs.m_columns) return false;
+
+    for (int r = 0; r < m_rows; r++) {
+      for (int c = 0; c < m_columns; c++) {
+        if (at(r, c) != rhs.at(r, c)) return false;
+      }
+    }
+
+    return true;
   }
 
   Row operator[] (int row) {
     assert(0 <= row && row < m_rows);
-    return Row(this, row, m_columns);
+    return Row(this, row);
   }
 
   Row operator[] (int row) const {  // grumbl
     assert(0 <= row && row < m_rows);
-    return Row(this, row, m_columns);
+    return Row(this, row);
   }
 
   void make_unit_matrix() {
@@ -277,7 +326,7 @@ public:
 
     for (int r = 0; r < dim; r++) {
       for (int c = 0; c < dim; c++) {
-        Parent::access(r*dim + c) = (r == c)? 1 : 0;
+        at(r, c) = (r == c)? 1 : 0;
       }
     }
   }
@@ -303,6 +352,9 @@ public:
   }
 
 
+  /**
+   * Copy the elements to a vector, in row-major order
+   */
   void copyTo(std::vector<T> &dst) {
     assert(rows() > 0);
     assert(columns() > 0);
@@ -317,16 +369,33 @@ public:
     }
   }
 
+
+  /**
+   * Copy the elements from a vector in row-major order
+   */
+  void copyFrom(std::vector<T> const &src) {
+    assert(src.size() == (size_t) (rows()*columns()));
+
+    for (int r = 0; r < rows(); ++r) {
+      for (int c = 0; c < columns(); ++c) {
+        at(r, c) = src[r*columns() + c];
+      }
+    }
+  }
+
 private:
   int m_rows    = -1;  // init to illegal value
   int m_columns = -1;
+  Layout2D m_layout;
 
-  void validate() {
-    assert(m_rows > 0);
-    assert(m_columns > 0);
+  T &at(int row, int col) {
+    assert(0 <= col && col < m_columns);
+    return Parent::access(m_layout.offset(row, col));
+  }
 
-    // TODO you sure about next? Check!
-    assertq((m_rows*m_columns) % 16 == 0, "Shared2DArray: array size must be a multiple of 16");
+  T at(int row, int col) const {
+    assert(0 <= col && col < m_columns);
+    return Parent::access(m_layout.offset(row, col));
   }
 };
 
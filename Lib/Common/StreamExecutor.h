@@ -0,0 +1,176 @@
+#ifndef _V3DLIB_COMMON_STREAMEXECUTOR_H_
+#define _V3DLIB_COMMON_STREAMEXECUTOR_H_
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "SharedArray.h"
+
+namespace V3DLib {
+
+/**
+ * Run a kernel over input data which does not fit in the shared heap
+ *
+ * The input is read in chunks into a ring of staging buffers in shared memory.
+ * While the kernel runs on chunk N, the output of chunk N-1 is written and
+ * the input of chunk N+1 is read on a separate thread.
+ *
+ * The heap usage is fixed: `ring_size` times a chunk of input and a chunk of output.
+ *
+ * The kernel is run with a user-supplied function, which is passed the staging buffers
+ * and the number of valid items in the input chunk. The remainder of the last input chunk
+ * is zeroed, so that kernels processing whole vectors can ignore the count.
+ * Only the first `count` items of the output chunk are written.
+ *
+ * Usage:
+ *
+ *    auto k = compile(kernel);   // kernel(Int n, Float::Ptr in, Float::Ptr out)
+ *
+ *    StreamExecutor<float> stream(16*1024);
+ *    stream.run(
+ *      StreamExecutor<float>::from_vector(input),
+ *      StreamExecutor<float>::to_vector(output),
+ *      [&k] (Float::Array &in, Float::Array &out, int count) {
+ *        k.load(count, &in, &out).call();
+ *      }
+ *    );
+ */
+template <typename T, typename U = T>
+class StreamExecutor {
+public:
+  using Reader = std::function<int(T *dst, int max_count)>;  // Returns number read, 0 at end of input
+  using Writer = std::function<void(U const *src, int count)>;
+  using Launch = std::function<void(SharedArray<T> &in, SharedArray<U> &out, int count)>;
+
+  StreamExecutor(int chunk_size, int ring_size = 2) : m_chunk_size(chunk_size) {
+    assertq(chunk_size > 0, "StreamExecutor: chunk size must be positive", true);
+    assertq(ring_size >= 2, "StreamExecutor: need at least two staging buffers", true);
+
+    for (int i = 0; i < ring_size; i++) {
+      m_ring.emplace_back(new Slot(chunk_size));
+    }
+  }
+
+
+  /**
+   * Process all input
+   *
+   * @return number of items processed
+   */
+  long long run(Reader read, Writer write, Launch launch) {
+    long long total = 0;
+
+    auto fill = [this, &read] (Slot &s) {
+      s.count = read(s.in.ptr(), m_chunk_size);
+      assert(0 <= s.count && s.count <= m_chunk_size);
+
+      for (int i = s.count; i < m_chunk_size; i++) {
+        s.in[i] = T();
+      }
+    };
+
+    auto drain = [&write] (Slot &s) {
+      if (s.count > 0) {
+        write(s.out.ptr(), s.count);
+      }
+    };
+
+    fill(slot(0));
+
+    int n = 0;
+    while (slot(n).count > 0) {
+      Slot &cur  = slot(n);
+      Slot &next = slot(n + 1);
+      Slot *prev = (n > 0)?&slot(n - 1):nullptr;  // Same as next for ring size 2, drained first
+
+      std::exception_ptr io_error;
+      std::thread io([&] {
+        try {
+          if (prev != nullptr) drain(*prev);
+          fill(next);
+        } catch (...) {
+          io_error = std::current_exception();
+        }
+      });
+
+      try {
+        launch(cur.in, cur.out, cur.count);
+      } catch (...) {
+        io.join();
+        throw;
+      }
+
+      io.join();
+      if (io_error) std::rethrow_exception(io_error);
+
+      total += cur.count;
+      n++;
+    }
+
+    if (n > 0) {
+      drain(slot(n - 1));
+    }
+
+    return total;
+  }
+
+
+  //
+  // Readers and writers for common cases
+  //
+
+  static Reader from_vector(std::vector<T> const &src) {
+    auto offset = std::make_shared<size_t>(0);
+
+    return [&src, offset] (T *dst, int max_count) -> int {
+      int count = (int) std::min((size_t) max_count, src.size() - *offset);
+      std::copy(src.begin() + *offset, src.begin() + *offset + count, dst);
+      *offset += count;
+      return count;
+    };
+  }
+
+
+  static Writer to_vector(std::vector<U> &dst) {
+    return [&dst] (U const *src, int count) {
+      dst.insert(dst.end(), src, src + count);
+    };
+  }
+
+
+  static Reader from_file(FILE *f) {
+    return [f] (T *dst, int max_count) -> int {
+      return (int) fread(dst, sizeof(T), (size_t) max_count, f);
+    };
+  }
+
+
+  static Writer to_file(FILE *f) {
+    return [f] (U const *src, int count) {
+      if (fwrite(src, sizeof(U), (size_t) count, f) != (size_t) count) {
+        error("StreamExecutor: could not write output file", true);
+      }
+    };
+  }
+
+private:
+  struct Slot {
+    Slot(int size) : in((uint32_t) size), out((uint32_t) size) {}
+
+    SharedArray<T> in;
+    SharedArray<U> out;
+    int count = 0;
+  };
+
+  int m_chunk_size;
+  std::vector<std::unique_ptr<Slot>> m_ring;
+
+  Slot &slot(int n) { return *m_ring[n % m_ring.size()]; }
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_COMMON_STREAMEXECUTOR_H_
@@ -2,6 +2,7 @@
 #define _V3DLIB_KERNEL_H_
 #include <tuple>
 #include <algorithm>  // std::move
+#include <functional>
 #include "BaseKernel.h"
 #include "Source/Complex.h"
 //#include "Support/assign.h"
@@ -48,6 +49,58 @@ inline bool passParam< Complex::Ptr, Complex::Array2D * > (IntList &uniforms, Co
 }
 
 
+// ============================================================================
+// Parameter signature, for kernel blobs
+// ============================================================================
+
+/**
+ * Name and number of uniforms per kernel parameter type
+ */
+template <typename T> struct KernelParam;
+
+template <> struct KernelParam<Int> {
+  static std::string name() { return "Int"; }
+  static int size() { return 1; }
+};
+
+template <> struct KernelParam<Float> {
+  static std::string name() { return "Float"; }
+  static int size() { return 1; }
+};
+
+template <typename T> struct KernelParam<ptr::Ptr<T>> {
+  static std::string name() { return KernelParam<T>::name() + "::Ptr"; }
+  static int size() { return 1; }
+};
+
+template <> struct KernelParam<Complex::Ptr> {
+  static std::string name() { return "Complex::Ptr"; }
+  static int size() { return 2; }  // Separate pointers for re and im
+};
+
+
+template <typename... ts>
+std::string param_signature() {
+  std::string ret;
+  for (auto const &name : { std::string(), KernelParam<ts>::name()... }) {
+    if (name.empty()) continue;
+    if (!ret.empty()) ret += ",";
+    ret += name;
+  }
+  return ret;
+}
+
+
+template <typename... ts>
+int param_uniforms() {
+  int ret = 0;
+  for (int size : { 0, KernelParam<ts>::size()... }) {
+    ret += size;
+  }
+  return ret;
+}
+
+
 /**
  * API kernel definition.
  *
@@ -91,7 +144,13 @@ public:
   /**
    * Construct kernel out of C++ function
    */
-  Kernel(KernelFunction f, CompileFor compile_for) {
+  Kernel(KernelFunction f, CompileFor compile_for) : Kernel(std::function<void(ts...)>(f), compile_for) {}
+
+
+  /**
+   * Construct kernel out of a callable, for kernels generated by the library itself
+   */
+  Kernel(std::function<void(ts...)> f, CompileFor compile_for) {
     if (compile_for & VC4) {
       compile_init(true);
       vc4().compile([this, f] () {
@@ -120,6 +179,19 @@ public:
     nothing(passParam<ts, us>(uniforms, args)...);
     return *this;
   }
+
+
+  /**
+   * Get the compiled kernel as a blob, for running it later without compiling.
+   *
+   * See `BlobKernel`.
+   */
+  KernelBlob blob() {
+    KernelBlob ret = BaseKernel::blob();
+    ret.signature    = param_signature<ts...>();
+    ret.num_uniforms = param_uniforms<ts...>();
+    return ret;
+  }
 };
 
 
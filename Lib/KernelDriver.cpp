@@ -6,6 +6,9 @@
 #include "Source/Pretty.h"
 #include "Source/Translate.h"
 #include "Source/Lang.h"       // initStmt
+#include "Source/Functions.h"  // reset_subroutines
+#include "Source/Atomic.h"     // atomics::reset
+#include "Source/Local.h"      // local::reset
 #include "Target/Satisfy.h"
 #include "SourceTranslate.h"
 #include "Support/Timer.h"
@@ -148,6 +151,9 @@ void KernelDriver::init_compile() {
   VarGen::reset();
   resetFreshLabelGen();
   Pointer::reset_increment();
+  functions::reset_subroutines();
+  atomics::reset();
+  local::reset();
   compile_data.clear();
 
   // Initialize reserved general-purpose variables
@@ -240,6 +246,20 @@ Stmts &KernelDriver::sourceCode() {
 }
 
 
+/**
+ * Export the compiled kernel for storage in a kernel blob.
+ *
+ * The derived classes add the opcodes and their platform-specific settings.
+ */
+void KernelDriver::to_blob(KernelBlob::Target &target) {
+  assertq(!has_errors(), "Can not create kernel blob, there were errors during compile");
+
+  target = KernelBlob::Target();
+  target.present = true;
+  target.numVars = m_numVars;
+}
+
+
 /**
 * @brief Output a human-readable representation of the source and target code.
 *
@@ -5,6 +5,7 @@
 #include <functional>
 #include "Common/BufferType.h"
 #include "Common/CompileData.h"
+#include "Common/KernelBlob.h"
 #include "Source/StmtStack.h"
 
 namespace V3DLib {
@@ -24,6 +25,7 @@ public:
   int numVars() const { return m_numVars; }
   Instr::List &targetCode() { return m_targetCode; }
   Stmts &sourceCode();
+  virtual void to_blob(KernelBlob::Target &target);
 
   void pretty(char const *filename = nullptr, bool output_qpu_code = true);
   std::string compile_info() const;
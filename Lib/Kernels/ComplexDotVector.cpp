@@ -19,52 +19,8 @@ void pre_write(Complex::Ptr &dst, Complex &src, bool add_result) {
 
 
 void pre_write(Complex::Ptr &dst, Complex &src, bool add_result, Int const &j) {
-  if (Platform::compiling_for_vc4()) {
-    pre_write(dst.re(), src.re(), add_result, j);
-    pre_write(dst.im(), src.im(), add_result, j);
-
-/*
-    Complex tmp = 0;
-
-    if (add_result) {
-      comment("vc4 complex pre_write with add");
-      int pre_label = prefetch_label();
-      Complex::Ptr dst_read = dst;
-      pre_read(tmp, dst_read, pre_label);
-
-      tmp += src;
-    } else {
-      comment("vc4 complex pre_write no add");
-      tmp = src;
-    }
-
-    vpmSetupWrite(HORIZ, 2*me());
-    vpmPut(tmp.re());
-
-    vpmSetupWrite(HORIZ, 2*me() + 1);  // Reset required!
-    vpmPut(tmp.im());
-
-    dmaSetWriteStride((16 - j)*4);
-    dmaSetupWrite(HORIZ, 1, 4*2*me(), j);
-    dmaStartWrite(dst.re());
-    dmaWaitWrite();   
-
-    dmaSetWriteStride((16 - j)*4);
-    dmaSetupWrite(HORIZ, 1, 4*(2*me() + 1), j);
-    dmaStartWrite(dst.im());
-    dmaWaitWrite();   
-*/
-  } else {
-    Complex::Ptr local_dst = dst;
-
-    Where (index() >= j)
-      local_dst.re() = devnull();  comment("pre_write complex set top bits dst to devnull");
-      local_dst.im() = devnull();
-    End
-
-    pre_write(local_dst, src, add_result);
-  }
-
+  pre_write(dst.re(), src.re(), add_result, j);
+  pre_write(dst.im(), src.im(), add_result, j);
 }
 
 
@@ -75,15 +75,29 @@ void DotVector::dft_dot_product(Int const &row, Complex &result, int num_element
 /**
  * on v3d, TMU is used always for writes.
  * on vc4, DMA is used always.
+ *
+ * If passed, `op` is applied to the final value, i.e. after adding the current value in `dst`.
  */
-void pre_write(Float::Ptr &dst, Float &src, bool add_result) {
+void pre_write(Float::Ptr &dst, Float &src, bool add_result, PreWriteOp const &op) {
   if (add_result) {
     int pre_label = prefetch_label();
     Float::Ptr dst_read = dst;
 
     Float tmp = 0;
     prefetch(tmp, dst_read, pre_label);
-    *dst = tmp + src;
+
+    if (op) {
+      tmp += src;
+      op(tmp);
+      *dst = tmp;
+    } else {
+      *dst = tmp + src;
+    }
+    dst.inc();
+  } else if (op) {
+    Float tmp = src;
+    op(tmp);
+    *dst = tmp;
     dst.inc();
   } else {
     *dst = src;
@@ -95,42 +109,26 @@ void pre_write(Float::Ptr &dst, Float &src, bool add_result) {
 /**
  * Write first j values of src vector to dst
  */
-void pre_write(Float::Ptr &dst, Float &src, bool add_result, Int const &j) {
-  if (Platform::compiling_for_vc4()) {
-    Float tmp = 0;
-
-    if (add_result) {
-      comment("vc4 float pre_write with add");
-      int pre_label = prefetch_label();
-
-      Float::Ptr dst_read = dst;
+void pre_write(Float::Ptr &dst, Float &src, bool add_result, Int const &j, PreWriteOp const &op) {
+  Float tmp = 0;
 
-      prefetch(tmp, dst_read, pre_label);
-      tmp += src;
-    } else {
-      comment("vc4 float pre_write no add");
-      tmp = src;
-    }
-
-    dmaWaitWrite();
-
-    vpmSetupWrite(HORIZ, me());
-    vpmPut(tmp);
+  if (add_result) {
+    comment("float pre_write with add");
+    int pre_label = prefetch_label();
 
-    dmaSetWriteStride((16 - j)*4);
-    dmaSetupWrite(HORIZ, 1, 16*me(), j);
-    dmaStartWrite(dst);
+    Float::Ptr dst_read = dst;
 
-    dst.inc();
+    prefetch(tmp, dst_read, pre_label);
+    tmp += src;
   } else {
-    Float::Ptr local_dst = dst;
+    comment("float pre_write no add");
+    tmp = src;
+  }
 
-    Where (index() >= j)
-      local_dst = devnull();
-    End
+  if (op) op(tmp);
 
-    pre_write(local_dst, src, add_result);
-  }
+  store_masked(dst, tmp, j);
+  dst.inc();
 }
 
 }  // namespace kernels
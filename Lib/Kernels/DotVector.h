@@ -1,5 +1,6 @@
 #ifndef _V3DLIB_KERNELS_DOTVECTOR_H_
 #define _V3DLIB_KERNELS_DOTVECTOR_H_
+#include <functional>
 #include "V3DLib.h"
 
 namespace kernels {
@@ -33,8 +34,13 @@ private:
   std::vector<Float> elements;
 };
 
-void pre_write(Float::Ptr &dst, Float &src, bool add_result);
-void pre_write(Float::Ptr &dst, Float &src, bool add_result, Int const &j);
+/**
+ * Operation on a result vector, performed just before it is written to main memory
+ */
+using PreWriteOp = std::function<void(Float &result)>;
+
+void pre_write(Float::Ptr &dst, Float &src, bool add_result, PreWriteOp const &op = nullptr);
+void pre_write(Float::Ptr &dst, Float &src, bool add_result, Int const &j, PreWriteOp const &op = nullptr);
 
 }  // namespace kernels
 
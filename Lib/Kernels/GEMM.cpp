@@ -0,0 +1,302 @@
+#include "GEMM.h"
+#include "Support/basics.h"
+
+namespace kernels {
+
+////////////////////////////////////////////////////////////////////////////////
+// struct Epilogue
+////////////////////////////////////////////////////////////////////////////////
+
+bool Epilogue::empty() const {
+  return scale == 1.0f && !bias && activation == NONE && !custom;
+}
+
+
+/**
+ * Apply the epilogue to a block of 16 result values.
+ *
+ * @param bias_ptr  pointer to start of bias array. Only used if `bias` is set
+ * @param col       column index of the first value in `result`
+ */
+void Epilogue::apply(Float &result, Float::Ptr const &bias_ptr, Int const &col) const {
+  comment("GEMM epilogue");
+
+  if (scale != 1.0f) {
+    result = result*scale;
+  }
+
+  if (bias) {
+    Float tmp = 0;
+    gather(bias_ptr + col);
+    receive(tmp);
+    result = result + tmp;
+  }
+
+  switch (activation) {
+    case NONE:
+      break;
+
+    case RELU:
+      Where (result < 0.0f)
+        result = 0.0f;
+      End
+      break;
+
+    case CLAMP:
+      assert(clamp_min <= clamp_max);
+      Where (result < clamp_min)
+        result = clamp_min;
+      End
+      Where (result > clamp_max)
+        result = clamp_max;
+      End
+      break;
+  }
+
+  if (custom) {
+    custom(result, col);
+  }
+}
+
+
+/**
+ * Scalar version of the epilogue, for checking results.
+ *
+ * The custom step is not performed here.
+ */
+float Epilogue::apply(float result, float const *bias_ptr, int col) const {
+  result = scale*result;
+
+  if (bias) {
+    assert(bias_ptr != nullptr);
+    result += bias_ptr[col];
+  }
+
+  switch (activation) {
+    case NONE:
+      break;
+
+    case RELU:
+      if (result < 0.0f) result = 0.0f;
+      break;
+
+    case CLAMP:
+      if (result < clamp_min) result = clamp_min;
+      if (result > clamp_max) result = clamp_max;
+      break;
+  }
+
+  return result;
+}
+
+
+namespace {
+
+Epilogue epilogue;
+
+void gemm_intern(Float::Ptr dst, Float::Ptr a, Float::Ptr b, Float::Ptr const &bias) {
+  auto &settings = get_matrix_settings();
+
+  EpilogueFunc<Float> f;
+  if (!epilogue.empty()) {
+    f = [&bias] (Float &result, Int const &col) {
+      epilogue.apply(result, bias, col);
+    };
+  }
+
+  blockmatrix_loop<Float::Ptr, Float::Ptr, Float, DotVector>(dst, a,
+    [&settings, &b] (DotVector &dot_vector, Int &b_index, Float &dst) {
+      Float::Ptr b_local = b + b_index*settings.inner;
+      dot_vector.dot_product(b_local, dst);
+    },
+    f
+  );
+}
+
+}  // anon namespace
+
+
+Epilogue &get_gemm_epilogue() { return epilogue; }
+
+
+/**
+ * Multiply two matrixes and apply the epilogue to the result.
+ *
+ * Input matrix `b` needs to be in transposed form before usage.
+ */
+void gemm(Float::Ptr dst, Float::Ptr a, Float::Ptr b, Float::Ptr bias) {
+  gemm_intern(dst, a, b, bias);
+}
+
+
+/**
+ * Block matrix version of `gemm()`.
+ *
+ * See `matrix_mult_block()` for details.
+ */
+void gemm_block(Float::Ptr in_dst, Float::Ptr in_a, Float::Ptr in_b, Float::Ptr bias, Int in_offset) {
+  create_block_kernel(in_offset, [&] (Int const &offset) {
+     gemm_intern(in_dst, in_a + offset, in_b + offset, bias);
+  });
+}
+
+
+/**
+ * Do `gemm()` over a batch of matrices.
+ *
+ * The QPUs each handle complete matrices.
+ */
+void gemm_batched(Float::Ptr dst, Float::Ptr a, Float::Ptr b, Float::Ptr bias, Int batch_size) {
+  auto &settings = get_matrix_settings();
+  assert(settings.batched);
+
+  int const a_size   = settings.rows*settings.inner;
+  int const b_size   = settings.columns*settings.inner;
+  int const dst_size = settings.rows*settings.cols_result();
+
+  For (Int n = me(), n < batch_size, n += numQPUs())
+    gemm_intern(dst + n*dst_size, a + n*a_size, b + n*b_size, bias);
+  End
+}
+
+}  // namespace kernels
+
+
+namespace V3DLib {
+
+///////////////////////////////////////////////////////////////////////////////
+// Class GEMM
+///////////////////////////////////////////////////////////////////////////////
+
+GEMM::GEMM(Float::Array2D &a, Float::Array2D &b) : m_a(a), m_b(b) {
+  auto &settings = kernels::get_matrix_settings();
+  settings.set(m_a.rows(), m_a.columns(), m_b.rows());
+}
+
+
+GEMM &GEMM::epilogue(kernels::Epilogue const &val) {
+  assertq(!compiled(), "GEMM: epilogue must be set before compiling");
+  bool has_bias = m_epilogue.bias;
+  m_epilogue = val;
+  m_epilogue.bias = m_epilogue.bias || has_bias;
+  return *this;
+}
+
+
+/**
+ * Set the bias array to use in the epilogue.
+ *
+ * The bias array needs at least `cols_result()` elements.
+ */
+GEMM &GEMM::bias(Float::Array &val) {
+  assertq(!compiled(), "GEMM: bias must be set before compiling");
+  assertq((int) val.size() >= kernels::get_matrix_settings().cols_result(), "GEMM: bias array too small");
+  m_bias = &val;
+  m_epilogue.bias = true;
+  return *this;
+}
+
+
+void GEMM::load(BlockKernelPtr &k, int offset) {
+  if (m_epilogue.bias) {
+    assertq(m_bias != nullptr, "GEMM: bias enabled in epilogue but no bias array set");
+    k->load(&Parent::result(), &m_a, &m_b, m_bias, offset);
+  } else {
+    k->load(&Parent::result(), &m_a, &m_b, &m_a, offset);  // bias param not used, pass in anything valid
+  }
+}
+
+
+void GEMM::init_block(CallType call_type) {
+  auto &settings = kernels::get_matrix_settings();
+  settings.use_multi_kernel_calls = Parent::use_multi_kernel_calls(call_type);
+  kernels::get_gemm_epilogue() = m_epilogue;
+  Parent::init_block_kernels(kernels::gemm_block, call_type);
+  kernels::get_gemm_epilogue() = kernels::Epilogue();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class BatchedGEMM
+///////////////////////////////////////////////////////////////////////////////
+
+BatchedGEMM::BatchedGEMM(int rows, int inner, int columns) :
+  m_rows(rows),
+  m_inner(inner),
+  m_columns(columns)
+{
+  init_settings();
+}
+
+
+BatchedGEMM &BatchedGEMM::epilogue(kernels::Epilogue const &val) {
+  assertq(!m_k, "BatchedGEMM: epilogue must be set before compiling");
+  bool has_bias = m_epilogue.bias;
+  m_epilogue = val;
+  m_epilogue.bias = m_epilogue.bias || has_bias;
+  return *this;
+}
+
+
+/**
+ * Set the bias array to use in the epilogue.
+ *
+ * The bias array needs at least `cols_result()` elements.
+ */
+BatchedGEMM &BatchedGEMM::bias(Float::Array &val) {
+  assertq(!m_k, "BatchedGEMM: bias must be set before compiling");
+  assertq((int) val.size() >= cols_result(), "BatchedGEMM: bias array too small");
+  m_bias = &val;
+  m_epilogue.bias = true;
+  return *this;
+}
+
+
+int BatchedGEMM::cols_result() const {
+  init_settings();
+  return kernels::get_matrix_settings().cols_result();
+}
+
+
+void BatchedGEMM::init_settings() const {
+  auto &settings = kernels::get_matrix_settings();
+  settings.set(m_rows, m_inner, m_columns);
+  settings.batched = true;
+}
+
+
+void BatchedGEMM::compile() {
+  if (m_k) return;
+
+  init_settings();
+  kernels::get_gemm_epilogue() = m_epilogue;
+  m_k.reset(new KernelType(V3DLib::compile(kernels::gemm_batched)));
+  kernels::get_gemm_epilogue() = kernels::Epilogue();
+}
+
+
+void BatchedGEMM::call(Float::Array &a, Float::Array &b, Float::Array &result, int batch_size, CallType call_type) {
+  assert(batch_size > 0);
+  assertq((int) a.size() >= batch_size*m_rows*m_inner, "BatchedGEMM: array a too small for batch");
+  assertq((int) b.size() >= batch_size*m_columns*m_inner, "BatchedGEMM: array b too small for batch");
+  assertq((int) result.size() >= batch_size*m_rows*cols_result(), "BatchedGEMM: result array too small for batch");
+
+  compile();
+  assertq(!has_errors(), "Can not run BatchedGEMM::call(), there are errors");
+  m_k->setNumQPUs(m_num_qpus);
+
+  if (m_epilogue.bias) {
+    assertq(m_bias != nullptr, "BatchedGEMM: bias enabled in epilogue but no bias array set");
+    m_k->load(&result, &a, &b, m_bias, batch_size);
+  } else {
+    m_k->load(&result, &a, &b, &a, batch_size);  // bias param not used, pass in anything valid
+  }
+
+  switch(call_type) {
+    case CALL:      m_k->call();      break;
+    case INTERPRET: m_k->interpret(); break;
+    case EMULATE:   m_k->emu();       break;
+  }
+}
+
+}  // namespace V3DLib
@@ -0,0 +1,135 @@
+#ifndef _V3DLIB_KERNELS_GEMM_H_
+#define _V3DLIB_KERNELS_GEMM_H_
+#include "Matrix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernel code definitions for GEMM
+////////////////////////////////////////////////////////////////////////////////
+
+namespace kernels {
+
+using namespace V3DLib;
+
+/**
+ * Post-processing of matrix multiplication results, done before the results are stored.
+ *
+ * This avoids separate kernels and extra passes over memory for the usual
+ * operations on the output of a neural network layer.
+ *
+ * The steps are performed in the order of the fields here:
+ *
+ *     result = custom(activation(scale*result + bias[col]))
+ */
+struct Epilogue {
+  enum Activation {
+    NONE,
+    RELU,
+    CLAMP
+  };
+
+  float scale           = 1.0f;   // Multiply result with this value
+  bool  bias            = false;  // If true, add the bias value for the column of the result
+  Activation activation = NONE;
+  float clamp_min       = 0.0f;   // Range for activation CLAMP
+  float clamp_max       = 1.0f;
+  EpilogueFunc<Float> custom;     // Optional user-defined step, done last
+
+  bool empty() const;
+  void apply(Float &result, Float::Ptr const &bias_ptr, Int const &col) const;
+  float apply(float result, float const *bias_ptr, int col) const;
+};
+
+
+Epilogue &get_gemm_epilogue();
+
+void gemm(Float::Ptr dst, Float::Ptr a, Float::Ptr b, Float::Ptr bias);
+void gemm_block(Float::Ptr in_dst, Float::Ptr in_a, Float::Ptr in_b, Float::Ptr bias, Int in_offset);
+void gemm_batched(Float::Ptr dst, Float::Ptr a, Float::Ptr b, Float::Ptr bias, Int batch_size);
+
+}  // namespace kernels
+
+
+namespace V3DLib {
+
+///////////////////////////////////////////////////////////////////////////////
+// Class GEMM
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Matrix multiplication with epilogue
+ *
+ * Works like class `Matrix` for Float, but applies the epilogue to the results
+ * before they are stored.
+ *
+ * As with `Matrix`, input matrix `b` needs to be in transposed form.
+ * The epilogue must be set before the kernel is compiled.
+ */
+class GEMM : public BlockMatrix<Float::Array2D, Float::Ptr, Kernel<Float::Ptr, Float::Ptr, Float::Ptr, Float::Ptr, Int>> {
+  using Parent = BlockMatrix<Float::Array2D, Float::Ptr, Kernel<Float::Ptr, Float::Ptr, Float::Ptr, Float::Ptr, Int>>;
+
+public:
+  GEMM(Float::Array2D &a, Float::Array2D &b);
+
+  GEMM &epilogue(kernels::Epilogue const &val);
+  GEMM &bias(Float::Array &val);
+
+  void load(BlockKernelPtr &k, int offset) override;
+  void init_block(CallType call_type) override;
+
+private:
+  Float::Array2D &m_a;
+  Float::Array2D &m_b;
+  Float::Array *m_bias = nullptr;
+  kernels::Epilogue m_epilogue;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class BatchedGEMM
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Matrix multiplication with epilogue over a batch of small matrices of the same dimensions
+ *
+ * The matrices of a batch are stored consecutively in a single array:
+ *
+ *   - a:      `batch_size` matrices of `rows x inner`
+ *   - b:      `batch_size` matrices of `columns x inner`, i.e. transposed
+ *   - result: `batch_size` matrices of `rows x cols_result()`
+ *
+ * The bias, if any, is shared by all matrices of the batch.
+ *
+ * Every QPU handles complete matrices of the batch. This avoids all synchronization,
+ * and is more efficient than distributing the rows of small matrices.
+ */
+class BatchedGEMM {
+public:
+  using KernelType = Kernel<Float::Ptr, Float::Ptr, Float::Ptr, Float::Ptr, Int>;
+
+  BatchedGEMM(int rows, int inner, int columns);
+
+  BatchedGEMM &epilogue(kernels::Epilogue const &val);
+  BatchedGEMM &bias(Float::Array &val);
+  void setNumQPUs(int val) { m_num_qpus = val; }
+  int cols_result() const;
+  void compile();
+  bool has_errors() const { return m_k && m_k->has_errors(); }
+  KernelType &kernel() { assert(m_k); return *m_k; }
+
+  void call(Float::Array &a, Float::Array &b, Float::Array &result, int batch_size, CallType call_type = CALL);
+
+private:
+  int m_rows;
+  int m_inner;
+  int m_columns;
+  int m_num_qpus = 1;
+  Float::Array *m_bias = nullptr;
+  kernels::Epilogue m_epilogue;
+  std::unique_ptr<KernelType> m_k;
+
+  void init_settings() const;
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_KERNELS_GEMM_H_
@@ -0,0 +1,53 @@
+#include "LayoutPtr.h"
+#include "Source/Lang.h"
+
+namespace V3DLib {
+namespace {
+
+int const TILE_SHIFT = 4;   // log2(Layout2D::TILE)
+
+/**
+ * Move the lower 16 bits of the value to the even bit positions
+ */
+IntExpr spread(IntExpr in_x) {
+  Int x = in_x;
+  x = (x | (x << 8)) & 0x00FF00FF;
+  x = (x | (x << 4)) & 0x0F0F0F0F;
+  x = (x | (x << 2)) & 0x33333333;
+  x = (x | (x << 1)) & 0x55555555;
+  return x;
+}
+
+}  // anon namespace
+
+
+/**
+ * Calculate the index of an element in a 2D array with the given layout.
+ *
+ * Same calculation as `Layout2D::offset()` on the host.
+ */
+IntExpr layout_offset(Layout2D::Type type, IntExpr pitch, IntExpr row, IntExpr col) {
+  static_assert(Layout2D::TILE == (1 << TILE_SHIFT), "Tile size must match shift");
+
+  switch (type) {
+    case Layout2D::ROW_MAJOR:
+    case Layout2D::PADDED:
+      return row*pitch + col;
+
+    case Layout2D::BLOCKED: {
+      Int in_tile = ((row & 15) << TILE_SHIFT) + (col & 15);
+      return ((row >> TILE_SHIFT)*pitch << TILE_SHIFT) + ((col >> TILE_SHIFT) << (2*TILE_SHIFT)) + in_tile;
+    }
+
+    case Layout2D::MORTON: {
+      Int in_tile = ((row & 15) << TILE_SHIFT) + (col & 15);
+      Int tile = (spread(row >> TILE_SHIFT) << 1) | spread(col >> TILE_SHIFT);
+      return (tile << (2*TILE_SHIFT)) + in_tile;
+    }
+  }
+
+  assert(false);
+  return 0;
+}
+
+}  // namespace V3DLib
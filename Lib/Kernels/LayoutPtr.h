@@ -0,0 +1,52 @@
+#ifndef _V3DLIB_KERNELS_LAYOUTPTR_H_
+#define _V3DLIB_KERNELS_LAYOUTPTR_H_
+#include "Common/Layout2D.h"
+#include "Source/Int.h"
+#include "Source/Float.h"
+
+namespace V3DLib {
+
+IntExpr layout_offset(Layout2D::Type type, IntExpr pitch, IntExpr row, IntExpr col);
+
+
+/**
+ * Address elements of a `Shared2DArray` with a given layout in a kernel
+ *
+ * The layout type is fixed when the kernel is compiled, the pitch is passed
+ * as a parameter, e.g.:
+ *
+ *    void kernel(Float::Ptr a, Int pitch, ...) {
+ *      LayoutPtr<Float> p(a, Layout2D::BLOCKED, pitch);
+ *      Float x = *p.at(row, col);
+ *      ...
+ *
+ *    Float::Array2D a(rows, columns, Layout2D::BLOCKED);
+ *    k.load(&a, a.pitch(), ...);
+ *
+ * Because pointer parameters are already offset by `index()`, `at()` returns
+ * the vector of 16 elements starting at column `col`, which should be a multiple of 16.
+ * For a separate column per lane, use `lane_at()`.
+ */
+template<typename T>
+class LayoutPtr {
+public:
+  LayoutPtr(typename T::Ptr const &base, Layout2D::Type type, IntExpr pitch) :
+    m_base(base),
+    m_type(type),
+    m_pitch(pitch)
+  {}
+
+  IntExpr offset(IntExpr row, IntExpr col) const { return layout_offset(m_type, m_pitch, row, col); }
+
+  PtrExpr<T> at(IntExpr row, IntExpr col) const { return m_base + offset(row, col); }
+  PtrExpr<T> lane_at(IntExpr row, IntExpr col) const { return m_base + (offset(row, col) - index()); }
+
+private:
+  typename T::Ptr m_base;
+  Layout2D::Type  m_type;
+  Int             m_pitch;
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_KERNELS_LAYOUTPTR_H_
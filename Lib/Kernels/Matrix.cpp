@@ -22,6 +22,7 @@ void matrix_settings::set(int in_rows, int in_inner, int in_columns) {
   columns       = in_columns;
   add_result    = false;       // override after this call to explicitly set
   use_multi_kernel_calls = false;
+  batched       = false;
 
   m_num_blocks  = -1;
   block_rowsize = -1;
@@ -51,9 +52,12 @@ int matrix_settings::width() const {
 
 
 /**
- * The column size of the result array needs to be a multiple of 16, i.e. vector size.
+ * The column size of the result array.
+ *
+ * This used to be padded to a multiple of 16. The final partial vector of a row
+ * is now written with a masked store, so no padding is needed.
  */
-int matrix_settings::cols_result() const { return adjust_dimension(columns, 16); }
+int matrix_settings::cols_result() const { return columns; }
 
 
 int matrix_settings::num_blocks() const {
@@ -72,6 +76,17 @@ void matrix_settings::num_blocks(int val) {
 }
 
 
+/**
+ * Determine if the block currently being compiled is the last one for the result.
+ *
+ * Only then are the values in the result final.
+ */
+bool matrix_settings::last_block() const {
+  if (m_num_blocks == -1 || m_num_blocks == 1) return true;
+  return add_result;  // Only the first block of two does not add
+}
+
+
 std::string matrix_settings::dump() const {
   std::string msg;
 
@@ -84,16 +99,6 @@ std::string matrix_settings::dump() const {
 }
 
 
-int matrix_settings::adjust_dimension(int val, int multiple) const {
-  assert(val > 0);
-  if (val % multiple != 0) {
-    val  = multiple*(val/multiple + 1);
-  }
-
-  return val;
-}
-
-
 using namespace V3DLib;
 
 namespace {
@@ -175,6 +180,72 @@ void matrix_mult_scalar(int N, float *dst, float *a, float *b) {
 }
 
 
+/**
+ * Transpose a 2D array
+ *
+ * The array is handled in tiles of 16x16 values. A tile is loaded into 16 vectors,
+ * transposed within the registers and written out row by row. The tile rows are distributed
+ * over the QPUs.
+ *
+ * Within the registers, the tile is transposed in four steps. Each step swaps the
+ * off-diagonal blocks of 8, 4, 2 and 1 values between pairs of vectors,
+ * using `rotate()` and a lane selection.
+ *
+ * `rows` and `columns` can be any value.
+ * Lanes beyond the last column are loaded from the last column, and rows beyond the last row
+ * from the last row. Their results are not written.
+ */
+void transpose(Float::Ptr dst, Float::Ptr src, Int rows, Int columns) {
+  int const N = 16;
+
+  For (Int r0 = N*me(), r0 < rows, r0 += N*numQPUs())
+    For (Int c0 = 0, c0 < columns, c0 += N)
+      Int lane_col = c0 + index();
+      Where (lane_col >= columns)
+        lane_col = columns - 1;
+      End
+
+      // Pointers are offset by index() already
+      Float::Ptr p = src + (r0*columns + lane_col - index());
+
+      std::vector<Float> v;
+      for (int r = 0; r < N; r++) {
+        v.push_back(*p);
+
+        If (r0 + r + 1 < rows)
+          p += columns;
+        End
+      }
+
+      for (int b = N/2; b >= 1; b /= 2) {
+        for (int r = 0; r < N; r++) {
+          if ((r & b) != 0) continue;
+
+          Float lo = rotate(v[r], N - b);  // lane i gets v[r][i + b]
+          Float hi = rotate(v[r + b], b);  // lane i gets v[r + b][i - b]
+
+          Where ((index() & b) != 0)
+            v[r] = hi;
+          End
+
+          Where ((index() & b) == 0)
+            v[r + b] = lo;
+          End
+        }
+      }
+
+      Float::Ptr q = dst + (c0*rows + r0);
+      for (int c = 0; c < N; c++) {
+        If (c0 + c < columns)
+          store_masked(q, v[c], rows - r0);
+        End
+        q += rows;
+      }
+    End
+  End
+}
+
+
 void create_block_kernel(Int const &in_offset, std::function<void (Int const &offset)> f) {
   auto &settings = get_matrix_settings();
 
@@ -198,3 +269,61 @@ void create_block_kernel(Int const &in_offset, std::function<void (Int const &of
 }
 
 }  // namespace kernels
+
+
+namespace V3DLib {
+
+///////////////////////////////////////////////////////////////////////////////
+// Class Transpose
+///////////////////////////////////////////////////////////////////////////////
+
+bool Transpose::has_errors() const {
+  return m_k && m_k->has_errors();
+}
+
+
+void Transpose::compile() {
+  if (m_k) return;
+  m_k.reset(new KernelType(V3DLib::compile(kernels::transpose)));
+}
+
+
+/**
+ * Transpose `src` into `dst`
+ *
+ * `dst` is allocated if not already done so.
+ */
+void Transpose::call(Float::Array2D &dst, Float::Array2D &src, CallType call_type) {
+  assert(src.allocated());
+
+  if (!dst.allocated()) {
+    dst.alloc(src.columns(), src.rows());
+  } else {
+    assertq(dst.rows() == src.columns() && dst.columns() == src.rows(),
+      "Transpose: destination array must have the transposed dimensions of the source array");
+  }
+
+  compile();
+  assertq(!has_errors(), "Transpose: kernel has errors");
+
+  m_k->setNumQPUs(m_num_qpus);
+  m_k->load(&dst, &src, src.rows(), src.columns());
+
+  switch(call_type) {
+    case CALL:      m_k->call();      break;
+    case INTERPRET: m_k->interpret(); break;
+    case EMULATE:   m_k->emu();       break;
+  }
+}
+
+
+void Transpose::call(Complex::Array2D &dst, Complex::Array2D &src, CallType call_type) {
+  if (!dst.allocated()) {
+    dst.alloc(src.columns(), src.rows());
+  }
+
+  call(dst.re(), src.re(), call_type);
+  call(dst.im(), src.im(), call_type);
+}
+
+}  // namespace V3DLib
@@ -21,6 +21,7 @@ struct matrix_settings {
   int columns;                                // Num columns of the result array
   bool add_result  = false;
   bool use_multi_kernel_calls = false;
+  bool batched     = false;                     // If true, every QPU handles complete matrices
 
   void set(int in_rows, int in_inner, int in_columns);
 
@@ -30,6 +31,7 @@ struct matrix_settings {
   int stride() const { return rows; }             //< Number of cells till next row
   int num_blocks() const;
   void num_blocks(int val);
+  bool last_block() const;
 
   std::string dump() const;
 
@@ -37,7 +39,6 @@ private:
   int m_num_blocks  = -1;
   int block_rowsize = -1;                         // Row size for the (block array) multiplication
 
-  int adjust_dimension(int val, int multiple) const;
   void set_blockrowsize(int in_block_rowsize);
 };
 
@@ -45,6 +46,15 @@ private:
 matrix_settings &get_matrix_settings();
 
 
+/**
+ * Operation on a block of 16 result values, performed just before they are written to main memory.
+ *
+ * `col` is the column index of the first value in the block.
+ */
+template<typename T>
+using EpilogueFunc = std::function<void(T &result, Int const &col)>;
+
+
 /**
  * Pre: settings initialized
  *
@@ -56,9 +66,6 @@ void init_result_array(Array2D &result) {
   auto &settings = get_matrix_settings();
 
   if (!result.allocated()) {
-    // Result array requires column size which is a multiple of 16
-    // Ensure enough padding for result so that size is multiple of 16
-    // It may become too big but never mind
     result.alloc(settings.rows, settings.cols_result());
   } else {
     if (result.rows() != settings.rows) {
@@ -95,6 +102,10 @@ void init_result_array(Array2D &result) {
  * - unroll the internal loop (tried it but does not help, discarded)
  * - Use all QPU's
  * - All QPU's iterate over b together -> increase cache hits (when iterating over rows)
+ *
+ * If passed, `epilogue` is applied to the final values of the result, before they are written.
+ * With multiple blocks, this happens in the last block only.
+ * Only supported for Float.
  */
 template<
  typename DstPtr,
@@ -105,10 +116,44 @@ template<
 void blockmatrix_loop(
   DstPtr dst,
   Ptr a,
-  std::function<void(DotVecType &dot_vector, Int &, T &)> core
+  std::function<void(DotVecType &dot_vector, Int &, T &)> core,
+  EpilogueFunc<T> epilogue = nullptr
 ) {
   auto &settings = get_matrix_settings();
   assert(settings.inner > 0 && (settings.inner % 16 == 0));
+  static_assert(std::is_same<T, Float>::value || std::is_same<T, Complex>::value, "Unexpected result type");
+
+  if (!settings.last_block()) {
+    epilogue = nullptr;  // Values are not final yet
+  }
+
+  // Write the result values for the columns starting at col
+  auto write = [&settings, &epilogue] (DstPtr &dst, T &result, IntExpr col, Int const *j) {
+    if constexpr (std::is_same<T, Float>::value) {
+      PreWriteOp op;
+
+      if (epilogue) {
+        op = [&epilogue, col] (Float &val) {
+          Int col_var = col;
+          epilogue(val, col_var);
+        };
+      }
+
+      if (j == nullptr) {
+        pre_write(dst, result, settings.add_result, op);
+      } else {
+        pre_write(dst, result, settings.add_result, *j, op);
+      }
+    } else {
+      assertq(!epilogue, "blockmatrix_loop(): epilogue not supported for complex values");
+
+      if (j == nullptr) {
+        pre_write(dst, result, settings.add_result);
+      } else {
+        pre_write(dst, result, settings.add_result, *j);
+      }
+    }
+  };
 
   //
   // Initialize loops
@@ -120,7 +165,9 @@ void blockmatrix_loop(
   Int a_inc = 1;
   Int b_init = 0; 
   Int b_count = settings.columns;
-  if (settings.rows >= settings.columns) {
+  if (settings.batched) {
+    // Matrices are distributed over the QPUs by the caller, nothing to do here
+  } else if (settings.rows >= settings.columns) {
     //debug("blockmatrix_loop iterating over rows");
     a_init = me();
     a_inc  = numQPUs();
@@ -163,12 +210,12 @@ void blockmatrix_loop(
       bit_count = (bit_count + 1) & 0xf;
 
       If (bit_count == 0)
-        pre_write(dst_local, result, settings.add_result);
+        write(dst_local, result, b_index - 15, nullptr);
       End
     End
 
     If (bit_count != 0)
-      pre_write(dst_local, result, settings.add_result, bit_count);
+      write(dst_local, result, b_count - bit_count, &bit_count);
     End
   End
 }
@@ -202,6 +249,7 @@ void matrix_mult(Ptr dst, Ptr a, Ptr b) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void matrix_mult_scalar(int N, float *dst, float *a, float *b);
+void transpose(Float::Ptr dst, Float::Ptr src, Int rows, Int columns);
 
 
 /**
@@ -357,6 +405,31 @@ enum CallType {
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Class Transpose
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Transpose 2D arrays on the QPUs
+ *
+ * The arrays can have any dimensions.
+ */
+class Transpose {
+public:
+  using KernelType = Kernel<Float::Ptr, Float::Ptr, Int, Int>;
+
+  void setNumQPUs(int val) { m_num_qpus = val; }
+  bool has_errors() const;
+  void compile();
+  void call(Float::Array2D &dst, Float::Array2D &src, CallType call_type = CALL);
+  void call(Complex::Array2D &dst, Complex::Array2D &src, CallType call_type = CALL);
+
+private:
+  int m_num_qpus = 1;
+  std::unique_ptr<KernelType> m_k;
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Class Matrix
 ///////////////////////////////////////////////////////////////////////////////
@@ -395,6 +468,7 @@ public:
   BlockKernelType &kernel() { return *m_k; }
   void compile()  { init_block(CALL); }
   bool has_errors() const { return (m_k_first && m_k_first->has_errors()) || m_k->has_errors(); }
+  bool compiled() const { return m_k_first.get() != nullptr; }
 
   /**
    * If set to true, force multiple kernel calls if possible.
@@ -450,6 +524,7 @@ public:
    * Further splitting is possible, but this serves our purposes for now.
    */
   void call(CallType call_type = CALL) {
+    pre_call(call_type);
     init_block(call_type);
     assertq(!has_errors(), "Can not run Matrix::mult(), there are errors");
     assert(m_k.get() != nullptr);
@@ -520,6 +595,7 @@ protected:
 
   virtual void init_block(CallType call_type) = 0;
   virtual void load(BlockKernelPtr &k, int offset) = 0;
+  virtual void pre_call(CallType call_type) {}
 
 
   bool use_multi_kernel_calls(CallType call_type) const {
@@ -636,15 +712,36 @@ template<
 >
 class Matrix : public Parent {
 public:
-  Matrix(Array2D &a, Array2D &b) : m_a(a), m_b(b) {
+  /**
+   * @param b_transposed  if true, `b` is passed in transposed form.
+   *                      Otherwise, it is transposed on the QPUs before every multiplication.
+   */
+  Matrix(Array2D &a, Array2D &b, bool b_transposed = true) : m_a(a), m_b(b), m_b_transposed(b_transposed) {
     auto &settings = kernels::get_matrix_settings();
-    settings.set(m_a.rows(), m_a.columns(), m_b.rows());
+
+    if (b_transposed) {
+      settings.set(m_a.rows(), m_a.columns(), m_b.rows());
+    } else {
+      assertq(m_a.columns() == m_b.rows(), "Matrix: columns of a must be equal to rows of b");
+      settings.set(m_a.rows(), m_a.columns(), m_b.columns());
+    }
   }
 
   void load(std::unique_ptr<BlockKernelType> &k, int offset) override {
-    k->load(&Parent::result(), &m_a, &m_b, offset);
+    if (m_b_transposed) {
+      k->load(&Parent::result(), &m_a, &m_b, offset);
+    } else {
+      k->load(&Parent::result(), &m_a, &m_b_t, offset);
+    }
   } 
 
+  void pre_call(CallType call_type) override {
+    if (m_b_transposed) return;
+
+    m_transpose.setNumQPUs(Parent::numQPUs());
+    m_transpose.call(m_b_t, m_b, call_type);
+  }
+
   void init_block(CallType call_type) override {
     auto &settings = kernels::get_matrix_settings();
     settings.use_multi_kernel_calls = Parent::use_multi_kernel_calls(call_type); 
@@ -654,6 +751,9 @@ public:
 private:
   Array2D &m_a;
   Array2D &m_b;
+  bool      m_b_transposed;
+  Array2D   m_b_t;        // Transposed b, if b is not passed transposed
+  Transpose m_transpose;
 };
 
 
@@ -0,0 +1,357 @@
+#include "SpMV.h"
+#include <algorithm>
+#include "Support/basics.h"
+
+namespace kernels {
+
+namespace {
+
+/**
+ * Load the value at index `i` of an array into all vector elements
+ */
+void load_scalar(Int::Ptr const &src, IntExpr i, Int &dst) {
+  gather(src + (i - index()));
+  receive(dst);
+}
+
+
+/**
+ * Get the range of work items for the current QPU from the partition array
+ */
+void get_partition(Int::Ptr const &partition, Int &start, Int &end) {
+  load_scalar(partition, me(), start);
+  load_scalar(partition, me() + 1, end);
+}
+
+}  // anon namespace
+
+
+/**
+ * Sparse matrix-vector multiplication `y = A*x` for A in CSR format.
+ *
+ * Every lane handles a row. Lanes with shorter rows than the longest in
+ * the row group idle on the final iterations.
+ *
+ * @param partition  start row per QPU, with the end row as final element.
+ *                   All values except the end value must be multiples of 16.
+ */
+void spmv_csr(Float::Ptr y, Float::Ptr x, Int::Ptr row_ptr, Int::Ptr col_idx, Float::Ptr values,
+              Int::Ptr partition, Int num_rows) {
+  Int start, end;
+  get_partition(partition, start, end);
+
+  For (Int row_base = start, row_base < end, row_base += 16)
+    Int row = row_base + index();
+    Int r = min(row, num_rows - 1);  // Prevent reading past end of row_ptr
+
+    Int first, last;
+    load_scalar(row_ptr, r, first);
+    load_scalar(row_ptr, r + 1, last);
+
+    Where (row >= num_rows)
+      last = first;
+    End
+
+    Int len = last - first;
+    Float sum = 0.0f;
+
+    For (Int k = 0, any(k < len), k++)
+      Int i = first + k;
+      Where (k >= len)
+        i = 0;  // Prevent reading past end of values
+      End
+
+      Int col;
+      Float val;
+      gather(col_idx + (i - index()));
+      gather(values + (i - index()));
+      receive(col);
+      receive(val);
+
+      Float x_val;
+      gather(x + (col - index()));
+      receive(x_val);
+
+      Where (k < len)
+        sum += val*x_val;
+      End
+    End
+
+    Float::Ptr dst = y + row_base;
+    *dst = sum;
+  End
+}
+
+
+/**
+ * Sparse matrix-vector multiplication `y = A*x` for A in SELL-16 format.
+ *
+ * Every lane handles a row of the slice. The column indexes and values
+ * are read with vector loads; only the elements of x are gathered.
+ *
+ * @param partition  start slice per QPU, with the end slice as final element.
+ */
+void spmv_sell(Float::Ptr y, Float::Ptr x, Int::Ptr slice_ptr, Int::Ptr col_idx, Float::Ptr values,
+               Int::Ptr partition) {
+  Int start, end;
+  get_partition(partition, start, end);
+
+  For (Int s = start, s < end, s++)
+    Int first, last;
+    load_scalar(slice_ptr, s, first);
+    load_scalar(slice_ptr, s + 1, last);
+
+    Int::Ptr cols = col_idx + first;
+    Float::Ptr vals = values + first;
+    Float sum = 0.0f;
+
+    For (Int k = first, k < last, k += 16)
+      Int col = *cols;
+      Float val = *vals;
+
+      Float x_val;
+      gather(x + (col - index()));
+      receive(x_val);
+      sum += val*x_val;
+
+      cols += 16;
+      vals += 16;
+    End
+
+    Float::Ptr dst = y + (s << 4);
+    *dst = sum;
+  End
+}
+
+}  // namespace kernels
+
+
+namespace V3DLib {
+namespace {
+
+/**
+ * Distribute work items over the QPUs, so that every QPU gets about the same load.
+ *
+ * @param load  load per work item
+ * @param dst   output, index of first work item per QPU, with the number of items as final element.
+ *              Indexes are multiplied by `unit`.
+ */
+void set_partition(std::vector<int> const &load, int num_qpus, int unit, Int::Array &dst) {
+  assert(num_qpus > 0 && num_qpus <= Platform::max_qpus());
+
+  if (dst.empty()) {
+    dst.alloc(Platform::max_qpus() + 1);
+  }
+
+  long long total = 0;
+  for (auto l : load) total += l;
+
+  int item = 0;
+  long long acc = 0;
+  dst[0] = 0;
+
+  for (int q = 1; q < num_qpus; q++) {
+    long long target = (total*q)/num_qpus;
+
+    while (item < (int) load.size() && acc + load[item]/2 < target) {
+      acc += load[item];
+      item++;
+    }
+
+    dst[q] = unit*item;
+  }
+
+  dst[num_qpus] = unit*((int) load.size());
+}
+
+
+void check_vectors(int columns, int rows_result, Float::Array &x, Float::Array &y) {
+  assertq((int) x.size() >= columns, "SpMV: vector x too small");
+  assertq((int) y.size() >= rows_result, "SpMV: result vector y too small");
+}
+
+
+template<typename KernelType>
+void run(KernelType &k, CallType call_type) {
+  switch(call_type) {
+    case CALL:      k.call();      break;
+    case INTERPRET: k.interpret(); break;
+    case EMULATE:   k.emu();       break;
+  }
+}
+
+}  // anon namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class CSRMatrix
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @param entries  Non-zero values of the matrix, in any order
+ */
+CSRMatrix::CSRMatrix(int rows, int columns, std::vector<SparseEntry> const &entries) :
+  m_rows(rows),
+  m_columns(columns)
+{
+  assert(rows > 0 && columns > 0);
+  assertq(!entries.empty(), "CSRMatrix: need at least one non-zero value");
+
+  auto sorted = entries;
+  std::sort(sorted.begin(), sorted.end(), [] (SparseEntry const &a, SparseEntry const &b) {
+    return (a.row != b.row)? (a.row < b.row) : (a.col < b.col);
+  });
+
+  m_row_ptr.alloc(rows + 1);
+  m_col_idx.alloc((uint32_t) sorted.size());
+  m_values.alloc((uint32_t) sorted.size());
+
+  int row = 0;
+  m_row_ptr[0] = 0;
+
+  for (int i = 0; i < (int) sorted.size(); i++) {
+    auto const &e = sorted[i];
+    assertq(0 <= e.row && e.row < rows && 0 <= e.col && e.col < columns, "CSRMatrix: entry out of range");
+
+    while (row < e.row) {
+      m_row_ptr[++row] = i;
+    }
+
+    m_col_idx[i] = e.col;
+    m_values[i]  = e.value;
+  }
+
+  while (row < rows) {
+    m_row_ptr[++row] = (int) sorted.size();
+  }
+}
+
+
+/**
+ * The result vector needs to be a multiple of 16, i.e. vector size.
+ */
+int CSRMatrix::rows_result() const {
+  return 16*((m_rows + 15)/16);
+}
+
+
+int CSRMatrix::row_length(int row) const {
+  assert(0 <= row && row < m_rows);
+  return m_row_ptr[row + 1] - m_row_ptr[row];
+}
+
+
+void CSRMatrix::compile() {
+  if (m_k) return;
+  m_k.reset(new KernelType(V3DLib::compile(kernels::spmv_csr)));
+}
+
+
+void CSRMatrix::mult(Float::Array &x, Float::Array &y, CallType call_type) {
+  check_vectors(m_columns, rows_result(), x, y);
+
+  // Load per row group is the length of its longest row
+  std::vector<int> load;
+  for (int base = 0; base < m_rows; base += 16) {
+    int max_len = 0;
+    for (int row = base; row < std::min(base + 16, m_rows); row++) {
+      max_len = std::max(max_len, row_length(row));
+    }
+    load.push_back(16*max_len + 1);  // +1 for overhead of an empty group
+  }
+
+  // Final index is row count instead of multiple of 16
+  set_partition(load, m_num_qpus, 16, m_partition);
+  m_partition[m_num_qpus] = m_rows;
+
+  compile();
+  assertq(!has_errors(), "Can not run CSRMatrix::mult(), there are errors");
+  m_k->setNumQPUs(m_num_qpus);
+  m_k->load(&y, &x, &m_row_ptr, &m_col_idx, &m_values, &m_partition, m_rows);
+  run(*m_k, call_type);
+}
+
+
+/**
+ * CPU version of `mult()`, for checking results
+ */
+void CSRMatrix::mult_scalar(float const *x, float *y) const {
+  for (int row = 0; row < m_rows; row++) {
+    float sum = 0;
+
+    for (int i = m_row_ptr[row]; i < m_row_ptr[row + 1]; i++) {
+      sum += m_values[i]*x[m_col_idx[i]];
+    }
+
+    y[row] = sum;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class SELLMatrix
+///////////////////////////////////////////////////////////////////////////////
+
+SELLMatrix::SELLMatrix(CSRMatrix const &rhs) :
+  m_rows(rhs.rows()),
+  m_columns(rhs.columns())
+{
+  int const num_slices = rhs.rows_result()/16;
+  m_slice_ptr.alloc(num_slices + 1);
+
+  // Determine slice widths
+  int size = 0;
+  m_slice_ptr[0] = 0;
+
+  for (int s = 0; s < num_slices; s++) {
+    int width = 0;
+    for (int row = 16*s; row < std::min(16*(s + 1), m_rows); row++) {
+      width = std::max(width, rhs.row_length(row));
+    }
+
+    size += 16*width;
+    m_slice_ptr[s + 1] = size;
+  }
+
+  assert(size > 0);
+  m_col_idx.alloc(size);
+  m_values.alloc(size);
+  m_col_idx.fill(0);
+  m_values.fill(0.0f);
+
+  // Store values column-wise per slice
+  for (int row = 0; row < m_rows; row++) {
+    int offset = m_slice_ptr[row/16] + (row % 16);
+    int first  = rhs.row_ptr()[row];
+
+    for (int k = 0; k < rhs.row_length(row); k++) {
+      m_col_idx[offset + 16*k] = rhs.col_idx()[first + k];
+      m_values[offset + 16*k]  = rhs.values()[first + k];
+    }
+  }
+}
+
+
+void SELLMatrix::compile() {
+  if (m_k) return;
+  m_k.reset(new KernelType(V3DLib::compile(kernels::spmv_sell)));
+}
+
+
+void SELLMatrix::mult(Float::Array &x, Float::Array &y, CallType call_type) {
+  check_vectors(m_columns, rows_result(), x, y);
+
+  std::vector<int> load;
+  for (int s = 0; s < num_slices(); s++) {
+    load.push_back(m_slice_ptr[s + 1] - m_slice_ptr[s] + 1);  // +1 for overhead of an empty slice
+  }
+  set_partition(load, m_num_qpus, 1, m_partition);
+
+  compile();
+  assertq(!has_errors(), "Can not run SELLMatrix::mult(), there are errors");
+  m_k->setNumQPUs(m_num_qpus);
+  m_k->load(&y, &x, &m_slice_ptr, &m_col_idx, &m_values, &m_partition);
+  run(*m_k, call_type);
+}
+
+}  // namespace V3DLib
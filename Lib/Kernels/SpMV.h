@@ -0,0 +1,132 @@
+#ifndef _V3DLIB_KERNELS_SPMV_H_
+#define _V3DLIB_KERNELS_SPMV_H_
+#include <memory>
+#include <vector>
+#include "V3DLib.h"
+#include "Matrix.h"  // CallType
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernel code definitions for sparse matrix-vector multiplication
+////////////////////////////////////////////////////////////////////////////////
+
+namespace kernels {
+
+using namespace V3DLib;
+
+void spmv_csr(Float::Ptr y, Float::Ptr x, Int::Ptr row_ptr, Int::Ptr col_idx, Float::Ptr values,
+              Int::Ptr partition, Int num_rows);
+void spmv_sell(Float::Ptr y, Float::Ptr x, Int::Ptr slice_ptr, Int::Ptr col_idx, Float::Ptr values,
+               Int::Ptr partition);
+
+}  // namespace kernels
+
+
+namespace V3DLib {
+
+/**
+ * Non-zero value of a sparse matrix, for initialization
+ */
+struct SparseEntry {
+  int row;
+  int col;
+  float value;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class CSRMatrix
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sparse matrix in Compressed Sparse Row format
+ *
+ * Every vector lane handles a row, 16 consecutive rows per row group.
+ * The vector elements `x[col]` are gathered with per-lane addresses.
+ *
+ * Row groups are distributed over the QPUs so that every QPU gets about
+ * the same number of values to handle. Since all lanes wait for the longest row
+ * in a group, the count includes padding for the shorter rows of a group.
+ */
+class CSRMatrix {
+public:
+  using KernelType = Kernel<Float::Ptr, Float::Ptr, Int::Ptr, Int::Ptr, Float::Ptr, Int::Ptr, Int>;
+
+  CSRMatrix(int rows, int columns, std::vector<SparseEntry> const &entries);
+
+  int rows() const { return m_rows; }
+  int columns() const { return m_columns; }
+  int nnz() const { return (int) m_values.size(); }
+  int rows_result() const;
+  int row_length(int row) const;
+
+  Int::Array const &row_ptr() const { return m_row_ptr; }
+  Int::Array const &col_idx() const { return m_col_idx; }
+  Float::Array const &values() const { return m_values; }
+
+  void setNumQPUs(int val) { m_num_qpus = val; }
+  void compile();
+  bool has_errors() const { return m_k && m_k->has_errors(); }
+  void mult(Float::Array &x, Float::Array &y, CallType call_type = CALL);
+  void mult_scalar(float const *x, float *y) const;
+
+private:
+  int m_rows;
+  int m_columns;
+  int m_num_qpus = 1;
+  Int::Array   m_row_ptr;
+  Int::Array   m_col_idx;
+  Float::Array m_values;
+  Int::Array   m_partition;
+  std::unique_ptr<KernelType> m_k;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class SELLMatrix
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sparse matrix in Sliced ELLPACK format, with slices of 16 rows (SELL-16)
+ *
+ * Every slice of 16 rows is stored as an ELLPACK block, padded to the longest row
+ * of the slice. Within a slice, the values are stored column-wise, so that
+ * value `k` of the 16 rows can be read with a single vector load.
+ * Padding has value 0 and column 0.
+ *
+ * This wastes less space than plain ELLPACK for rows of varying lengths,
+ * and avoids the per-lane index loads of CSR.
+ *
+ * Slices are distributed over the QPUs so that every QPU gets about
+ * the same number of stored values to handle.
+ */
+class SELLMatrix {
+public:
+  using KernelType = Kernel<Float::Ptr, Float::Ptr, Int::Ptr, Int::Ptr, Float::Ptr, Int::Ptr>;
+
+  SELLMatrix(CSRMatrix const &rhs);
+
+  int rows() const { return m_rows; }
+  int columns() const { return m_columns; }
+  int num_slices() const { return (int) m_slice_ptr.size() - 1; }
+  int rows_result() const { return 16*num_slices(); }
+  int stored_size() const { return (int) m_values.size(); }
+
+  void setNumQPUs(int val) { m_num_qpus = val; }
+  void compile();
+  bool has_errors() const { return m_k && m_k->has_errors(); }
+  void mult(Float::Array &x, Float::Array &y, CallType call_type = CALL);
+
+private:
+  int m_rows;
+  int m_columns;
+  int m_num_qpus = 1;
+  Int::Array   m_slice_ptr;
+  Int::Array   m_col_idx;
+  Float::Array m_values;
+  Int::Array   m_partition;
+  std::unique_ptr<KernelType> m_k;
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_KERNELS_SPMV_H_
@@ -0,0 +1,278 @@
+#include "Stencil.h"
+#include "Source/Functions.h"  // barrier()
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace {
+
+using Update = TemporalStencil::Update;
+
+
+/**
+ * Shift-left the vector by one element, using the value of the next vector if present
+ */
+void shift_left(Float const &current, Float const *next, Float &result) {
+  result = rotate(current, 15);
+
+  if (next != nullptr) {
+    Float nextRot = rotate(*next, 15);
+    Where (index() == 15)
+      result = nextRot;
+    End
+  }
+}
+
+
+/**
+ * Shift-right the vector by one element, using the value of the previous vector if present
+ */
+void shift_right(Float const &current, Float const *prev, Float &result) {
+  result = rotate(current, 1);
+
+  if (prev != nullptr) {
+    Float prevRot = rotate(*prev, 1);
+    Where (index() == 0)
+      result = prevRot;
+    End
+  }
+}
+
+
+/**
+ * Run all levels of a round over a single strip of the band of the current QPU
+ *
+ * Input row `i` is loaded when output row `i - block_steps` is stored, with the rows in
+ * between in the wavefront. For every level, the previous two rows are kept in registers,
+ * the third is the row just computed by the level before.
+ *
+ * The rows are loaded in aligned blocks of 16 elements. On vc4, these are DMA loads, because
+ * the kernel syncs with `barrier()` (see `vc4/LoadPath.cpp`).
+ *
+ * The rows of the wavefront at the start are invalid; they only affect the rows above the
+ * band, which are not stored.
+ */
+void run_strip(
+  Float::Ptr const &src, Float::Ptr const &dst, Int const &x0,
+  Int const &width, Int const &height, Int const &first, Int const &last, Int const &active_steps,
+  int block_steps, int strip, Update const &update
+) {
+  int const K = block_steps;
+  int const S = strip;
+
+  Int xs = x0 - 8;                      comment("Start strip, with a halo of 8 elements left and right");
+
+  // Vector j of the strip consists of the upper half of aligned block j and the lower half of
+  // block j + 1. Blocks are clamped to the grid; the values outside the grid only affect the
+  // border cells, which are not updated.
+  std::vector<Int> block_x(S + 1);
+  for (int j = 0; j <= S; j++) {
+    block_x[j] = min(max(x0 + 16*(j - 1), 0), width - 16);
+  }
+
+  std::vector<Float> prev(K*S);
+  std::vector<Float> cur(K*S);
+  for (int j = 0; j < K*S; j++) {
+    prev[j] = 0.0f;
+    cur[j]  = 0.0f;
+  }
+
+  For (Int i = first - K, i < last + K, i++)
+    std::vector<Float> next(S);
+
+    Int y = min(max(i, 0), height - 1);  comment("Load input row");
+    std::vector<Float> block(S + 1);
+    for (int j = 0; j <= S; j++) {
+      Float::Ptr p = src + (y*width + block_x[j]);
+      block[j] = *p;
+    }
+
+    for (int j = 0; j < S; j++) {
+      next[j] = rotate(block[j], 8);
+      Float upper = rotate(block[j + 1], 8);
+      Where (index() >= 8)
+        next[j] = upper;
+      End
+    }
+
+    for (int t = 1; t <= K; t++) {
+      Float *p = &prev[(t - 1)*S];
+      Float *c = &cur[(t - 1)*S];
+      std::vector<Float> out(S);
+      Int row = i - t;                   comment("Compute level row");
+
+      auto set_rows = [p, c, &next] (Float const *rows[3], int j) {
+        rows[0] = &p[j];
+        rows[1] = &c[j];
+        rows[2] = &next[j];
+      };
+
+      for (int j = 0; j < S; j++) {
+        Float const *rows[3];
+        Float const *before[3];
+        Float const *after[3];
+        set_rows(rows, j);
+        if (j > 0)     set_rows(before, j - 1);
+        if (j < S - 1) set_rows(after, j + 1);
+
+        TemporalStencil::Block b(rows, (j > 0)?before:nullptr, (j < S - 1)?after:nullptr);
+        update(b, out[j]);
+
+        // Border cells keep their values, as do all cells for levels past the final step
+        Int x = xs + 16*j + index();
+        Where (x == 0 || x == width - 1 || row <= 0 || row >= height - 1 || active_steps < t)
+          out[j] = c[j];
+        End
+      }
+
+      for (int j = 0; j < S; j++) {
+        p[j]    = c[j];
+        c[j]    = next[j];
+        next[j] = out[j];
+      }
+    }
+
+    If (i >= first + K)
+      Int y_out = i - K;                 comment("Store output row, without the halo");
+
+      for (int j = 0; j < S - 1; j++) {
+        Float val = rotate(next[j], 8);
+        Float val_next = rotate(next[j + 1], 8);
+        Where (index() >= 8)
+          val = val_next;
+        End
+
+        If (x0 + 16*j < width)
+          Float::Ptr out_ptr = dst + (y_out*width + x0 + 16*j);
+          *out_ptr = val;
+        End
+      }
+    End
+  End
+}
+
+
+/**
+ * Kernel for temporal blocking.
+ *
+ * Every QPU handles the rows `me()*band` up to `(me() + 1)*band`.
+ * The result ends up in `b` for an odd number of rounds, otherwise in `a`.
+ */
+void stencil_kernel(
+  Float::Ptr a, Float::Ptr b, Int width, Int height, Int band, Int num_steps,
+  int block_steps, int strip, Update const &update
+) {
+  Int first = me()*band;
+  Int last  = min(first + band, height);
+  Float::Ptr src = a;
+  Float::Ptr dst = b;
+
+  For (Int done = 0, done < num_steps, done += block_steps)
+    Int active_steps = num_steps - done;
+
+    For (Int x0 = 0, x0 < width, x0 += 16*(strip - 1))
+      run_strip(src, dst, x0, width, height, first, last, active_steps, block_steps, strip, update);
+    End
+
+    barrier();                           comment("Wait till all bands are done, then swap buffers");
+    Float::Ptr tmp = src;
+    src = dst;
+    dst = tmp;
+  End
+}
+
+}  // anon namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class TemporalStencil::Block
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @param rows    rows of the vector with the values to update
+ * @param before  rows of the vector to the left, nullptr if none
+ * @param after   rows of the vector to the right, nullptr if none
+ */
+TemporalStencil::Block::Block(Float const *rows[3], Float const *before[3], Float const *after[3]) {
+  for (int n = 0; n < 3; n++) {
+    m_current[n] = rows[n];
+    shift_left(*rows[n], (after == nullptr)?nullptr:after[n], m_right[n]);
+    shift_right(*rows[n], (before == nullptr)?nullptr:before[n], m_left[n]);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class TemporalStencil
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @param width        width of the grid, must be a multiple of 16
+ * @param height       height of the grid
+ * @param update       stencil function, computes the next value of a cell
+ * @param block_steps  number of timesteps per round
+ * @param strip        width of a strip in vectors, including the halo
+ */
+TemporalStencil::TemporalStencil(int width, int height, Update update, int block_steps, int strip) :
+  m_width(width),
+  m_height(height),
+  m_block_steps(block_steps),
+  m_strip(strip),
+  m_update(update)
+{
+  assertq(width > 0 && width % 16 == 0, "TemporalStencil: width must be a multiple of 16", true);
+  assertq(height >= 3, "TemporalStencil: need at least 3 rows", true);
+  assertq(1 <= block_steps && block_steps <= MAX_BLOCK_STEPS, "TemporalStencil: block steps out of range", true);
+  assertq(2 <= strip && strip <= 4, "TemporalStencil: strip must be 2 to 4 vectors wide", true);
+}
+
+
+void TemporalStencil::compile() {
+  if (m_k) return;
+
+  int block_steps = m_block_steps;
+  int strip       = m_strip;
+  Update update   = m_update;
+
+  m_k.reset(new KernelType(
+    std::function<void(Float::Ptr, Float::Ptr, Int, Int, Int, Int)>(
+      [block_steps, strip, update] (Float::Ptr a, Float::Ptr b, Int width, Int height, Int band, Int num_steps) {
+        stencil_kernel(a, b, width, height, band, num_steps, block_steps, strip, update);
+      }
+    ),
+    BOTH
+  ));
+}
+
+
+/**
+ * Run the given number of timesteps, in a single kernel launch.
+ *
+ * The initial state is in `a`, both arrays are used as buffers.
+ *
+ * @return the array with the final state
+ */
+Float::Array &TemporalStencil::run(Float::Array &a, Float::Array &b, int steps, CallType call_type) {
+  assertq(steps >= 0, "TemporalStencil: number of steps can not be negative", true);
+  assertq((int) a.size() >= m_width*m_height && (int) b.size() >= m_width*m_height,
+    "TemporalStencil: arrays too small for the grid", true);
+
+  if (steps == 0) return a;
+
+  compile();
+  assertq(!has_errors(), "Can not run TemporalStencil, there are errors");
+
+  int band = (m_height + m_num_qpus - 1)/m_num_qpus;
+  m_k->setNumQPUs(m_num_qpus);
+  m_k->load(&a, &b, m_width, m_height, band, steps);
+
+  switch(call_type) {
+    case CALL:      m_k->call();      break;
+    case INTERPRET: m_k->interpret(); break;
+    case EMULATE:   m_k->emu();       break;
+  }
+
+  int rounds = (steps + m_block_steps - 1)/m_block_steps;
+  return (rounds % 2 == 1)?b:a;
+}
+
+}  // namespace V3DLib
@@ -0,0 +1,96 @@
+#ifndef _V3DLIB_KERNELS_STENCIL_H_
+#define _V3DLIB_KERNELS_STENCIL_H_
+#include <functional>
+#include <memory>
+#include "V3DLib.h"
+#include "Matrix.h"  // CallType
+
+namespace V3DLib {
+
+///////////////////////////////////////////////////////////////////////////////
+// Class TemporalStencil
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Executor for iterative 3x3 stencils on a 2D grid, running many timesteps per kernel launch.
+ *
+ * Launching a kernel per timestep, as example `HeatMap` does, moves the entire grid
+ * through main memory on every step. Here, the timesteps are done in rounds of
+ * `block_steps` steps (temporal blocking):
+ *
+ * - Every QPU handles a band of rows, in strips of `strip` vectors.
+ * - The rows of a strip are streamed through a wavefront in registers, one level per timestep.
+ *   Only the input rows are loaded and only the rows of the final level are stored.
+ * - To compute its band and strip for all steps of a round, a QPU also computes a halo
+ *   of `block_steps` rows above and below and 8 elements left and right. The halos
+ *   overlap with the neighbouring bands and strips and are computed redundantly.
+ * - After a round, the QPUs sync with `barrier()` and swap the input and output buffers
+ *   within the kernel. The loads of the next round see the stores of all QPUs: on vc4,
+ *   the loads are done with DMA instead of the TMU; on v3d, `barrier()` clears the TMU cache.
+ *
+ * A strip of `strip` vectors outputs `strip - 1` vectors, so larger strips have less
+ * redundant work at the cost of more registers.
+ *
+ * The border cells, i.e. the first and last row and column, keep their values.
+ *
+ * ============================================================================
+ * NOTES
+ * =====
+ *
+ * * The wavefront keeps `2*block_steps*strip` vectors in registers. With the heat map
+ *   update of example `HeatMap`, `block_steps = 8` with `strip = 2` still compiles,
+ *   `block_steps = 8` with `strip = 3` runs out of registers.
+ *
+ * * The update function is called for every level of the wavefront. It should not
+ *   use a lot of variables, or the register allocation fails.
+ */
+class TemporalStencil {
+public:
+  using KernelType = Kernel<Float::Ptr, Float::Ptr, Int, Int, Int, Int>;
+
+  /**
+   * Represent the 3x3 block of values around the value to update.
+   *
+   * Same interface as `Cursor::Block`, `n` is the row index 0..2 from top to bottom.
+   */
+  struct Block {
+    Block(Float const *rows[3], Float const *before[3], Float const *after[3]);
+
+    Float const &left(int n)    const  { return m_left[n]; }
+    Float const &current(int n) const  { return *m_current[n]; }
+    Float const &right(int n)   const  { return m_right[n]; }
+
+  private:
+    Float const *m_current[3];
+    Float  m_left[3];
+    Float  m_right[3];
+  };
+
+  using Update = std::function<void(Block const &, Float &output)>;
+
+  static int const MAX_BLOCK_STEPS = 8;
+
+  TemporalStencil(int width, int height, Update update, int block_steps = 4, int strip = 2);
+
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+  int block_steps() const { return m_block_steps; }
+
+  void setNumQPUs(int val) { m_num_qpus = val; }
+  void compile();
+  bool has_errors() const { return m_k && m_k->has_errors(); }
+  Float::Array &run(Float::Array &a, Float::Array &b, int steps, CallType call_type = CALL);
+
+private:
+  int m_width;
+  int m_height;
+  int m_block_steps;
+  int m_strip;
+  int m_num_qpus = 1;
+  Update m_update;
+  std::unique_ptr<KernelType> m_k;
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_KERNELS_STENCIL_H_
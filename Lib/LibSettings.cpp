@@ -9,8 +9,9 @@ int const QPU_TIMEOUT = 10;
 struct SettingsInternal {
   int  heap_size   = -1;                  // bytes, size of shared (CPU-GPU) memory
   int  qpu_timeout = -1;                  // seconds, time to wait for response from QPU
-  bool use_tmu_for_load = true;           // vc4 only, ignored for v3d. If false, use DMA
+  LibSettings::LoadPath load_path = LibSettings::LOAD_TMU;  // vc4 only, ignored for v3d
   bool use_high_precision_sincos = false; // If true, add extra precision to sin/cos calculation for function version
+  int  v3d_threads = 1;                   // v3d only, number of hardware threads per QPU
 } settings;
 
 }  // anon namespace
@@ -58,11 +59,40 @@ void LibSettings::heap_size(int val) {
 }
 
 
-bool LibSettings::use_tmu_for_load()         { return settings.use_tmu_for_load; }
-void LibSettings::use_tmu_for_load(bool val) { settings.use_tmu_for_load = val; }
+LibSettings::LoadPath LibSettings::load_path() { return settings.load_path; }
+void LibSettings::load_path(LoadPath val)      { settings.load_path = val; }
+
+
+/**
+ * Shorthand for selecting between TMU and DMA loads.
+ *
+ * Setting this overrides the per-site selection of `LOAD_AUTO`.
+ */
+bool LibSettings::use_tmu_for_load()         { return settings.load_path != LOAD_DMA; }
+void LibSettings::use_tmu_for_load(bool val) { settings.load_path = val?LOAD_TMU:LOAD_DMA; }
 
 
 bool LibSettings::use_high_precision_sincos()         { return settings.use_high_precision_sincos; }
 void LibSettings::use_high_precision_sincos(bool val) { settings.use_high_precision_sincos = val; }
 
+
+int LibSettings::v3d_threads() { return settings.v3d_threads; }
+
+
+/**
+ * Set the number of hardware threads per QPU for v3d kernels.
+ *
+ * With more threads, a QPU can switch to another thread while waiting for a TMU load.
+ * The register file is divided over the threads, so kernels with many live variables
+ * may be compiled for fewer threads than requested.
+ *
+ * Takes effect on compilation of the kernel.
+ *
+ * @param val  1, 2 or 4
+ */
+void LibSettings::v3d_threads(int val) {
+  assertq(val == 1 || val == 2 || val == 4, "v3d_threads(): number of threads must be 1, 2 or 4");
+  settings.v3d_threads = val;
+}
+
 }  // namespace V3DLib
@@ -8,17 +8,33 @@ namespace V3DLib {
  */
 class LibSettings {
 public:
+  /**
+   * Selection of the path for loads of vectors from main memory on vc4.
+   *
+   * Kernels which sync QPUs, e.g. with `barrier()`, always use DMA for contiguous loads.
+   */
+  enum LoadPath {
+    LOAD_TMU,   // Use the TMU, default
+    LOAD_DMA,   // Use DMA for contiguous loads, TMU for anything else
+    LOAD_AUTO   // Select per load site, see `vc4/LoadPath.cpp`
+  };
+
   static int  qpu_timeout();
   static void qpu_timeout(int val);
 
   static int  heap_size();
   static void heap_size(int val);
 
+  static LoadPath load_path();
+  static void load_path(LoadPath val);
   static bool use_tmu_for_load();
   static void use_tmu_for_load(bool val);
 
   static bool use_high_precision_sincos();
   static void use_high_precision_sincos(bool val);
+
+  static int  v3d_threads();
+  static void v3d_threads(int val);
 };
 
 }  // namespace V3DLib
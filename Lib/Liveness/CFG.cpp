@@ -1,6 +1,7 @@
 #include "CFG.h"
 #include <iostream>
 #include "Support/basics.h"
+#include "UseDef.h"
 
 namespace V3DLib {
 
@@ -285,6 +286,8 @@ void CFG::build(Instr::List &instrs) {
     }
   }
 
+  build_subroutines(instrs, labelMap);
+
   // Free memory
   delete [] labelMap;
 
@@ -292,6 +295,86 @@ void CFG::build(Instr::List &instrs) {
 }
 
 
+/**
+ * Register the subroutine calls and the variables used in the subroutine bodies.
+ *
+ * The body of a subroutine runs from its entry label up to and including the
+ * first unconditional return.
+ */
+void CFG::build_subroutines(Instr::List &instrs, InstrId const *labelMap) {
+  for (int i = 0; i < instrs.size(); i++) {
+    Instr const &instr = instrs[i];
+    if (!instr.is_call()) continue;
+
+    Call call;
+    call.entry = labelMap[instr.branch_label()];
+    call.ret   = labelMap[instr.return_label()];
+    assert(call.entry >= 0 && call.ret >= 0);
+    m_calls[i] = call;
+
+    if (m_subroutines.find(call.entry) != m_subroutines.end()) continue;
+
+    Subroutine sub;
+    sub.last = -1;
+
+    for (int j = call.entry; j < instrs.size(); j++) {
+      Instr const &body_instr = instrs[j];
+
+      if (body_instr.is_subroutine_exit() && body_instr.branch_cond().is_always()) {
+        sub.last = j;
+        break;
+      }
+
+      if (!body_instr.has_registers()) continue;
+
+      UseDef useDef(body_instr);
+      sub.use.add(useDef.use);
+      if (useDef.def.tag != NONE) {
+        sub.def.insert(useDef.def.regId);
+      }
+    }
+
+    assertq(sub.last != -1, "CFG: no return found for subroutine", true);
+    m_subroutines[call.entry] = sub;
+  }
+}
+
+
+CFG::Call const &CFG::call(InstrId i) const {
+  auto it = m_calls.find(i);
+  assert(it != m_calls.end());
+  return it->second;
+}
+
+
+CFG::Subroutine const &CFG::subroutine(InstrId entry) const {
+  auto it = m_subroutines.find(entry);
+  assert(it != m_subroutines.end());
+  return it->second;
+}
+
+
+/**
+ * @return index of entry of subroutine containing given instruction, -1 if not in a subroutine
+ */
+InstrId CFG::subroutine_at(InstrId i) const {
+  for (auto const &it : m_subroutines) {
+    if (it.first <= i && i <= it.second.last) return it.first;
+  }
+
+  return -1;
+}
+
+
+/**
+ * @return true if there is a subroutine call in the given range of instructions
+ */
+bool CFG::has_call_in(InstrId first, InstrId last) const {
+  auto it = m_calls.lower_bound(first);
+  return (it != m_calls.end() && it->first <= last);
+}
+
+
 /**
  * Returns the block of given instruction line
  */
@@ -303,6 +386,8 @@ int CFG::block_at(InstrId line_num) const {
 void CFG::clear() {
   Parent::clear();
   blocks.clear();
+  m_calls.clear();
+  m_subroutines.clear();
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef _V3DLIB_LIVENESS_CFG_H_
 #define _V3DLIB_LIVENESS_CFG_H_
 #include <set>
+#include <map>
 #include <vector>
 #include "Target/instr/Instr.h"
 #include "Range.h"
@@ -20,12 +21,35 @@ class CFG : public std::vector<Succs> {
   using Parent = std::vector<Succs>;
 
 public:
+  /**
+   * Subroutine call site
+   */
+  struct Call {
+    InstrId entry;  // First instruction of the subroutine
+    InstrId ret;    // Instruction to return to
+  };
+
+  /**
+   * Variables referenced in the body of a subroutine
+   */
+  struct Subroutine {
+    InstrId  last;  // Last instruction of the body
+    RegIdSet use;
+    RegIdSet def;
+  };
+
   void build(Instr::List &instrs);
   int  block_at(InstrId line_num) const;
   int  block_end(InstrId line_num) const { return blocks.end(line_num);}
   bool is_parent_block(InstrId line_num, int block) const;
   void clear();
 
+  bool is_call(InstrId i) const { return m_calls.find(i) != m_calls.end(); }
+  Call const &call(InstrId i) const;
+  Subroutine const &subroutine(InstrId entry) const;
+  InstrId subroutine_at(InstrId i) const;
+  bool has_call_in(InstrId first, InstrId last) const;
+
   std::string dump() const;
 
 private:
@@ -51,7 +75,11 @@ private:
     int max_block_num() const;
   } blocks;
 
+  std::map<InstrId, Call>       m_calls;        // Key is index of call instruction
+  std::map<InstrId, Subroutine> m_subroutines;  // Key is index of entry instruction
+
   bool is_regular(InstrId i) const;
+  void build_subroutines(Instr::List &instrs, InstrId const *labelMap);
 };
 
 
@@ -128,6 +128,49 @@ Instr::List  remove_replaced_instructions(Instr::List &instrs) {
 // Class Liveness
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Compute the 'use' and 'def' sets of the given instruction for liveness analysis.
+ *
+ * A conditional assignment also counts as a use of the dst variable if
+ * the variable has been assigned before.
+ */
+UseDef Liveness::use_def(Instr::List &instrs, InstrId i) {
+  auto &instr = instrs[i];
+
+  bool also_set_used = false;
+
+  if (instr.isCondAssign()) {  // no performance impact ~ 1.5%
+    Reg dst = instr.dst_a_reg();
+
+    if (dst.tag != NONE) {
+      auto &item = m_reg_usage[dst.regId];
+
+      // If the dst variable is not used before, it should not be set as used as well
+      assert(item.first_dst() <= i);
+      also_set_used = (item.first_dst() < i);
+
+      if (!also_set_used) {
+        //
+        // Sanity check: in this case, we expect the variable to be in the condition assign block only
+        //
+        // Notably, this assertion fails for init of variables without an explicit init value.
+        // This can be extremely confusing, hence this comment.
+        //
+        AssignCond assign_cond = instr.assign_cond();
+        for (int j = item.first_usage(); j <= item.last_usage(); j++) {
+          assertq((assign_cond == instrs[j].assign_cond())            // expected usage
+               || (instrs[j].is_always() && !instrs[j].is_branch()),  // Interim basic usage allowed (happens)
+            "Expected variable to be in condition assign block only", true
+          );
+        }
+      }
+    }
+  }
+
+  return UseDef(instr, also_set_used);
+}
+
+
 /**
  * Determine the liveness sets for each instruction.
  */
@@ -161,41 +204,9 @@ void Liveness::compute_liveness(Instr::List &instrs) {
 
     // Propagate live variables backwards
     for (int i = instrs.size() - 1; i >= 0; i--) {
-      auto &instr = instrs[i];
-
-      bool also_set_used = false;
-
-      if (instr.isCondAssign()) {  // no performance impact ~ 1.5%
-        Reg dst = instr.dst_a_reg();
-
-        if (dst.tag != NONE) {
-          auto &item = m_reg_usage[dst.regId];
-
-          // If the dst variable is not used before, it should not be set as used as well
-          assert(item.first_dst() <= i);
-          also_set_used = (item.first_dst() < i);
-
-          if (!also_set_used) {
-            //
-            // Sanity check: in this case, we expect the variable to be in the condition assign block only
-            //
-            // Notably, this assertion fails for init of variables without an explicit init value.
-            // This can be extremely confusing, hence this comment.
-            //
-            AssignCond assign_cond = instr.assign_cond();
-            for (int j = item.first_usage(); j <= item.last_usage(); j++) {
-              assertq((assign_cond == instrs[j].assign_cond())            // expected usage
-                   || (instrs[j].is_always() && !instrs[j].is_branch()),  // Interim basic usage allowed (happens)
-                "Expected variable to be in condition assign block only", true
-              );
-            }
-          }
-        }
-      }
-
       //t2.start();
       // Compute 'use' and 'def' sets
-      UseDef useDef(instr, also_set_used);
+      UseDef useDef = use_def(instrs, i);
 
       //t3.start();
       computeLiveOut(i, liveOut);
@@ -251,12 +262,151 @@ void Liveness::compute(Instr::List &instrs) {
   //t3.end();
   assert(instrs.size() == size());
 
+  set_live();
+}
+
+
+/**
+ * Redo the liveness analysis for the given variables only.
+ *
+ * This is meant for local rewrites of the instructions, which leave the liveness
+ * of all other variables intact. The instruction list must have the same size as
+ * in the previous analysis; rewrites replace instructions with SKIP instead of removing them.
+ *
+ * The CFG and the register usage are cheap to determine and are redone in full.
+ * Only the live sets are updated incrementally.
+ */
+void Liveness::update(Instr::List &instrs, RegIdSet const &vars) {
+  assert(instrs.size() == size());
+
+  m_cfg.clear();
+  m_cfg.build(instrs);
+  m_reg_usage.reset();
+  m_reg_usage.set_used(instrs);
+
+  update_liveness(instrs, vars);
+  set_live();
+}
+
+
+/**
+ * Recompute the live sets of the given variables.
+ *
+ * Liveness of a variable does not depend on other variables, so the fixed point
+ * can be determined for the given variables alone. A worklist is used which starts
+ * at the instructions using the variables and propagates backwards over the predecessors.
+ * Only the instructions over which the variables are live are visited.
+ */
+void Liveness::update_liveness(Instr::List &instrs, RegIdSet const &vars) {
+  if (vars.empty()) return;
+
+  // Predecessors of each instruction.
+  // For subroutine calls, the live-out set depends on the entry and the return point.
+  std::vector<std::vector<InstrId>> preds(instrs.size());
+
+  for (int i = 0; i < instrs.size(); i++) {
+    for (auto succ : m_cfg[i]) {
+      preds[succ].push_back(i);
+    }
+
+    if (m_cfg.is_call(i)) {
+      auto const &call = m_cfg.call(i);
+      preds[call.entry].push_back(i);
+      preds[call.ret].push_back(i);
+    }
+  }
+
+  std::vector<InstrId> work;
+  std::vector<bool> in_work(instrs.size(), false);
+
+  auto add_work = [&work, &in_work] (InstrId i) {
+    if (in_work[i]) return;
+    in_work[i] = true;
+    work.push_back(i);
+  };
+
+  for (int i = 0; i < instrs.size(); i++) {
+    auto &item = get(i);
+    for (auto r : vars) {
+      item.remove(r);
+    }
+
+    if (!instrs[i].has_registers()) continue;
+
+    UseDef useDef = use_def(instrs, i);
+    for (auto r : useDef.use) {
+      if (vars.member(r)) {
+        add_work(i);
+        break;
+      }
+    }
+  }
+
+  RegIdSet liveIn;
+  RegIdSet liveOut;
+
+  while (!work.empty()) {
+    InstrId i = work.back();
+    work.pop_back();
+    in_work[i] = false;
+
+    UseDef useDef = use_def(instrs, i);
+    computeLiveOut(i, liveOut);
+
+    liveIn.clear();
+    for (auto r : liveOut) {
+      if (vars.member(r) && !(useDef.def.tag != NONE && useDef.def.regId == r)) {
+        liveIn.insert(r);
+      }
+    }
+
+    for (auto r : useDef.use) {
+      if (vars.member(r)) liveIn.insert(r);
+    }
+
+    if (insert(i, liveIn)) {
+      for (auto pred : preds[i]) {
+        add_work(pred);
+      }
+    }
+  }
+}
+
+
+/**
+ * Derive the live ranges of the variables from the live sets
+ */
+void Liveness::set_live() {
   m_reg_usage.set_live(*this);
 
   compile_data.reg_usage_dump = m_reg_usage.dump(true);
   compile_data.liveness_dump = dump();
 
-  m_reg_usage.check();
+  m_reg_usage.check(m_cfg);
+}
+
+
+/**
+ * Remove the SKIP instructions from the list, along with their live sets.
+ *
+ * A SKIP has no registers and passes on to the next instruction, so its live set
+ * is the same as that of the next instruction. Removing it does not change the
+ * live sets of the other instructions.
+ *
+ * Note that the CFG and the register usage are not valid any more after this call.
+ */
+void Liveness::remove_skips(Instr::List &instrs) {
+  assert(instrs.size() == size());
+  std::vector<RegIdSet> sets;
+
+  for (int i = 0; i < instrs.size(); i++) {
+    if (instrs[i].tag == InstrTag::SKIP) continue;
+    sets.push_back(std::move(m_set[i]));
+  }
+
+  m_set = std::move(sets);
+  instrs = remove_replaced_instructions(instrs);
+  assert(instrs.size() == size());
 }
 
 
@@ -269,6 +419,26 @@ void Liveness::compute(Instr::List &instrs) {
 void Liveness::computeLiveOut(InstrId i, RegIdSet &liveOut) {
   liveOut.clear();
 
+  if (m_cfg.is_call(i)) {
+    // A subroutine call is handled as a single instruction using and defining the
+    // variables of the subroutine body.
+    //
+    // Variables live at the subroutine entry which are not used in the body are there
+    // because they are live at other call sites; skip these.
+    auto const &call = m_cfg.call(i);
+    auto const &sub  = m_cfg.subroutine(call.entry);
+
+    for (auto r : get(call.entry)) {
+      if (sub.use.member(r)) liveOut.insert(r);
+    }
+
+    for (auto r : get(call.ret)) {
+      if (!sub.def.member(r)) liveOut.insert(r);
+    }
+
+    return;
+  }
+
   for (auto const &val : m_cfg[i]) {
     liveOut.add(get(val));
   }
@@ -329,37 +499,57 @@ std::string Liveness::dump() {
  * This is done before the actual liveness analysis.
  * The idea is to minimize beforehand the number of variables considered
  * in the liveness analysis.
+ *
+ * The liveness analysis is done once in full. The optimizations report the variables
+ * they rewrite, and only the liveness of these is redone afterwards.
+ * On completion, this instance contains the liveness analysis of the optimized code.
  */
-void Liveness::optimize(Instr::List &instrs, int numVars) {
+void Liveness::optimize(Instr::List &instrs) {
   assertq(count_skips(instrs) == 0, "optimize(): SKIPs detected in instruction list");
   compile_data.target_code_before_optimization = instrs.dump();
 
   //Timer t1("live compute");
-  Liveness live(numVars);
-  live.compute(instrs);
-  //std::cout << live.dump() << std::endl;
+  compute(instrs);
+  //std::cout << dump() << std::endl;
   //t1.end();
 
-  if (combineImmediates(live, instrs)) {
+  RegIdSet changed;
+
+  if (combineImmediates(*this, instrs, changed)) {
     //std::cout << "After combineImmediates:\n"; 
     //std::cout << instrs.dump(true) << std::endl;  // Useful sometimes for debug
 
-    //Timer t3("combine immediates compute", true);
-    live.compute(instrs);  // instructions have changed, redo liveness
-    //std::cout << live.dump() << std::endl;
+    //Timer t3("combine immediates update", true);
+    update(instrs, changed);  // instructions have changed, redo liveness of the changed vars
   }
 
   //Timer t3("introduceAccum");
+  changed.clear();
   int prev_count_skips = count_skips(instrs);
-  compile_data.num_accs_introduced = introduceAccum(live, instrs);
+  compile_data.num_accs_introduced = introduceAccum(*this, instrs, changed);
   assertq(prev_count_skips == count_skips(instrs), "SKIP count changed after introduceAccum()");
   //t3.end();
 
   // Times for following (now) insignificant
 
-  instrs = remove_replaced_instructions(instrs);
+  remove_skips(instrs);
   assertq(count_skips(instrs) == 0, "optimize(): SKIPs detected in instruction list after cleanup");
 
+  // Vars replaced by accumulators need updating.
+  // This also redoes the CFG and register usage for the shortened instruction list.
+  update(instrs, changed);
+
+#ifdef DEBUG
+  // Sanity check, compare with liveness analysis from scratch
+  {
+    Liveness check(m_reg_usage.size());
+    check.compute(instrs);
+    for (int i = 0; i < size(); i++) {
+      assertq(check[i] == get(i), "optimize(): incremental liveness differs from full analysis", true);
+    }
+  }
+#endif
+
   //std::cout << count_reg_types(instrs).dump() << std::endl;
   compile_data.target_code_before_liveness = instrs.dump();
 }
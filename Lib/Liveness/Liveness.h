@@ -9,6 +9,7 @@
 #include "CFG.h"
 #include "RegUsage.h"
 #include "LiveSet.h"
+#include "UseDef.h"
 
 namespace V3DLib {
 
@@ -42,11 +43,11 @@ public:
   RegIdSet &operator[](int index) { return get(index); }
 
   void compute(Instr::List &instrs);
+  void update(Instr::List &instrs, RegIdSet const &vars);
   void computeLiveOut(InstrId i, RegIdSet &liveOut);
+  void optimize(Instr::List &instrs);
   std::string dump();
 
-  static void optimize(Instr::List &instrs, int numVars);
-
 private:
   CFG          m_cfg;
   std::vector<RegIdSet> m_set;
@@ -55,6 +56,10 @@ private:
   RegIdSet &get(int index) { return m_set[index]; }
   void clear();
   void compute_liveness(Instr::List &instrs);
+  void update_liveness(Instr::List &instrs, RegIdSet const &vars);
+  UseDef use_def(Instr::List &instrs, InstrId i);
+  void set_live();
+  void remove_skips(Instr::List &instrs);
   void setSize(int size);
   bool insert(int index, RegIdSet const &set);
 };
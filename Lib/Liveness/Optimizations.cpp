@@ -3,12 +3,32 @@
 #include "Liveness.h"
 #include "Support/Platform.h"
 #include "Target/Subst.h"
+#include "Target/instr/Mnemonics.h"
 #include "Support/Timer.h"
 #include "Support/basics.h"
 
 namespace V3DLib {
 namespace {
 
+/**
+ * The uniform stream address can only be set from the register file (v3d)
+ */
+bool needs_regfile(Instr const &instr, RegId var_id) {
+  return instr.tag == InstrTag::ALU
+      && instr.dst_reg() == Target::instr::UNIFORM_ADDR
+      && instr.is_src_reg(Reg(REG_A, var_id));
+}
+
+
+bool needs_regfile(Instr::List const &instrs, RegId var_id, int first, int last) {
+  for (int i = first; i <= last; i++) {
+    if (needs_regfile(instrs[i], var_id)) return true;
+  }
+
+  return false;
+}
+
+
 void replace_acc(Instr::List &instrs, RegUsageItem &item, int var_id, int acc_id) {
   Reg current(REG_A, var_id);
   Reg replace_with(ACC, acc_id);
@@ -30,7 +50,7 @@ void replace_acc(Instr::List &instrs, RegUsageItem &item, int var_id, int acc_id
 /**
  * Not as useful as I would have hoped. range_size > 1 in practice happens, but seldom.
  */
-int peephole_0(int range_size, Instr::List &instrs, RegUsage &allocated_vars) {
+int peephole_0(int range_size, Liveness &live, Instr::List &instrs, RegUsage &allocated_vars, RegIdSet &changed) {
   if (range_size == 0) {
     warning("peephole_0(): range_size == 0 passed in. This does nothing, not bothering");
     return 0;
@@ -53,6 +73,15 @@ int peephole_0(int range_size, Instr::List &instrs, RegUsage &allocated_vars) {
       continue;
     }
 
+    // The accumulators used in a called subroutine are not in the usage range
+    if (live.cfg().has_call_in(item.first_usage(), item.last_usage())) {
+      continue;
+    }
+
+    if (needs_regfile(instrs, var_id, item.first_usage(), item.last_usage())) {
+      continue;
+    }
+
     //
     // NOTE: There may be a slight issue here:
     //       in line of first use, src acc's may be used for vars which have
@@ -85,6 +114,7 @@ int peephole_0(int range_size, Instr::List &instrs, RegUsage &allocated_vars) {
 */
 
     replace_acc(instrs, item, var_id, acc_id);
+    changed.insert(var_id);
 
     subst_count++;
   }
@@ -107,10 +137,11 @@ int peephole_0(int range_size, Instr::List &instrs, RegUsage &allocated_vars) {
  *     j:  g(..., acc, ...)
  *
  * @param allocated_vars  write param, to register which vars have an accumulator registered
+ * @param changed         write param, vars which have been replaced
  *
  * @return Number of substitutions performed;
  */
-int peephole_1(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
+int peephole_1(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars, RegIdSet &changed) {
   RegIdSet liveOut;
   int subst_count = 0;
 
@@ -135,6 +166,7 @@ int peephole_1(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
 
     // If 'instr' is not last usage of the found var, skip
     if (!(instr.src_a_regs().member(def) && !liveOut.member(def))) continue;
+    if (needs_regfile(instr, def)) continue;
 
     // Can't remove this test.
     // Reason: There may be a preceding instruction which sets the var to be replaced.
@@ -163,6 +195,7 @@ int peephole_1(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
     // DANGEROUS! Do not use this value downstream.   
     // Currently stored for debug display purposes only! 
     allocated_vars[def].reg = replace_with;    
+    changed.insert(def);
 
     subst_count++;
   }
@@ -173,7 +206,7 @@ int peephole_1(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
 /**
  * Replace assign-only variables with an accumulator
  */
-int peephole_2(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
+int peephole_2(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars, RegIdSet &changed) {
   int subst_count = 0;
 
   for (int i = 1; i < instrs.size(); i++) {
@@ -203,6 +236,7 @@ int peephole_2(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
     // DANGEROUS! Do not use this value downstream (remember why, old fart?).   
     // Currently stored for debug display purposes only! 
     allocated_vars[def].reg = replace_with;    
+    changed.insert(def);
 
     subst_count++;
   }
@@ -214,9 +248,11 @@ int peephole_2(Liveness &live, Instr::List &instrs, RegUsage &allocated_vars) {
 
 
 /**
+ * @param changed  write param, vars whose usage has been changed
+ *
  * @return true if any replacements were made, false otherwise
  */
-bool combineImmediates(Liveness &live, Instr::List &instrs) {
+bool combineImmediates(Liveness &live, Instr::List &instrs, RegIdSet &changed) {
   //Timer t3("combineImmediates loop3", true);
   //Timer t1("combineImmediates", true);
 
@@ -298,6 +334,8 @@ bool combineImmediates(Liveness &live, Instr::List &instrs) {
           }
 
           // Perform the subst
+          changed.insert(instr.dest().regId);
+
           if (instr2.ALU.srcA == instr.dest()) {
             instr2.ALU.srcA = instr.LI.imm;
           }
@@ -308,6 +346,7 @@ bool combineImmediates(Liveness &live, Instr::List &instrs) {
         }
 
         if (can_remove) {
+          changed.insert(instr.dest().regId);
           instr.tag = SKIP;
         }
       }
@@ -399,6 +438,8 @@ bool combineImmediates(Liveness &live, Instr::List &instrs) {
         msg << "Replacing instruction at " << j << " with with NOP";
         debug(msg);
 */
+        changed.insert(current.regId);
+        changed.insert(replace_with.regId);
         instr2.tag = InstrTag::SKIP;
       }
     }
@@ -420,6 +461,7 @@ bool combineImmediates(Liveness &live, Instr::List &instrs) {
  * Optimisation passes that introduce accumulators
  *
  * @param allocated_vars write param; note which vars have an accumulator registered
+ * @param changed        write param, vars which have been replaced
  *
  * @return Number of substitutions performed;
  *
@@ -434,7 +476,7 @@ bool combineImmediates(Liveness &live, Instr::List &instrs) {
  *   and to ignore the variable replacement due to acc usage later on. There may still be instances
  *   of the variable that need replacing.
  */
-int introduceAccum(Liveness &live, Instr::List &instrs) {
+int introduceAccum(Liveness &live, Instr::List &instrs, RegIdSet &changed) {
   RegUsage &allocated_vars = live.reg_usage();
 
 #ifdef DEBUG
@@ -450,7 +492,7 @@ int introduceAccum(Liveness &live, Instr::List &instrs) {
   // Picks up a lot usually, but range_size > 1 seldom results in something
   //Timer t("peephole_0");
   for (int range_size = 1; range_size <= MAX_RANGE_SIZE; range_size++) {
-    int count = peephole_0(range_size, instrs, allocated_vars);
+    int count = peephole_0(range_size, live, instrs, allocated_vars, changed);
 
 /*
     if (count > 0 && range_size > 1) {
@@ -467,7 +509,7 @@ int introduceAccum(Liveness &live, Instr::List &instrs) {
   // This peephole still does a lot of useful stuff
   {
     //Timer t("peephole_1", true);
-    int count = peephole_1(live, instrs, allocated_vars);
+    int count = peephole_1(live, instrs, allocated_vars, changed);
 
 /*
     {
@@ -483,7 +525,7 @@ int introduceAccum(Liveness &live, Instr::List &instrs) {
   // And some things still get done with this peephole, regularly 1 or 2 per compile
   {
     //Timer t("peephole_2", true);
-    int count = peephole_2(live, instrs, allocated_vars);
+    int count = peephole_2(live, instrs, allocated_vars, changed);
 /*
     if (count > 0) {
       std::string msg;
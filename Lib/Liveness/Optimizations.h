@@ -6,8 +6,8 @@ namespace V3DLib {
 
 class Liveness;
 
-bool combineImmediates(Liveness &live, Instr::List &instrs);
-int introduceAccum(Liveness &live, Instr::List &instrs);
+bool combineImmediates(Liveness &live, Instr::List &instrs, RegIdSet &changed);
+int introduceAccum(Liveness &live, Instr::List &instrs, RegIdSet &changed);
 
 }  // namespace V3DLib
 
@@ -285,7 +285,7 @@ void RegUsage::set_live(Liveness &live) {
  *
  * If anything is detected here, it is a compile error.
  */
-void RegUsage::check() const {
+void RegUsage::check(CFG const &cfg) const {
   std::string ret;
 
   // Case 'instruction variables which are assigned but never used'
@@ -314,6 +314,10 @@ void RegUsage::check() const {
       if (!item.regular_use())   continue;
       if (item.never_assigned()) continue;  // Tested in previous block
 
+      // Results of subroutines are assigned after the call sites in the instruction list
+      int entry = cfg.subroutine_at(item.first_dst());
+      if (entry != -1 && item.first_live() < entry) continue;
+
       if (item.first_live() <= item.first_dst()) {
         tmp << "  Variable " << i << " is live before first assignment" << "\n";
       }
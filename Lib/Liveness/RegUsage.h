@@ -39,6 +39,7 @@ private:
 
 
 class Liveness;
+class CFG;
 
 struct RegUsage : private std::vector<RegUsageItem> {
   using Parent = std::vector<RegUsageItem>;
@@ -51,7 +52,7 @@ struct RegUsage : private std::vector<RegUsageItem> {
   void set_used(Instr::List &instrs);
   void set_live(Liveness &live);
   std::string dump(bool verbose = false) const;
-  void check() const;
+  void check(CFG const &cfg) const;
   std::string dump_use_ranges() const;
   void check_overlap_usage(Reg acc, RegUsageItem const &item) const;
 
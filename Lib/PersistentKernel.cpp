@@ -0,0 +1,472 @@
+#include "PersistentKernel.h"
+#include <climits>
+#include "LibSettings.h"
+#include "Source/Lang.h"
+#include "Support/Platform.h"
+#include "vc4/DMA/Operations.h"
+
+namespace V3DLib {
+namespace persistent {
+namespace {
+
+/**
+ * Read a block of 16 words from the command ring
+ *
+ * On vc4, this uses DMA, so that the reads do not hit stale lines in the TMU cache
+ * while polling.
+ */
+IntExpr read_block(Int::Ptr &p) {
+  Int ret;
+
+  if (Platform::compiling_for_vc4()) {
+    dmaSetReadPitch(4);                  comment("Read command block with DMA");
+    dmaSetupRead(HORIZ, 1, me() << 4);   // VPM row me(), address is (row, column)
+    dmaStartRead(p);
+    dmaWaitRead();
+    vpmSetupRead(HORIZ, 1, me());
+    ret = vpmGetInt();
+  } else {
+    ret = *p;
+  }
+
+  return ret;
+}
+
+
+/**
+ * Main loop of the resident kernel
+ *
+ * Waits for the command with the expected sequence number in the next slot,
+ * or a stop command. After running the kernel function, the sequence number
+ * is posted in the completion block of the QPU.
+ */
+void resident_loop(
+  Int::Ptr &queue, Int &first_seq, Int &first_slot,
+  int num_uniforms, int queue_size, std::function<void(Int::Ptr &args)> const &body
+) {
+  int const slot_size   = 16*(1 + num_uniforms);
+  int const done_offset = queue_size*slot_size;
+
+  Int seq  = first_seq;                  header("Start resident kernel loop");
+  Int slot = first_slot;
+  Int::Ptr done = queue + (done_offset + me()*16);
+  Int cmd  = 0;
+
+  While (cmd != BasePersistentKernel::STOP)
+    Int::Ptr hdr = queue + slot*slot_size;
+    cmd = read_block(hdr);
+
+    While (cmd != seq && cmd != BasePersistentKernel::STOP)
+      cmd = read_block(hdr);
+    End
+
+    If (cmd == seq)
+      Int::Ptr args = hdr + 16;
+      body(args);                        header("End of kernel function");
+
+      *done = seq;
+      if (Platform::compiling_for_vc4()) {
+        dmaWaitWrite();                  comment("Post completion now, not on the next store");
+      }
+
+      seq++;
+      slot++;
+
+      If (slot == queue_size)
+        slot = 0;
+      End
+    End
+  End
+}
+
+}  // anon namespace
+
+
+/**
+ * Read the next argument block of a command
+ */
+IntExpr next_arg(Int::Ptr &p) {
+  Int ret = read_block(p);
+  p += 16;
+  return ret;
+}
+
+}  // namespace persistent
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class BasePersistentKernel
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // anon namespace
+
+
+/**
+ * @param num_uniforms  number of uniform values passed per command
+ * @param queue_size    number of slots in the command ring
+ * @param body          reads the kernel parameters from the argument blocks and calls the kernel function
+ */
+BasePersistentKernel::BasePersistentKernel(int num_uniforms, int queue_size, Body body) :
+  m_num_uniforms(num_uniforms),
+  m_queue_size(queue_size),
+  m_kernel(
+    std::function<void(Int::Ptr, Int, Int)>([num_uniforms, queue_size, body] (Int::Ptr queue, Int seq, Int slot) {
+      persistent::resident_loop(queue, seq, slot, num_uniforms, queue_size, body);
+    }),
+    BOTH
+  )
+{
+  assertq(queue_size >= 2, "PersistentKernel: need at least two slots in the command ring", true);
+  assertq(!m_kernel.has_errors(), "PersistentKernel: there were errors during compile", true);
+
+  m_idle_timeout  = 0.5*LibSettings::qpu_timeout();
+  m_last_activity = Clock::now();
+  m_watchdog = std::thread([this] { watch(); });
+}
+
+
+BasePersistentKernel::~BasePersistentKernel() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_cv.notify_all();
+  m_watchdog.join();
+
+  try {
+    stop();
+  } catch (...) {
+    // Errors of the last run can not be reported from a dtor
+  }
+}
+
+
+BasePersistentKernel &BasePersistentKernel::setNumQPUs(int n) {
+  if (n != m_numQPUs) {
+    stop();
+    m_numQPUs = n;
+  }
+
+  return *this;
+}
+
+
+/**
+ * Set the time after which an idle resident kernel is stopped.
+ *
+ * Default is half the QPU timeout.
+ */
+void BasePersistentKernel::idle_timeout(double seconds) {
+  assertq(seconds > 0, "PersistentKernel: idle timeout must be positive", true);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_idle_timeout = seconds;
+}
+
+
+bool BasePersistentKernel::resident() const {
+  return !m_exited;
+}
+
+
+/**
+ * Run the loaded parameters as a command and wait for it to complete.
+ *
+ * Depending on QPU_MODE, the kernel runs on the QPUs or the emulator, as for `Kernel::call()`.
+ */
+void BasePersistentKernel::call() {
+  set_mode(false);
+  wait(submit());
+}
+
+
+/**
+ * Same as `call()`, but always run on the emulator
+ */
+void BasePersistentKernel::emu() {
+  set_mode(true);
+  wait(submit());
+}
+
+
+/**
+ * Post the loaded parameters as a command, without waiting for completion.
+ *
+ * Blocks if the command ring is full.
+ *
+ * @return sequence number of the command, for `wait()`
+ */
+int BasePersistentKernel::submit() {
+  assertq((int) uniforms.size() == m_num_uniforms, "PersistentKernel: load() the parameters before submitting", true);
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  int const seq = m_next_seq;
+
+  if (single_shot()) {
+    // Post the command followed by a stop, and run till done
+    alloc_queue();
+    int offset = slot_offset(seq);
+    for (int i = 0; i < m_num_uniforms; i++) {
+      write_block(offset + 16*(i + 1), uniforms[i]);
+    }
+    write_block(offset, seq);
+    m_next_seq++;
+
+    write_block(slot_offset(m_next_seq), STOP);
+    m_stop_posted = true;
+
+    launch();
+    join();
+    return seq;
+  }
+
+  ensure_running();
+
+  while (completed() <= seq - m_queue_size) {  // Wait till the slot is free
+    if (m_exited) ensure_running();
+    std::this_thread::yield();
+  }
+
+  int offset = slot_offset(seq);
+  for (int i = 0; i < m_num_uniforms; i++) {
+    write_block(offset + 16*(i + 1), uniforms[i]);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);  // Arguments must be visible before the header
+  write_block(offset, seq);
+
+  m_next_seq++;
+  m_last_activity = Clock::now();
+  return seq;
+}
+
+
+/**
+ * Wait till the command with given sequence number has completed on all QPUs
+ */
+void BasePersistentKernel::wait(int seq) {
+  assertq(seq < m_next_seq, "PersistentKernel: waiting for a command which was not submitted", true);
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (completed() < seq) {
+    if (m_exited) {
+      join();  // Rethrows any error
+
+      // The kernel may have stopped on idle before seeing the command
+      if (completed() < seq) launch();
+    }
+
+    std::this_thread::yield();
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  m_last_activity = Clock::now();
+}
+
+
+/**
+ * Stop the resident kernel, after it has run all submitted commands.
+ */
+void BasePersistentKernel::stop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if (!m_exited && !m_stop_posted) {
+    post_stop();
+  }
+
+  join();
+}
+
+
+bool BasePersistentKernel::single_shot() const {
+#ifdef QPU_MODE
+  return !m_use_emu && !Platform::use_main_memory() && !Platform::has_vc4();
+#else
+  return false;
+#endif
+}
+
+
+void BasePersistentKernel::set_mode(bool use_emu) {
+  if (use_emu != m_use_emu) {
+    stop();
+    m_use_emu = use_emu;
+  }
+}
+
+
+/**
+ * @return highest sequence number completed by all QPUs
+ */
+int BasePersistentKernel::completed() const {
+  if (!m_resident.joinable()) return m_done_seq;
+  return read_completed();
+}
+
+
+/**
+ * Get the last sequence number completed by all QPUs from the completion blocks
+ */
+int BasePersistentKernel::read_completed() const {
+  int const volatile *q = m_queue.ptr();
+  int ret = INT_MAX;
+
+  for (int i = 0; i < m_numQPUs; i++) {
+    ret = std::min(ret, (int) q[done_offset() + 16*i]);
+  }
+
+  return ret;
+}
+
+
+/**
+ * Write a value replicated over a block of 16 words in the command ring
+ */
+void BasePersistentKernel::write_block(int offset, int val) {
+  int volatile *q = m_queue.ptr();
+
+  for (int i = 0; i < 16; i++) {
+    q[offset + i] = val;
+  }
+}
+
+
+/**
+ * Start the resident kernel on a host thread, at the first command not completed.
+ *
+ * Must be called with the lock held, with no kernel running.
+ */
+void BasePersistentKernel::launch() {
+  assert(m_exited);
+  assert(!m_resident.joinable());
+
+  alloc_queue();
+
+  // The completion blocks may be stale from a run with another number of QPUs
+  for (int i = 0; i < m_numQPUs; i++) {
+    write_block(done_offset() + 16*i, m_done_seq);
+  }
+
+  int seq = m_done_seq + 1;
+  m_kernel.setNumQPUs(m_numQPUs);
+  m_kernel.load(&m_queue, seq, slot_offset(seq)/slot_size());
+
+  m_error = nullptr;
+  m_exited = false;
+  m_launches++;
+  m_launch_time   = Clock::now();
+  m_last_activity = m_launch_time;
+
+  m_resident = std::thread([this] {
+    try {
+      if (m_use_emu) {
+        m_kernel.emu();
+      } else {
+        m_kernel.call();
+      }
+    } catch (...) {
+      m_error = std::current_exception();
+    }
+
+    m_exited = true;
+  });
+}
+
+
+/**
+ * Allocate the command ring and completion blocks, if not large enough for the current number of QPUs.
+ *
+ * Must be called with no kernel running.
+ */
+void BasePersistentKernel::alloc_queue() {
+  uint32_t size = (uint32_t) (done_offset() + 16*m_numQPUs);
+  if (m_queue.size() >= size) return;
+
+  if (m_queue.allocated()) {
+    m_queue.dealloc();
+  }
+
+  m_queue.alloc(size);
+  m_queue.fill(0);
+}
+
+
+/**
+ * Post a stop command in the slot for the next command.
+ *
+ * The kernel first runs all commands before it.
+ */
+void BasePersistentKernel::post_stop() {
+  while (!m_exited && completed() <= m_next_seq - m_queue_size) {  // Wait till the slot is free
+    std::this_thread::yield();
+  }
+
+  write_block(slot_offset(m_next_seq), STOP);
+  m_stop_posted = true;
+}
+
+
+/**
+ * Wait for the kernel thread to finish, and rethrow any error it had.
+ */
+void BasePersistentKernel::join() {
+  if (m_resident.joinable()) {
+    m_resident.join();
+    m_done_seq = read_completed();
+  }
+
+  if (m_stop_posted) {
+    write_block(slot_offset(m_next_seq), 0);
+    m_stop_posted = false;
+  }
+
+  if (m_error) {
+    auto err = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(err);
+  }
+}
+
+
+/**
+ * Make sure the resident kernel is running.
+ *
+ * On the QPUs, the kernel is relaunched if it is close to the QPU timeout.
+ */
+void BasePersistentKernel::ensure_running() {
+  if (!m_exited && !m_use_emu && seconds_since(m_launch_time) > 0.5*LibSettings::qpu_timeout()) {
+    if (!m_stop_posted) post_stop();
+  }
+
+  if (m_stop_posted || m_exited) {
+    join();
+    launch();
+  }
+}
+
+
+/**
+ * Stop the resident kernel when it has been idle for longer than the idle timeout.
+ *
+ * Runs on a separate thread.
+ */
+void BasePersistentKernel::watch() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (!m_shutdown) {
+    m_cv.wait_for(lock, std::chrono::milliseconds(50));
+    if (m_shutdown || m_exited || m_stop_posted) continue;
+
+    if (seconds_since(m_last_activity) > m_idle_timeout && completed() == m_next_seq - 1) {
+      post_stop();
+    }
+  }
+}
+
+}  // namespace V3DLib
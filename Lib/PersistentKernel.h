@@ -0,0 +1,193 @@
+#ifndef _V3DLIB_PERSISTENTKERNEL_H_
+#define _V3DLIB_PERSISTENTKERNEL_H_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include "Kernel.h"
+
+namespace V3DLib {
+
+/**
+ * Kernel which stays resident on the QPUs between calls
+ *
+ * Every call of a normal kernel is a full launch, which is costly in comparison
+ * to small workloads. A persistent kernel is launched once, and then polls a
+ * command ring in the shared heap for work. The host API is the same as for `Kernel`:
+ *
+ *    auto k = compile_persistent(kernel);
+ *    k.load(n, &a).call();
+ *    k.load(m, &b).call();         // No relaunch, the kernel is still running
+ *
+ * Every command is a slot in the ring, containing a sequence number and the kernel
+ * arguments. After running the kernel function, every QPU posts the sequence
+ * number back in its completion block. `submit()` and `wait()` allow for
+ * having multiple commands in flight, up to the size of the ring.
+ *
+ * The kernel is stopped when it has been idle for a while, and is relaunched
+ * transparently on the next call. On the QPUs, this keeps it within the QPU timeout.
+ *
+ * - The emulator runs the resident kernel on a host thread.
+ *   Do not run other kernels on the emulator while it is running.
+ * - The interpreter is not supported, the ring is read with DMA on vc4.
+ * - vc4: the ring is read with DMA, which bypasses the TMU cache. The TMU cache is
+ *        only cleared on launch; the kernel function should not use the TMU to load
+ *        data which the host changes between calls.
+ * - v3d: the TMU reads of the ring are not coherent with host writes while a job runs.
+ *        On v3d hardware, every call is therefore still a launch, which runs
+ *        the command and stops.
+ */
+class BasePersistentKernel {
+public:
+  static int const STOP = -1;   // Header value for stopping the kernel
+
+  BasePersistentKernel(BasePersistentKernel const &k) = delete;
+  ~BasePersistentKernel();
+
+  BasePersistentKernel &setNumQPUs(int n);
+  int numQPUs() const { return m_numQPUs; }
+  void idle_timeout(double seconds);
+  int launches() const { return m_launches; }
+  bool resident() const;
+
+  void call();
+  void emu();
+  int submit();
+  void wait(int seq);
+  void stop();
+
+protected:
+  using Body = std::function<void(Int::Ptr &args)>;
+
+  IntList uniforms;                // Parameters for the next command
+
+  BasePersistentKernel(int num_uniforms, int queue_size, Body body);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  int m_num_uniforms;
+  int m_queue_size;
+  int m_numQPUs = 1;
+  bool m_use_emu = false;
+  Kernel<Int::Ptr, Int, Int> m_kernel;
+  Int::Array m_queue;
+
+  // State of the ring
+  int m_next_seq    = 1;          // Sequence number of next command
+  int m_done_seq    = 0;          // Last completed command when no kernel is running
+  bool m_stop_posted = false;
+
+  // Resident kernel
+  std::thread m_resident;
+  std::atomic<bool> m_exited{true};
+  std::exception_ptr m_error;
+  int m_launches = 0;
+  Clock::time_point m_launch_time;
+
+  // Stopping when idle
+  std::thread m_watchdog;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_shutdown = false;
+  double m_idle_timeout;          // seconds
+  Clock::time_point m_last_activity;
+
+  int slot_size() const  { return 16*(1 + m_num_uniforms); }
+  int slot_offset(int seq) const { return ((seq - 1) % m_queue_size)*slot_size(); }
+  int done_offset() const { return m_queue_size*slot_size(); }
+  bool single_shot() const;
+  void set_mode(bool use_emu);
+  int completed() const;
+  int read_completed() const;
+  void alloc_queue();
+  void write_block(int offset, int val);
+  void launch();
+  void post_stop();
+  void join();
+  void ensure_running();
+  void watch();
+};
+
+
+namespace persistent {
+
+IntExpr next_arg(Int::Ptr &p);
+
+/**
+ * Construct kernel parameters from the argument blocks of a command.
+ *
+ * Same as `mkArg()` for uniforms. The host writes the values of the uniforms
+ * replicated over 16 words, so that every lane reads the same value.
+ */
+template <typename T> struct Arg;
+
+template <> struct Arg<Int> {
+  static Int get(Int::Ptr &p) { Int x = next_arg(p); return x; }
+};
+
+template <> struct Arg<Float> {
+  static Float get(Int::Ptr &p) { Float x; x.as_float(next_arg(p)); return x; }
+};
+
+template <typename T> struct Arg<ptr::Ptr<T>> {
+  static ptr::Ptr<T> get(Int::Ptr &p) {
+    Int addr = next_arg(p);
+    ptr::Ptr<T> x = PtrExpr<T>((addr + (index() << 2)).expr());  // Pre-offset like uniform pointers
+    return x;
+  }
+};
+
+template <> struct Arg<Complex::Ptr> {
+  static Complex::Ptr get(Int::Ptr &p) {
+    Float::Ptr re = Arg<Float::Ptr>::get(p);
+    Float::Ptr im = Arg<Float::Ptr>::get(p);
+    Complex::Ptr x = Complex::Ptr::Expr(re, im);
+    return x;
+  }
+};
+
+}  // namespace persistent
+
+
+template <typename... ts>
+class PersistentKernel : public BasePersistentKernel {
+public:
+  using KernelFunction = void (*)(ts... params);
+
+  PersistentKernel(KernelFunction f, int queue_size = 8) :
+    BasePersistentKernel(param_uniforms<ts...>(), queue_size, [f] (Int::Ptr &args) {
+      // Braced init, so that the arguments are read in order
+      std::tuple<ts...> params { persistent::Arg<ts>::get(args)... };
+      std::apply(f, params);
+    })
+  {}
+
+
+  /**
+   * Load uniform values for the next command.
+   *
+   * Same as `Kernel::load()`, except that the order of the values is fixed:
+   * braced init evaluates left to right, as for reading them in the kernel.
+   */
+  template <typename... us>
+  PersistentKernel &load(us... args) {
+    uniforms.clear();
+    (void) std::initializer_list<bool> { passParam<ts, us>(uniforms, args)... };
+    return *this;
+  }
+};
+
+
+template <typename... ts>
+PersistentKernel<ts...> compile_persistent(void (*f)(ts... params), int queue_size = 8) {
+  return PersistentKernel<ts...>(f, queue_size);
+}
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_PERSISTENTKERNEL_H_
@@ -0,0 +1,163 @@
+#include "Atomic.h"
+#include "Lang.h"
+#include "StmtStack.h"
+#include "Support/Platform.h"
+#include "Support/basics.h"
+#include "vc4/DMA/Operations.h"
+
+namespace V3DLib {
+namespace {
+
+int const ATOMIC_SEMA = 14;  // vc4 semaphore used as mutex; 15 is used for kernel termination
+int const VPM_ROW     = 63;  // VPM row for writing back values, only used while holding the mutex
+
+bool m_used = false;
+
+
+IntExpr apply(Stmt::Atomic::Op op, Int const &cur, Int const &val, Int const &cmp) {
+  switch (op) {
+    case Stmt::Atomic::ADD:      return cur + val;
+    case Stmt::Atomic::MIN:      return min(cur, val);
+    case Stmt::Atomic::MAX:      return max(cur, val);
+    case Stmt::Atomic::EXCHANGE: return val;
+    case Stmt::Atomic::CMPXCHG: {
+      Int next = cur;
+      Where (cur == cmp)
+        next = val;
+      End
+      return next;
+    }
+  }
+
+  assert(false);
+  return cur;
+}
+
+
+/**
+ * Generate the vc4 code for an atomic operation.
+ *
+ * vc4 has no atomic memory operations. Instead, the operation is done while holding
+ * a hardware semaphore which serves as a global mutex.
+ *
+ * Lanes are handled one by one, the current lane is rotated into the first element.
+ * The value of the current lane is read with a DMA load and written back with a DMA store
+ * of a single word, so that lanes with the same address see each other's results.
+ * Both go through VPM row `VPM_ROW`. The TMU is not used, its cache is not updated
+ * by the DMA stores of other QPUs.
+ */
+void lower_vc4(Stmt::Atomic const &a) {
+  bool const has_cmp = (a.op == Stmt::Atomic::CMPXCHG);
+
+  Int addr = IntExpr(a.addr);  header(Stmt::Atomic::name(a.op));
+  Int val  = IntExpr(a.val);
+  Int cmp  = has_cmp? IntExpr(a.cmp) : IntExpr(0);
+  Int old  = 0;
+
+  semaDec(ATOMIC_SEMA);       comment("Acquire atomics mutex");
+  dmaWaitWrite();             comment("Ensure preceding stores have completed");
+
+  For (Int i = 0, i < 16, i++)
+    dmaSetupRead(HORIZ, 1, 16*VPM_ROW, 1);
+    dmaStartReadExpr(addr.expr());
+    dmaWaitRead();
+    vpmSetupRead(HORIZ, 1, VPM_ROW);
+    Int cur = vpmGetInt();
+
+    Where (index() == 0)
+      old = cur;
+    End
+
+    vpmSetupWrite(HORIZ, VPM_ROW);
+    vpmPut(apply(a.op, cur, val, cmp));
+    dmaSetupWrite(HORIZ, 1, 16*VPM_ROW, 1);
+    dmaStartWriteExpr(addr.expr());
+    dmaWaitWrite();
+
+    // Next lane to first element; after 16 iterations, all lanes are back in place
+    addr = rotate(addr, 15);
+    val  = rotate(val, 15);
+    old  = rotate(old, 15);
+    if (has_cmp) cmp = rotate(cmp, 15);
+  End
+
+  semaInc(ATOMIC_SEMA);       comment("Release atomics mutex");
+  stmtStack() << Stmt::create_assign(mkVar(a.dst), old.expr());
+}
+
+}  // anon namespace
+
+
+namespace atomics {
+
+/**
+ * Needs to be called for every kernel compilation.
+ */
+void reset() {
+  m_used = false;
+}
+
+
+/**
+ * @return true if atomic operations were used in the kernel being compiled
+ */
+bool used() {
+  return m_used;
+}
+
+
+/**
+ * Emit the initialization of the mutex for atomics on vc4.
+ *
+ * The semaphore is zero on kernel start, QPU 0 increments it once.
+ * Other QPUs block on acquiring it until this has happened.
+ */
+void init_mutex() {
+  assert(Platform::compiling_for_vc4());
+
+  If (me() == 0)
+    semaInc(ATOMIC_SEMA);   comment("Initialize atomics mutex");
+  End
+}
+
+
+/**
+ * Reset the mutex for atomics on vc4 to zero.
+ *
+ * Needs to be called by QPU 0 after all other QPUs have finished.
+ */
+void release_mutex() {
+  assert(Platform::compiling_for_vc4());
+  semaDec(ATOMIC_SEMA);     comment("Reset atomics mutex");
+}
+
+
+/**
+ * Create an atomic operation.
+ *
+ * On vc4, the operation is lowered here. v3d has TMU atomic operations, these are
+ * generated in the v3d source translation.
+ *
+ * @return the values in memory before the operation
+ */
+IntExpr create(Stmt::Atomic::Op op, Expr::Ptr addr, IntExpr val, Expr::Ptr cmp) {
+  m_used = true;
+
+  Int old;
+  auto a = std::make_shared<Stmt::Atomic>();
+  a->op   = op;
+  a->dst  = old.expr()->var();
+  a->addr = addr;
+  a->val  = val.expr();
+  a->cmp  = cmp;
+
+  if (Platform::compiling_for_vc4()) {
+    a->body = tempStmt([&a] { lower_vc4(*a); });
+  }
+
+  stmtStack() << Stmt::create_atomic(a);
+  return old;
+}
+
+}  // namespace atomics
+}  // namespace V3DLib
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// This module defines atomic read-modify-write operations on memory.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _V3DLIB_SOURCE_ATOMIC_H_
+#define _V3DLIB_SOURCE_ATOMIC_H_
+#include "Int.h"
+#include "Stmt.h"
+
+namespace V3DLib {
+
+namespace atomics {
+
+void reset();
+bool used();
+void init_mutex();
+void release_mutex();
+
+IntExpr create(Stmt::Atomic::Op op, Expr::Ptr addr, IntExpr val, Expr::Ptr cmp = nullptr);
+
+}  // namespace atomics
+
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+//
+// All operations work on the per-lane addresses of the pointer, as with `gather()`,
+// and return the values in memory before the operation.
+//
+
+inline IntExpr atomic_add(PtrExpr<Int> addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::ADD, addr.expr(), val);
+}
+
+inline IntExpr atomic_add(Int::Ptr &addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::ADD, addr.expr(), val);
+}
+
+inline IntExpr atomic_min(PtrExpr<Int> addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::MIN, addr.expr(), val);
+}
+
+inline IntExpr atomic_min(Int::Ptr &addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::MIN, addr.expr(), val);
+}
+
+inline IntExpr atomic_max(PtrExpr<Int> addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::MAX, addr.expr(), val);
+}
+
+inline IntExpr atomic_max(Int::Ptr &addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::MAX, addr.expr(), val);
+}
+
+inline IntExpr atomic_exchange(PtrExpr<Int> addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::EXCHANGE, addr.expr(), val);
+}
+
+inline IntExpr atomic_exchange(Int::Ptr &addr, IntExpr val) {
+  return atomics::create(Stmt::Atomic::EXCHANGE, addr.expr(), val);
+}
+
+inline IntExpr atomic_cmpxchg(PtrExpr<Int> addr, IntExpr expected, IntExpr val) {
+  return atomics::create(Stmt::Atomic::CMPXCHG, addr.expr(), val, expected.expr());
+}
+
+inline IntExpr atomic_cmpxchg(Int::Ptr &addr, IntExpr expected, IntExpr val) {
+  return atomics::create(Stmt::Atomic::CMPXCHG, addr.expr(), val, expected.expr());
+}
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_ATOMIC_H_
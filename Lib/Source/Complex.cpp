@@ -1,6 +1,8 @@
 #include "Complex.h"
 #include <cmath>
+#include <vector>
 #include "Support/basics.h"
+#include "Support/interleave.h"
 #include "Functions.h"  // ::set_at()
 #include "gather.h"
 
@@ -318,11 +320,125 @@ Complex::Array::ref Complex::Array::operator[] (int i) const {
 }
 
 
+void Complex::Array::copy_from_interleaved(float const *src, size_t offset, size_t count) {
+  assertq(offset + count <= size(), "Complex::Array: too many values for array", true);
+  deinterleave(src, m_re.ptr() + offset, m_im.ptr() + offset, count);
+}
+
+
+void Complex::Array::copy_to_interleaved(float *dst, size_t offset, size_t count) const {
+  assertq(offset + count <= size(), "Complex::Array: more values requested than in array", true);
+  interleave(m_re.ptr() + offset, m_im.ptr() + offset, dst, count);
+}
+
+
+/**
+ * Read interleaved 32-bit float values (I/Q pairs) from a file, until the array is full
+ *
+ * @return number of complex values read
+ */
+size_t Complex::Array::read(FILE *f) {
+  size_t const CHUNK = 4096;
+  std::vector<float> buf(2*CHUNK);
+  size_t total = 0;
+
+  while (total < size()) {
+    size_t count = fread(buf.data(), 2*sizeof(float), std::min(CHUNK, size() - total), f);
+    if (count == 0) break;
+
+    copy_from_interleaved(buf.data(), total, count);
+    total += count;
+  }
+
+  return total;
+}
+
+
+/**
+ * Write the first `count` values as interleaved 32-bit float values to a file
+ */
+bool Complex::Array::write(FILE *f, size_t count) const {
+  size_t const CHUNK = 4096;
+  std::vector<float> buf(2*CHUNK);
+
+  for (size_t done = 0; done < count;) {
+    size_t n = std::min(CHUNK, count - done);
+    copy_to_interleaved(buf.data(), done, n);
+
+    if (fwrite(buf.data(), 2*sizeof(float), n, f) != n) return false;
+    done += n;
+  }
+
+  return true;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Class Complex::2DArray
 ///////////////////////////////////////////////////////////////////////////////
 
-Complex::Array2D::Array2D(int rows, int columns) : m_re(rows, columns),  m_im(rows, columns) {}
+Complex::Array2D::Array2D(int rows, int columns, Layout2D const &layout) :
+  m_re(rows, columns, layout),
+  m_im(rows, columns, layout)
+{}
+
+/**
+ * Call `f` for every range of consecutive values in memory, in row-major order.
+ *
+ * `offset` is the position in the arrays, `index` the row-major index of the first value.
+ */
+void Complex::Array2D::for_segments(Segment f) const {
+  auto const &layout = m_re.layout();
+  bool whole_rows = (layout.type() == Layout2D::ROW_MAJOR || layout.type() == Layout2D::PADDED);
+  int  seg_size   = whole_rows? columns() : Layout2D::TILE;  // 16 columns are consecutive in all layouts
+
+  for (int r = 0; r < rows(); r++) {
+    for (int c = 0; c < columns(); c += seg_size) {
+      f(layout.offset(r, c), r*columns() + c, std::min(seg_size, columns() - c));
+    }
+  }
+}
+
+
+void Complex::Array2D::copy_from_interleaved(float const *src) {
+  float *re = m_re.ptr();
+  float *im = m_im.ptr();
+
+  for_segments([src, re, im] (int offset, int index, int count) {
+    deinterleave(src + 2*index, re + offset, im + offset, count);
+  });
+}
+
+
+void Complex::Array2D::copy_to_interleaved(float *dst) const {
+  float const *re = m_re.ptr();
+  float const *im = m_im.ptr();
+
+  for_segments([dst, re, im] (int offset, int index, int count) {
+    interleave(re + offset, im + offset, dst + 2*index, count);
+  });
+}
+
+
+/**
+ * Read `rows()*columns()` interleaved 32-bit float values (I/Q pairs) from a file, in row-major order
+ *
+ * @return number of complex values read
+ */
+size_t Complex::Array2D::read(FILE *f) {
+  std::vector<float> buf(2*rows()*columns());
+  size_t count = fread(buf.data(), 2*sizeof(float), buf.size()/2, f);
+  copy_from_interleaved(buf.data());  // Values beyond count are zero
+  return count;
+}
+
+
+bool Complex::Array2D::write(FILE *f) const {
+  std::vector<float> buf(2*rows()*columns());
+  copy_to_interleaved(buf.data());
+  return fwrite(buf.data(), 2*sizeof(float), buf.size()/2, f) == buf.size()/2;
+}
+
 
 void Complex::Array2D::fill(complex val) {
   m_re.fill(val.re());
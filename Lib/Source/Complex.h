@@ -1,5 +1,8 @@
 #ifndef _V3DLIB_SOURCE_COMPLEX_H_
 #define _V3DLIB_SOURCE_COMPLEX_H_
+#include <cstdio>
+#include <functional>
+#include <type_traits>
 #include "Int.h"
 #include "Float.h"
 
@@ -8,6 +11,16 @@ namespace V3DLib {
 class Complex;
 
 
+/**
+ * Check if a type can be used as interleaved complex value, e.g. `std::complex<float>`
+ */
+template<typename T>
+inline void check_interleaved_type() {
+  static_assert(sizeof(T) == 2*sizeof(float) && std::is_trivially_copyable<T>::value,
+    "Expecting interleaved complex type with two float members");
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Class ComplexExpr
 ///////////////////////////////////////////////////////////////////////////////
@@ -154,22 +167,43 @@ public:
     ref operator[] (int i);
     ref operator[] (int i) const;  // grumbl
 
+    /**
+     * Bulk copy from interleaved complex values, e.g. `std::complex<float>`
+     */
+    template<typename T>
+    void copyFrom(T const *src, size_t count) {
+      check_interleaved_type<T>();
+      copy_from_interleaved((float const *) src, 0, count);
+    }
+
+    template<typename T>
+    void copyTo(T *dst, size_t count) const {
+      check_interleaved_type<T>();
+      copy_to_interleaved((float *) dst, 0, count);
+    }
+
+    size_t read(FILE *f);
+    bool write(FILE *f, size_t count) const;
+
   private:
     Float::Array m_re;
     Float::Array m_im;
+
+    void copy_from_interleaved(float const *src, size_t offset, size_t count);
+    void copy_to_interleaved(float *dst, size_t offset, size_t count) const;
   };
 
 
   class Array2D {
     struct Row {
-      Row(Array2D &parent, int row, int row_size) :
-        m_re(&parent.re(), row, row_size),
-        m_im(&parent.im(), row, row_size)
+      Row(Array2D &parent, int row) :
+        m_re(&parent.re(), row),
+        m_im(&parent.im(), row)
         {}
 
-      Row(Array2D const &parent, int row, int row_size) :
-        m_re(&parent.re(), row, row_size),
-        m_im(&parent.im(), row, row_size)
+      Row(Array2D const &parent, int row) :
+        m_re(&parent.re(), row),
+        m_im(&parent.im(), row)
         {}
 
       ~Row() {
@@ -197,7 +231,7 @@ public:
 
   public:
     Array2D() = default;
-    Array2D(int rows, int columns);
+    Array2D(int rows, int columns, Layout2D const &layout = Layout2D());
     Array2D(int dimension) : Array2D(dimension, dimension) {}
 
     Float::Array2D &re() { return m_re; }
@@ -209,22 +243,46 @@ public:
     int rows() const;
     int columns() const;
 
-    void alloc(uint32_t rows, uint32_t columns) {
-      m_re.alloc(rows, columns);
-      m_im.alloc(rows, columns);
+    void alloc(uint32_t rows, uint32_t columns, Layout2D const &layout = Layout2D()) {
+      m_re.alloc(rows, columns, layout);
+      m_im.alloc(rows, columns, layout);
     }
 
     bool allocated() const { return m_re.allocated() && m_im.allocated(); }
 
-    Row operator[] (int row) { return Row(*this, row, columns()); }
-    Row operator[] (int row) const { return Row(*this, row, columns()); }  // grumbl
+    Row operator[] (int row) { return Row(*this, row); }
+    Row operator[] (int row) const { return Row(*this, row); }  // grumbl
 
     void make_unit_matrix();
     std::string dump() const;
 
+    /**
+     * Bulk copy from `rows()*columns()` interleaved complex values in row-major order
+     */
+    template<typename T>
+    void copyFrom(T const *src) {
+      check_interleaved_type<T>();
+      copy_from_interleaved((float const *) src);
+    }
+
+    template<typename T>
+    void copyTo(T *dst) const {
+      check_interleaved_type<T>();
+      copy_to_interleaved((float *) dst);
+    }
+
+    size_t read(FILE *f);
+    bool write(FILE *f) const;
+
   private:
     Float::Array2D m_re;
     Float::Array2D m_im;
+
+    using Segment = std::function<void(int offset, int index, int count)>;
+
+    void for_segments(Segment f) const;
+    void copy_from_interleaved(float const *src);
+    void copy_to_interleaved(float *dst) const;
   };
 
 
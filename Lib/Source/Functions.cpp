@@ -1,17 +1,21 @@
 /******************************************************************************
  * Function Library for functions at the source language level
  *
- * These are not actual functions but generate inlined code.
- * In the kernel code, though, they look like function calls.
+ * The larger functions here are compiled as out-of-line subroutines, which
+ * are emitted once per kernel. The rest generate inlined code.
+ * In the kernel code, they all look like function calls.
  *
  ******************************************************************************/
 #include "Functions.h"
 #include <iostream>
 #include <cmath>
+#include <map>
 #include "Support/Platform.h"
 #include "StmtStack.h"
 #include "Lang.h"
+#include "gather.h"
 #include "LibSettings.h"
+#include "vc4/DMA/Operations.h"
 
 namespace V3DLib {
 namespace functions {
@@ -19,9 +23,137 @@ namespace {
 
 int const MAX_INT = 2147483647;  // Largest positive 32-bit integer that can be negated
 
+using Subroutine = Stmt::Subroutine;
+
+std::map<std::string, Subroutine::Ptr> subroutine_defs;  // Subroutines of the kernel being compiled
+
+
+/**
+ * Get the definition of a subroutine, generating it on first use.
+ *
+ * The callback should generate the body in source lang and set the parameter
+ * and result variables of the passed definition.
+ * The body is generated independently of the current statement stack.
+ */
+Subroutine::Ptr get_subroutine(std::string const &name, std::function<void(Subroutine &)> define) {
+  auto &sub = subroutine_defs[name];
+
+  if (sub.get() == nullptr) {
+    sub = std::make_shared<Subroutine>();
+    sub->name = name;
+
+    Subroutine &def = *sub;
+    def.body = tempStmt([&def, define] { define(def); }, false);
+    assert(!def.body.empty());
+  } else if (sub->body.empty()) {
+    fatal("Recursive calls of subroutines are not supported");
+  }
+
+  return sub;
+}
+
+
+/**
+ * Add a call to given subroutine to the statement stack
+ *
+ * The arguments are assigned to the parameter variables before the call.
+ */
+void call(Subroutine::Ptr sub, std::vector<Expr::Ptr> const &args) {
+  assert(args.size() == sub->params.size());
+
+  for (int i = 0; i < (int) args.size(); i++) {
+    assign(mkVar(sub->params[i]), args[i]);
+  }
+
+  stmtStack() << Stmt::create_call(sub);
+}
+
+
+/**
+ * Call a function with a single parameter as a subroutine.
+ *
+ * Branching is not possible within a `Where`, the function is inlined there.
+ *
+ * The result var of the subroutine is copied, because it is overwritten by
+ * the next call.
+ */
+IntExpr int_subroutine(char const *name, IntExpr arg, std::function<IntExpr (IntExpr)> f) {
+  if (stmtStack().in_where()) {
+    return f(arg);
+  }
+
+  auto sub = get_subroutine(name, [f] (Subroutine &def) {
+    Int param;
+    Int result;
+    result = f(param);
+
+    def.params  = { param.expr()->var() };
+    def.results = { result.expr()->var() };
+  });
+
+  call(sub, { arg.expr() });
+
+  Int ret = IntExpr(mkVar(sub->results[0]));
+  return ret;
+}
+
+
+void integer_division_intern(Int &Q, Int &R, IntExpr in_a, IntExpr in_b);  // Forward declaration
+
+
+FloatExpr cos_intern(FloatExpr x_in, bool extra_precision) {
+  Float x = x_in;
+
+  x -= 0.25f + functions::ffloor(x + 0.25f);  comment("Start cosine");
+  x *= 16.0f * (fabs(x) - 0.5f);
+
+  if (extra_precision) {
+    x += 0.225f * x * (fabs(x) - 1.0f);
+  }
+
+  return x;
+}
+
 } // anon namespace
 
 
+/**
+ * Float version of `int_subroutine()`.
+ *
+ * Exposed for function libraries built on top of this module.
+ */
+FloatExpr float_subroutine(char const *name, FloatExpr arg, std::function<FloatExpr (FloatExpr)> f) {
+  if (stmtStack().in_where()) {
+    return f(arg);
+  }
+
+  auto sub = get_subroutine(name, [f] (Subroutine &def) {
+    Float param;
+    Float result;
+    result = f(param);
+
+    def.params  = { param.expr()->var() };
+    def.results = { result.expr()->var() };
+  });
+
+  call(sub, { arg.expr() });
+
+  Float ret = FloatExpr(mkVar(sub->results[0]));
+  return ret;
+}
+
+
+/**
+ * Clear the subroutine definitions.
+ *
+ * Needs to be called for every kernel compilation, because the definitions
+ * use the variables of the kernel being compiled.
+ */
+void reset_subroutines() {
+  subroutine_defs.clear();
+}
+
+
 /**
  * Ensure a common exit method for function snippets.
  *
@@ -62,7 +194,6 @@ void Return(Float const &val) {
  *
  * Potential other uses:
  *   - memoization
- *   - true functions (currently everything generated inline)
  *
  * Because this uses the global statement stack, it is **not** threadsafe.
  * But then again, nothing using the global statement stack is.
@@ -125,19 +256,21 @@ IntExpr abs(IntExpr a) {
  * a == 0 will return -1.
  */
 IntExpr topmost_bit(IntExpr in_a) {
-  return create_function_snippet([in_a] {
-    Int a = in_a;
-    Int topmost = -1;
-
-    For (Int n = 30, n >= 0, n--)
-      Where (topmost == -1)
-        Where ((a & (1 << n)) != 0)
-          topmost = n;
+  return int_subroutine("topmost_bit", in_a, [] (IntExpr in_a) {
+    return create_function_snippet([in_a] {
+      Int a = in_a;
+      Int topmost = -1;
+
+      For (Int n = 30, n >= 0, n--)
+        Where (topmost == -1)
+          Where ((a & (1 << n)) != 0)
+            topmost = n;
+          End
         End
       End
-    End
 
-    Return(topmost);
+      Return(topmost);
+    });
   });
 }
 
@@ -151,6 +284,30 @@ IntExpr topmost_bit(IntExpr in_a) {
  * Source: https://en.wikipedia.org/wiki/Division_algorithm#Integer_division_(unsigned)_with_remainder
  */
 void integer_division(Int &Q, Int &R, IntExpr in_a, IntExpr in_b) {
+  if (stmtStack().in_where()) {
+    integer_division_intern(Q, R, in_a, in_b);
+    return;
+  }
+
+  auto sub = get_subroutine("integer_division", [] (Subroutine &def) {
+    Int a, b;
+    Int q, r;
+    integer_division_intern(q, r, a, b);
+
+    def.params  = { a.expr()->var(), b.expr()->var() };
+    def.results = { q.expr()->var(), r.expr()->var() };
+  });
+
+  call(sub, { in_a.expr(), in_b.expr() });
+
+  Q = IntExpr(mkVar(sub->results[0]));
+  R = IntExpr(mkVar(sub->results[1]));
+}
+
+
+namespace {
+
+void integer_division_intern(Int &Q, Int &R, IntExpr in_a, IntExpr in_b) {
   Int N = in_a;  comment("Start long integer division");
   Int D = in_b;
 
@@ -192,6 +349,8 @@ void integer_division(Int &Q, Int &R, IntExpr in_a, IntExpr in_b) {
                                          // in code dumps. Not bothering with correcting this.
 }
 
+}  // anon namespace
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Trigonometric functions
@@ -234,16 +393,9 @@ float sin(float x_in, bool extra_precision) noexcept {
 FloatExpr cos(FloatExpr x_in, bool extra_precision) {
   extra_precision |= LibSettings::use_high_precision_sincos(); // setting to true in param overrides lib setting
 
-  Float x = x_in;
-
-  x -= 0.25f + functions::ffloor(x + 0.25f);  comment("Start cosine");
-  x *= 16.0f * (fabs(x) - 0.5f);
-
-  if (extra_precision) {
-    x += 0.225f * x * (fabs(x) - 1.0f);
-  }
-
-  return x;
+  return float_subroutine(extra_precision?"cos_hp":"cos", x_in, [extra_precision] (FloatExpr x) {
+    return cos_intern(x, extra_precision);
+  });
 }
 
 
@@ -305,23 +457,25 @@ FloatExpr sin(FloatExpr x_in, bool extra_precision) {
 FloatExpr sin_v3d(FloatExpr x_in) {
   //debug("using v3d sin");
 
-  return create_float_function_snippet([x_in] {
-    Float tmp = x_in;                    comment("Start source lang v3d sin");
+  return float_subroutine("sin_v3d", x_in, [] (FloatExpr x_in) {
+    return create_float_function_snippet([x_in] {
+      Float tmp = x_in;                    comment("Start source lang v3d sin");
 
-    tmp += 0.25f;                        // Modulo to range -0.25...0.75
-    comment("v3d sin preamble to get param in the allowed range");
+      tmp += 0.25f;                        // Modulo to range -0.25...0.75
+      comment("v3d sin preamble to get param in the allowed range");
 
-    tmp -= functions::ffloor(tmp);       // Get the fractional part
-    tmp -= 0.25f;
+      tmp -= functions::ffloor(tmp);       // Get the fractional part
+      tmp -= 0.25f;
 
-    Where (tmp > 0.25f)                  // Adjust value to the range -PI/2...PI/2
-      tmp = 0.5f - tmp;
-    End
+      Where (tmp > 0.25f)                  // Adjust value to the range -PI/2...PI/2
+        tmp = 0.5f - tmp;
+      End
 
-    tmp *= 2;                            // Convert to multiple of PI
-    comment("End v3d sin preamble");
+      tmp *= 2;                            // Convert to multiple of PI
+      comment("End v3d sin preamble");
 
-    Return(sin_op(tmp));
+      Return(sin_op(tmp));
+    });
   });
 }
 
@@ -448,11 +602,97 @@ void set_at(Float &dst, Int n, Float const &src) {
 }
 
 
+namespace {
+
+template<typename T, typename Expr>
+Expr load_masked_impl(typename T::Ptr const &src, IntExpr count) {
+  typename T::Ptr p = src;
+  T ret = *p;                    comment("load_masked");
+
+  Where (index() >= count)
+    ret = 0;
+  End
+
+  return ret;
+}
+
+
+template<typename T, typename Expr>
+void store_masked_impl(typename T::Ptr const &dst, Expr val, IntExpr count) {
+  if (Platform::compiling_for_vc4()) {
+    T tmp = val;                 comment("vc4 store_masked");
+    Int n = count;
+    typename T::Ptr p = dst;
+
+    If (n >= 16)
+      *p = tmp;
+    Else
+      // Scatter the tail. Lanes at or beyond count write the value of lane 0 to its address,
+      // so that only lanes within count change memory.
+      T first = tmp;
+      for (int s = 1; s < 16; s *= 2) {
+        T r = rotate(first, s);
+        Where (index() >= s)
+          first = r;
+        End
+      }
+
+      Where (index() >= n)
+        tmp = first;
+        p = p - index();
+      End
+
+      scatter(p, tmp);
+    End
+  } else {
+    // Lanes beyond count write to devnull
+    typename T::Ptr p = dst;     comment("v3d store_masked");
+
+    Where (index() >= count)
+      p = devnull();
+    End
+
+    *p = val;
+  }
+}
+
+}  // anon namespace
+
+
+/**
+ * Load the first `count` values of a vector; the remaining lanes are set to zero.
+ *
+ * Intended for the final partial vector of an array whose size is not a multiple of 16.
+ * A full vector is read from memory. This is safe for the tail of a shared array,
+ * because the allocations are padded to a multiple of 16 elements.
+ */
+IntExpr   load_masked(Int::Ptr const &src, IntExpr count)   { return load_masked_impl<Int, IntExpr>(src, count); }
+FloatExpr load_masked(Float::Ptr const &src, IntExpr count) { return load_masked_impl<Float, FloatExpr>(src, count); }
+
+
+/**
+ * Store the first `count` values of a vector; memory beyond is left untouched.
+ *
+ * Intended for the final partial vector of an array or of an array row.
+ * Lanes at or beyond `count` are not written, so other QPUs can safely write
+ * the values following the tail at the same time.
+ *
+ * `count` must be at least 1; values over 16 store the entire vector with a regular store.
+ *
+ * On vc4, a partial vector is written with a scatter, i.e. a DMA store per lane.
+ * This is slow, but it is only done for the final vector.
+ */
+void store_masked(Int::Ptr const &dst, IntExpr val, IntExpr count)     { store_masked_impl<Int, IntExpr>(dst, val, count); }
+void store_masked(Float::Ptr const &dst, FloatExpr val, IntExpr count) { store_masked_impl<Float, FloatExpr>(dst, val, count); }
+
+
 /**
  * Let QPUs wait for each other.
  *
  * Intended for v3d, where I don't see a hardware signal function as in vc4.
  * Works fine with vc4 also.
+ *
+ * This polls main memory, `barrier()` is the faster alternative.
  */
 void sync_qpus(Int::Ptr signal) {
   If (numQPUs() != 1) // Don't bother syncing if only one qpu
@@ -482,4 +722,56 @@ void sync_qpus(Int::Ptr signal) {
   End
 }
 
+
+namespace {
+
+/**
+ * QPU 0 waits till all other QPUs have arrived, then releases them
+ */
+void sema_barrier_round(int arrive_sema, int release_sema) {
+  If (me() == 0)
+    Int n = numQPUs() - 1;
+    For (Int i = 0, i < n, i++)
+      semaDec(arrive_sema);
+    End
+
+    For (Int i = 0, i < n, i++)
+      semaInc(release_sema);
+    End
+  Else
+    semaInc(arrive_sema);
+    semaDec(release_sema);
+  End
+}
+
+}  // anon namespace
+
+
+/**
+ * Let QPUs wait for each other, using the hardware synchronization.
+ *
+ * In contrast to `sync_qpus()`, this does not poll main memory.
+ *
+ * - vc4: uses semaphores 10-13; 14 and 15 are used elsewhere.
+ *        Two rounds are needed, otherwise a QPU leaving early can take the release
+ *        signal of a slower QPU on the next barrier.
+ *        Preceding DMA writes are completed before arriving.
+ * - v3d: all QPUs are run in a single workgroup, so that `barrierid` syncs them all.
+ *        Afterwards, the TMU L1 cache is cleared, so that loads see the stores of all QPUs.
+ *
+ * On vc4, the loads of vectors in kernels which use this go via DMA, see `vc4/LoadPath.cpp`.
+ *
+ * All QPUs must call this the same number of times, i.e. not within a QPU-dependent `If`.
+ */
+void barrier() {
+  if (!Platform::compiling_for_vc4()) {
+    stmtStack() << Stmt::create(Stmt::BARRIER);
+    return;
+  }
+
+  dmaWaitWrite();               header("barrier");
+  sema_barrier_round(10, 11);
+  sema_barrier_round(12, 13);
+}
+
 }  // namespace V3DLib
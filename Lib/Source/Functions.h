@@ -3,10 +3,14 @@
 #include "Int.h"
 #include "Float.h"
 #include "StmtStack.h"  // StackCallback
+#include <functional>
 
 namespace V3DLib {
 namespace functions {
 
+void reset_subroutines();
+FloatExpr float_subroutine(char const *name, FloatExpr arg, std::function<FloatExpr (FloatExpr)> f);
+
 // These exposed for unit tests
 void Return(Int const &val);
 void Return(Float const &val);
@@ -38,7 +42,13 @@ void rotate_sum(Float &input, Float &result);
 void set_at(Int &dst, Int n, Int const &src);
 void set_at(Float &dst, Int n, Float const &src);
 
+IntExpr   load_masked(Int::Ptr const &src, IntExpr count);
+FloatExpr load_masked(Float::Ptr const &src, IntExpr count);
+void store_masked(Int::Ptr const &dst, IntExpr val, IntExpr count);
+void store_masked(Float::Ptr const &dst, FloatExpr val, IntExpr count);
+
 void sync_qpus(Int::Ptr signal);
+void barrier();
 
 }  // namespace V3DLib
 
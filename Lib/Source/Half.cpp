@@ -0,0 +1,227 @@
+#include "Half.h"
+#include <cstring>
+#include "Lang.h"       // only for assign()!
+#include "Support/Platform.h"
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace {
+
+int const BLOCK_SIZE = 32;  // Number of fp16 values in a block of 16 words
+
+/**
+ * Get the index of the word containing value i of a Half::Array
+ *
+ * @param high  output, true if the value is in the upper 16 bits of the word
+ */
+uint32_t word_index(uint32_t i, bool &high) {
+  uint32_t offset = i % BLOCK_SIZE;
+  high = (offset >= 16);
+  return (i/BLOCK_SIZE)*16 + (offset % 16);
+}
+
+
+// ============================================================================
+// Conversion with bit manipulation, for vc4.
+//
+// These match Half::to_half() and Half::to_float().
+// ============================================================================
+
+/**
+ * @param h  fp16 value in the lower 16 bits, upper bits zero
+ */
+FloatExpr soft_unpack(Int const &h) {
+  Int ax = h & 0x7fff;
+  Int normal   = (0x3ff - ax) >> 31;   // All bits set if not zero or denormal
+  Int inf_nan  = (0x7bff - ax) >> 31;  // All bits set if exponent all ones
+
+  // Rebias the exponent from 15 to 127; for inf/NaN, add the difference again to get all ones
+  Int bits = (((ax << 13) + 0x38000000) & normal) + (inf_nan & 0x38000000);
+  bits |= (h & 0x8000) << 16;
+  return FloatExpr(bits.expr());
+}
+
+
+/**
+ * @return fp16 value in the lower 16 bits
+ */
+IntExpr soft_pack(FloatExpr val) {
+  Int x = val.as_int();
+  Int ax = x & 0x7fffffff;
+  Int small = (ax - 0x38800000) >> 31;  // All bits set if too small for a normal fp16 value
+
+  // Rebias the exponent from 127 to 15 and round; overflow saturates to inf
+  Int ret = min(shr(ax - 0x38000000 + 0x1000, 13), 0x7c00) & ~small;
+  return ret | (shr(x, 16) & 0x8000);
+}
+
+}  // anon namespace
+
+
+// ============================================================================
+// Class Half
+// ============================================================================
+
+/**
+ * Convert float to fp16, for usage on the host.
+ */
+uint16_t Half::to_half(float val) {
+  uint32_t x;
+  memcpy(&x, &val, sizeof(x));
+
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t ax   = x & 0x7fffffff;
+  if (ax < 0x38800000) return (uint16_t) sign;   // Flush denormals to zero
+
+  uint32_t ret = (ax - 0x38000000 + 0x1000) >> 13;
+  if (ret > 0x7c00) ret = 0x7c00;                // Overflow and NaN to inf
+
+  return (uint16_t) (sign | ret);
+}
+
+
+/**
+ * Convert fp16 to float, for usage on the host.
+ */
+float Half::to_float(uint16_t val) {
+  uint32_t sign = ((uint32_t) (val & 0x8000)) << 16;
+  uint32_t ax   = val & 0x7fff;
+  uint32_t bits;
+
+  if (ax < 0x400) {
+    bits = 0;                                     // Flush denormals to zero
+  } else if (ax >= 0x7c00) {
+    bits = 0x7f800000 | ((ax & 0x3ff) << 13);     // inf and NaN
+  } else {
+    bits = (ax << 13) + 0x38000000;
+  }
+
+  bits |= sign;
+
+  float ret;
+  memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+
+Half::Array::Array(uint32_t num_values) {
+  alloc(num_values);
+}
+
+
+void Half::Array::alloc(uint32_t num_values) {
+  assert(num_values > 0);
+  m_num_values = num_values;
+  Parent::alloc(16*((num_values + BLOCK_SIZE - 1)/BLOCK_SIZE));
+}
+
+
+float Half::Array::get(uint32_t i) const {
+  assert(i < m_num_values);
+  bool high;
+  uint32_t word = (uint32_t) (*this)[(int) word_index(i, high)];
+  return to_float((uint16_t) (high?(word >> 16):(word & 0xffff)));
+}
+
+
+void Half::Array::set(uint32_t i, float val) {
+  assert(i < m_num_values);
+  bool high;
+  int &word = (*this)[(int) word_index(i, high)];
+
+  uint32_t h   = to_half(val);
+  uint32_t tmp = (uint32_t) word;
+  if (high) {
+    tmp = (tmp & 0x0000ffff) | (h << 16);
+  } else {
+    tmp = (tmp & 0xffff0000) | h;
+  }
+  word = (int) tmp;
+}
+
+
+void Half::Array::fill(float val) {
+  uint32_t h = to_half(val);
+  Parent::fill((int) (h | (h << 16)));
+}
+
+
+void Half::Array::copyFrom(std::vector<float> const &src) {
+  assert(src.size() <= m_num_values);
+
+  for (uint32_t i = 0; i < src.size(); ++i) {
+    set(i, src[i]);
+  }
+}
+
+
+void Half::Array::copyTo(std::vector<float> &dst) const {
+  dst.resize(m_num_values);
+
+  for (uint32_t i = 0; i < m_num_values; ++i) {
+    dst[i] = get(i);
+  }
+}
+
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+/**
+ * Convert the fp16 values in the lower 16 bits of `packed` to Float
+ */
+FloatExpr half_lo(IntExpr packed) {
+  if (Platform::compiling_for_vc4()) {
+    Int h = packed & 0xffff;
+    return soft_unpack(h);
+  }
+
+  return FloatExpr(mkApply(packed.expr(), Op(HALF_LO, FLOAT)));
+}
+
+
+/**
+ * Convert the fp16 values in the upper 16 bits of `packed` to Float
+ */
+FloatExpr half_hi(IntExpr packed) {
+  if (Platform::compiling_for_vc4()) {
+    Int h = shr(packed, 16);
+    return soft_unpack(h);
+  }
+
+  return FloatExpr(mkApply(packed.expr(), Op(HALF_HI, FLOAT)));
+}
+
+
+/**
+ * Convert two Float values to fp16 and pack them into the lower and upper 16 bits
+ */
+IntExpr half_pack(FloatExpr lo, FloatExpr hi) {
+  if (Platform::compiling_for_vc4()) {
+    return soft_pack(lo) | (soft_pack(hi) << 16);
+  }
+
+  return IntExpr(mkApply(lo.expr(), Op(HALF_PACK, FLOAT), hi.expr()));
+}
+
+
+/**
+ * Load a block of 32 fp16 values as two Float vectors
+ */
+void half_load(Half::Ptr &src, Float &lo, Float &hi) {
+  Int packed = *src;
+  lo = half_lo(packed);
+  hi = half_hi(packed);
+}
+
+
+/**
+ * Store two Float vectors as a block of 32 fp16 values
+ */
+void half_store(Half::Ptr &dst, FloatExpr lo, FloatExpr hi) {
+  Int packed = half_pack(lo, hi);
+  *dst = packed;
+}
+
+}  // namespace V3DLib
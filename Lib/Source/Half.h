@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// This module defines storage type 'Half' for 16-bit floats (fp16).
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _V3DLIB_SOURCE_HALF_H_
+#define _V3DLIB_SOURCE_HALF_H_
+#include <cstdint>
+#include <vector>
+#include "Int.h"
+#include "Float.h"
+
+namespace V3DLib {
+
+/**
+ * Half-precision floats, for storage only.
+ *
+ * Values are stored as fp16 in memory and converted to and from Float on
+ * load and store. This halves memory usage and traffic compared to Float.
+ * All calculations in kernels are still done with 32-bit floats.
+ *
+ * Values are stored in blocks of 32 values in 16 32-bit words.
+ * Word `j` of a block contains value `j` in its lower 16 bits and value `16 + j`
+ * in its upper 16 bits. Thus, a single vector load of a block gives two consecutive
+ * Float vectors. A `Half::Ptr` is an `Int::Ptr` to the packed words; advance it by 16
+ * to go to the next block.
+ *
+ * On v3d, the conversions use the fp16 pack/unpack of the QPU. On vc4, these can not
+ * be expressed in the target language and the conversions are done with bit manipulation.
+ * The latter flushes denormals to zero, rounds ties away from zero and converts NaN to
+ * infinity. The host conversions below do the same as the vc4 conversions.
+ */
+struct Half {
+  using Ptr = Int::Ptr;  // Every element contains 2 packed values
+
+  /**
+   * Shared array of fp16 values
+   *
+   * The size is the number of fp16 values, the allocated size is rounded up
+   * to a multiple of a block.
+   */
+  class Array : public Int::Array {
+    using Parent = Int::Array;
+
+  public:
+    Array() = default;
+    Array(uint32_t num_values);
+
+    void alloc(uint32_t num_values);
+    uint32_t num_values() const { return m_num_values; }
+
+    float get(uint32_t i) const;
+    void set(uint32_t i, float val);
+    void fill(float val);
+    void copyFrom(std::vector<float> const &src);
+    void copyTo(std::vector<float> &dst) const;
+
+  private:
+    uint32_t m_num_values = 0;
+  };
+
+  static uint16_t to_half(float val);
+  static float to_float(uint16_t val);
+};
+
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+FloatExpr half_lo(IntExpr packed);
+FloatExpr half_hi(IntExpr packed);
+IntExpr half_pack(FloatExpr lo, FloatExpr hi);
+
+void half_load(Half::Ptr &src, Float &lo, Float &hi);
+void half_store(Half::Ptr &dst, FloatExpr lo, FloatExpr hi);
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_HALF_H_
@@ -0,0 +1,206 @@
+#include "Int8x4.h"
+#include "Lang.h"       // only for assign()!
+#include "Support/Platform.h"
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace {
+
+int const HIGH_BITS = (int) 0x80808080;  // High bit of every byte
+int const LOW_BITS  = 0x7f7f7f7f;        // All bits of every byte except the high bit
+
+
+Int8x4Expr mkV8Apply(Int8x4Expr a, OpId op, Int8x4Expr b) {
+  assert(Platform::compiling_for_vc4());
+  Expr::Ptr e = mkApply(a.expr(), Op(op, UINT8), b.expr());
+  return Int8x4Expr(e);
+}
+
+
+/**
+ * Get the byte at position n as a 32-bit value
+ */
+IntExpr byte_at(IntExpr a, int n) {
+  assert(0 <= n && n < 4);
+
+  switch (n) {
+    case 0:  return a & 0xff;
+    case 3:  return shr(a, 24);
+    default: return shr(a, 8*n) & 0xff;
+  }
+}
+
+
+// ============================================================================
+// Emulation of packed 8-bit operations with 32-bit operations, for v3d.
+//
+// These work on all bytes in parallel; the high bit of every byte is handled
+// separately so that no carries propagate to the next byte.
+// ============================================================================
+
+/**
+ * Expand the high bit of every byte in c to the entire byte
+ */
+IntExpr byte_mask(Int const &c) {
+  return c | (c - shr(c, 7));
+}
+
+
+/**
+ * Subtract per byte with wrap-around
+ *
+ * @param d  output, result of subtraction
+ * @param c  output, high bit set for every byte where a borrow occured, i.e. where a < b
+ */
+void sub_with_borrow(Int const &a, Int const &b, Int &d, Int &c) {
+  d = ((a | HIGH_BITS) - (b & LOW_BITS)) ^ ((a ^ ~b) & HIGH_BITS);
+  c = ((~a & b) | (~(a ^ b) & d)) & HIGH_BITS;
+}
+
+
+Int8x4Expr v3d_adds(Int const &a, Int const &b) {
+  Int s = ((a & LOW_BITS) + (b & LOW_BITS)) ^ ((a ^ b) & HIGH_BITS);
+  Int c = ((a & b) | ((a | b) & ~s)) & HIGH_BITS;  // Carry out of every byte
+  return Int8x4Expr((s | byte_mask(c)).expr());
+}
+
+
+Int8x4Expr v3d_subs(Int const &a, Int const &b) {
+  Int d, c;
+  sub_with_borrow(a, b, d, c);
+  return Int8x4Expr((d & ~byte_mask(c)).expr());
+}
+
+
+Int8x4Expr v3d_min_max(Int const &a, Int const &b, bool do_min) {
+  Int d, c;
+  sub_with_borrow(a, b, d, c);
+  Int m = byte_mask(c);  // Set for every byte where a < b
+
+  if (do_min) {
+    return Int8x4Expr(((a & m) | (b & ~m)).expr());
+  } else {
+    return Int8x4Expr(((b & m) | (a & ~m)).expr());
+  }
+}
+
+
+/**
+ * Per byte, calculate round(a*b/255)
+ *
+ * With t = a*b + 128, the division is exactly (t + (t >> 8)) >> 8 for all byte values.
+ */
+Int8x4Expr v3d_mul(Int const &a, Int const &b) {
+  Int ret = 0;
+
+  for (int n = 0; n < 4; n++) {
+    Int t = byte_at(a, n)*byte_at(b, n) + 128;
+    ret |= shr(t + shr(t, 8), 8) << (8*n);
+  }
+
+  return Int8x4Expr(ret.expr());
+}
+
+}  // anon namespace
+
+
+// ============================================================================
+// Class Int8x4
+// ============================================================================
+
+Int8x4::Int8x4()                   { assign_intern(); }
+Int8x4::Int8x4(Int8x4Expr e)       { assign_intern(e.expr()); }
+Int8x4::Int8x4(Deref<Int> d)       { assign_intern(d.expr()); }
+Int8x4::Int8x4(Int8x4 const &x)    { assign_intern(x.expr()); }
+Int8x4::Int8x4(IntExpr e)          { assign_intern(e.expr()); }
+
+
+Int8x4::operator Int8x4Expr() const {
+  return Int8x4Expr(m_expr);
+}
+
+
+Int8x4 &Int8x4::operator=(Int8x4 const &rhs) {
+  assign(m_expr, rhs.expr());
+  return *this;
+}
+
+
+Int8x4Expr Int8x4::operator=(Int8x4Expr rhs) {
+  assign(m_expr, rhs.expr());
+  return rhs;
+}
+
+
+/**
+ * Get the packed value at position n as a 32-bit value
+ */
+IntExpr Int8x4::get(int n) const {
+  return byte_at(as_int(), n);
+}
+
+
+/**
+ * Pack 4 byte values into a 32-bit value, for usage on the host.
+ */
+int Int8x4::pack(int b0, int b1, int b2, int b3) {
+  uint32_t ret = ((uint32_t) (b0 & 0xff))
+               | ((uint32_t) (b1 & 0xff)) << 8
+               | ((uint32_t) (b2 & 0xff)) << 16
+               | ((uint32_t) (b3 & 0xff)) << 24;
+  return (int) ret;
+}
+
+
+/**
+ * Get the byte value at position n of a packed 32-bit value, for usage on the host.
+ */
+int Int8x4::unpack(int val, int n) {
+  assert(0 <= n && n < 4);
+  return (int) ((((uint32_t) val) >> (8*n)) & 0xff);
+}
+
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+/**
+ * Pack the lower bytes of 4 32-bit values
+ */
+Int8x4Expr pack8x4(IntExpr b0, IntExpr b1, IntExpr b2, IntExpr b3) {
+  IntExpr e = (b0 & 0xff) | ((b1 & 0xff) << 8) | ((b2 & 0xff) << 16) | (b3 << 24);
+  return Int8x4Expr(e.expr());
+}
+
+
+Int8x4Expr operator+(Int8x4Expr a, Int8x4Expr b) {
+  if (Platform::compiling_for_vc4()) return mkV8Apply(a, V8ADDS, b);
+  return v3d_adds(a.as_int(), b.as_int());
+}
+
+
+Int8x4Expr operator-(Int8x4Expr a, Int8x4Expr b) {
+  if (Platform::compiling_for_vc4()) return mkV8Apply(a, V8SUBS, b);
+  return v3d_subs(a.as_int(), b.as_int());
+}
+
+
+Int8x4Expr operator*(Int8x4Expr a, Int8x4Expr b) {
+  if (Platform::compiling_for_vc4()) return mkV8Apply(a, V8MUL, b);
+  return v3d_mul(a.as_int(), b.as_int());
+}
+
+
+Int8x4Expr min(Int8x4Expr a, Int8x4Expr b) {
+  if (Platform::compiling_for_vc4()) return mkV8Apply(a, V8MIN, b);
+  return v3d_min_max(a.as_int(), b.as_int(), true);
+}
+
+
+Int8x4Expr max(Int8x4Expr a, Int8x4Expr b) {
+  if (Platform::compiling_for_vc4()) return mkV8Apply(a, V8MAX, b);
+  return v3d_min_max(a.as_int(), b.as_int(), false);
+}
+
+}  // namespace V3DLib
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// This module defines type 'Int8x4' for a vector of 16 x 4 packed unsigned 8-bit integers.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _V3DLIB_SOURCE_INT8X4_H_
+#define _V3DLIB_SOURCE_INT8X4_H_
+#include "Int.h"
+
+namespace V3DLib {
+
+// ============================================================================
+// Types
+// ============================================================================
+
+/**
+ * An 'Int8x4Expr' defines a packed 8-bit vector expression which can
+ * only be used on the RHS of assignment statements.
+ */
+struct Int8x4Expr : public BaseExpr {
+  Int8x4Expr(Expr::Ptr e) : BaseExpr(e) {}
+
+  IntExpr as_int() const { return IntExpr(m_expr); }  //<< Reinterpret as 32-bit values
+};
+
+
+/**
+ * An 'Int8x4' defines a packed 8-bit vector variable which can be used in
+ * both the LHS and RHS of an assignment.
+ *
+ * Every 32-bit lane contains 4 unsigned 8-bit values, byte 0 being the lowest.
+ * All operations work per 8-bit value and saturate to the range 0..255.
+ * Multiplication treats the values as fractions of 255, i.e. `a*b` is `round(a*b/255)`.
+ *
+ * On vc4, the operations map to the packed 8-bit instructions of the QPU.
+ * On v3d, these do not exist and the operations are emulated with 32-bit instructions.
+ */
+struct Int8x4 : public BaseExpr {
+  using Array = Int::Array;  // Every element contains 4 packed values
+  using Ptr   = Int::Ptr;
+
+  Int8x4();
+  Int8x4(Int8x4Expr e);
+  Int8x4(Deref<Int> d);
+  Int8x4(Int8x4 const &x);
+  explicit Int8x4(IntExpr e);
+
+  operator Int8x4Expr() const;
+  IntExpr as_int() const { return IntExpr(m_expr); }  //<< Reinterpret as 32-bit values
+  IntExpr get(int n) const;
+
+  Int8x4 &operator=(Int8x4 const &rhs);
+  Int8x4Expr operator=(Int8x4Expr rhs);
+
+  static int pack(int b0, int b1, int b2, int b3);
+  static int unpack(int val, int n);
+};
+
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+Int8x4Expr pack8x4(IntExpr b0, IntExpr b1, IntExpr b2, IntExpr b3);
+
+Int8x4Expr operator+(Int8x4Expr a, Int8x4Expr b);
+Int8x4Expr operator-(Int8x4Expr a, Int8x4Expr b);
+Int8x4Expr operator*(Int8x4Expr a, Int8x4Expr b);
+Int8x4Expr min(Int8x4Expr a, Int8x4Expr b);
+Int8x4Expr max(Int8x4Expr a, Int8x4Expr b);
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_INT8X4_H_
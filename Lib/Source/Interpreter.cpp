@@ -2,6 +2,7 @@
 #include <algorithm>  // reverse()
 #include "Common/SharedArray.h"
 #include "Source/Stmt.h"
+#include "Source/Local.h"
 #include "Common/BufferObject.h"
 #include "Target/EmuSupport.h"
 #include "Support/basics.h"
@@ -43,6 +44,7 @@ struct CoreState {
   } 
 
   void store_to_heap(Vec const &index, Vec &val);
+  void scatter_to_heap(Vec const &index, Vec const &val);
   Vec  load_from_heap(Vec const &index);
 
   static void reset_count() {
@@ -108,6 +110,19 @@ void CoreState::store_to_heap(Vec const &index, Vec &val) {
 }
 
 
+/**
+ * Store every vector element to its own address.
+ *
+ * Lanes are written in order, so the highest lane wins for duplicate addresses.
+ */
+void CoreState::scatter_to_heap(Vec const &index, Vec const &val) {
+  for (int i = 0; i < NUM_LANES; i++) {
+    uint32_t hp = (uint32_t) index[i].intVal + 4*i;  // Pointers don't have the lane offset here
+    emuHeap.phy(hp>>2) = val[i].intVal;
+  }
+}
+
+
 Vec CoreState::load_from_heap(Vec const &index) {
   assert(readStride == 0);  // Usage of readStride is probably wrong!
   Vec v;
@@ -167,6 +182,7 @@ Vec eval(InterpreterState &is, CoreState* s, Expr::Ptr e) {
         case STANDARD: v = s->env(var.id()); break;
         case UNIFORM:  v = is.get_uniform(s->id, s->nextUniform); break;
         case ELEM_NUM: v = EmuState::index_vec; break;
+        case QPU_NUM:  v = s->id; break;
 
         default:
           assertq(false, "eval(): unhandled var tag");
@@ -432,6 +448,70 @@ void execLoadReceive(CoreState* s, Expr::Ptr e) {
 }
 
 
+// ============================================================================
+// Execute atomic operation
+// ============================================================================
+
+/**
+ * Since the interpreter executes a statement at a time, the operation is atomic by
+ * construction. Lanes are handled in order.
+ */
+void execAtomic(InterpreterState &is, CoreState *s, Stmt::Atomic const &a) {
+  Vec addr = eval(is, s, a.addr);
+  Vec val  = eval(is, s, a.val);
+  Vec cmp;
+  if (a.cmp) cmp = eval(is, s, a.cmp);
+
+  Vec old;
+
+  for (int i = 0; i < NUM_LANES; i++) {
+    uint32_t hp = (uint32_t) addr[i].intVal + 4*i;  // Pointers don't have the lane offset here
+    int32_t &mem = (int32_t &) s->emuHeap.phy(hp >> 2);
+    int32_t v = val[i].intVal;
+
+    old[i].intVal = mem;
+
+    switch (a.op) {
+      case Stmt::Atomic::ADD:      mem = (int32_t) ((uint32_t) mem + (uint32_t) v); break;
+      case Stmt::Atomic::MIN:      mem = std::min(mem, v);                          break;
+      case Stmt::Atomic::MAX:      mem = std::max(mem, v);                          break;
+      case Stmt::Atomic::EXCHANGE: mem = v;                                         break;
+      case Stmt::Atomic::CMPXCHG:  if (mem == cmp[i].intVal) mem = v;               break;
+    }
+  }
+
+  assignToVar(s, Always, a.dst, old);
+}
+
+
+// ============================================================================
+// Execute local memory access
+// ============================================================================
+
+/**
+ * Local memory is in the VPM, as with vc4
+ */
+void execLocalAccess(InterpreterState &is, CoreState *s, Stmt::LocalAccess const &a) {
+  int row = eval(is, s, a.row)[0].intVal;
+  assertq(0 <= row && row < a.size, "Local array: row index out of range");
+
+  Word *mem = is.vpm + 16*local::vpm_row(a.base, a.size, row);
+
+  if (a.is_store) {
+    Vec val = eval(is, s, a.val);
+    for (int i = 0; i < NUM_LANES; i++) {
+      mem[i] = val[i];
+    }
+  } else {
+    Vec val;
+    for (int i = 0; i < NUM_LANES; i++) {
+      val[i] = mem[i];
+    }
+    assignToVar(s, Always, a.dst, val);
+  }
+}
+
+
 // ============================================================================
 // Execute code
 // ============================================================================
@@ -504,6 +584,10 @@ void exec(InterpreterState &is, int core_index) {
 #endif
   }
 
+  if (stmt->tag != Stmt::SEMA_INC && stmt->tag != Stmt::SEMA_DEC) {
+    is.progress();
+  }
+
   switch (stmt->tag) {
     case Stmt::GATHER_PREFETCH: // Ignore
     case Stmt::SKIP:
@@ -543,6 +627,22 @@ void exec(InterpreterState &is, int core_index) {
       execLoadReceive(s, stmt->address());
       break;
 
+    case Stmt::STORE_SCATTER:
+      s->scatter_to_heap(eval(is, s, stmt->scatter_addr()), eval(is, s, stmt->scatter_val()));
+      break;
+
+    case Stmt::ATOMIC:
+      execAtomic(is, s, *stmt->atomic());
+      break;
+
+    case Stmt::LOCAL_ACCESS:
+      execLocalAccess(is, s, *stmt->local_access());
+      break;
+
+    case Stmt::CALL:            // Subroutine call, parameters and results are in fixed vars
+      append_stack(*s, stmt->subroutine()->body);
+      break;
+
     case Stmt::SEMA_INC: if (is.sema_inc(stmt->dma.semaId())) s->stack << stmt; break;
     case Stmt::SEMA_DEC: if (is.sema_dec(stmt->dma.semaId())) s->stack << stmt; break;
 
@@ -0,0 +1,120 @@
+#include "Local.h"
+#include "Lang.h"
+#include "StmtStack.h"
+#include "Support/Platform.h"
+#include "Support/basics.h"
+#include "vc4/DMA/Operations.h"
+#include "v3d/Invoke.h"           // v3d::LOCAL_OFFSET
+
+namespace V3DLib {
+
+using ::operator<<;  // C++ weirdness
+
+namespace {
+
+int m_rows_used = 0;
+
+
+/**
+ * Generate the code for a local memory access.
+ *
+ * On v3d, the local rows are placed in the devnull buffer, see `v3d/Invoke.h`.
+ */
+void lower(Stmt::LocalAccess const &a) {
+  Int row = IntExpr(a.row);
+
+  if (Platform::compiling_for_vc4()) {
+    if (a.is_store) {
+      vpmSetupWrite(HORIZ, row + local::vpm_row(a.base, a.size, 0));
+      vpmPutExpr(a.val);
+    } else {
+      vpmSetupRead(HORIZ, 1, row + local::vpm_row(a.base, a.size, 0));
+      stmtStack() << Stmt::create_assign(mkVar(a.dst), vpmGetInt().expr());
+    }
+  } else {
+    Int addr = IntExpr(devnull().expr());
+    addr += ((row << 4) + (v3d::LOCAL_OFFSET + 16*a.base) + index()) << 2;
+    Expr::Ptr mem = mkDeref(addr.expr());
+
+    if (a.is_store) {
+      stmtStack() << Stmt::create_assign(mem, a.val);
+    } else {
+      stmtStack() << Stmt::create_assign(mkVar(a.dst), mem);
+    }
+  }
+}
+
+
+Stmt::LocalAccess::Ptr create(int base, int size, IntExpr row) {
+  auto a = std::make_shared<Stmt::LocalAccess>();
+  a->base = base;
+  a->size = size;
+  a->row  = row.expr();
+  return a;
+}
+
+}  // anon namespace
+
+
+namespace local {
+
+/**
+ * Needs to be called for every kernel compilation.
+ */
+void reset() {
+  m_rows_used = 0;
+}
+
+
+/**
+ * @return number of rows allocated for local arrays in the kernel being compiled
+ */
+int rows_used() {
+  return m_rows_used;
+}
+
+}  // namespace local
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class LocalBase
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @param size  number of vectors in the array
+ */
+LocalBase::LocalBase(int size) : m_base(m_rows_used), m_size(size) {
+  assertq(size > 0, "Local array must have at least one element", true);
+
+  if (m_rows_used + size > local::MAX_ROWS) {
+    std::string msg;
+    msg << "Local arrays need " << (m_rows_used + size) << " vectors, only "
+        << local::MAX_ROWS << " are available";
+    error(msg, true);
+  }
+
+  m_rows_used += size;
+}
+
+
+Expr::Ptr LocalBase::load(IntExpr row) {
+  Int dst;
+  auto a = create(m_base, m_size, row);
+  a->dst  = dst.expr()->var();
+  a->body = tempStmt([&a] { lower(*a); });
+
+  stmtStack() << Stmt::create_local_access(a);
+  return dst.expr();
+}
+
+
+void LocalBase::store(IntExpr row, Expr::Ptr val) {
+  auto a = create(m_base, m_size, row);
+  a->is_store = true;
+  a->val  = val;
+  a->body = tempStmt([&a] { lower(*a); });
+
+  stmtStack() << Stmt::create_local_access(a);
+}
+
+}  // namespace V3DLib
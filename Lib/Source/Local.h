@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// This module defines type 'Local<T>' for arrays in fast on-chip memory.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _V3DLIB_SOURCE_LOCAL_H_
+#define _V3DLIB_SOURCE_LOCAL_H_
+#include "Int.h"
+#include "Float.h"
+
+namespace V3DLib {
+
+namespace local {
+
+//
+// Part of the vc4 VPM used for local memory.
+//
+// VPM rows 0-31 are used for DMA loads and stores, row 63 for atomics.
+// Arrays are allocated from the top down.
+//
+int const VPM_FIRST_ROW = 32;
+int const MAX_ROWS      = 31;
+
+void reset();
+int rows_used();
+
+/**
+ * @return VPM row for given row of a local array
+ */
+inline int vpm_row(int base, int size, int row) {
+  return VPM_FIRST_ROW + MAX_ROWS - (base + size) + row;
+}
+
+}  // namespace local
+
+
+/**
+ * Base class for local arrays.
+ *
+ * Local memory is allocated per kernel on compile, rows are never freed.
+ * The row index for an access is taken from the first vector element; it
+ * needs to be in range `0..size() - 1`.
+ */
+class LocalBase {
+public:
+  LocalBase(int size);
+
+  int size() const { return m_size; }
+
+protected:
+  Expr::Ptr load(IntExpr row);
+  void store(IntExpr row, Expr::Ptr val);
+
+private:
+  int m_base = 0;
+  int m_size = 0;
+};
+
+
+/**
+ * Array of vectors in fast on-chip memory, shared by all QPUs.
+ *
+ * Intended for staging tiles and exchanging data between QPUs without
+ * going through main memory. Use `barrier()` to ensure that values stored
+ * by other QPUs are present.
+ *
+ * - vc4: maps to the VPM. A total of `local::MAX_ROWS` vectors is available
+ *        over all local arrays in a kernel. Kernels using the VPM directly
+ *        should avoid the rows from `local::VPM_FIRST_ROW` on.
+ * - v3d: there is no on-chip memory usable for this, the arrays are placed
+ *        in the heap buffer of devnull. The same size limit applies,
+ *        to keep kernels portable.
+ *
+ * The contents are undefined on kernel start.
+ */
+template <typename T>
+class Local;
+
+
+template <>
+class Local<Int> : public LocalBase {
+public:
+  Local(int size) : LocalBase(size) {}
+
+  IntExpr get(IntExpr row) { return IntExpr(load(row)); }
+  void set(IntExpr row, IntExpr val) { store(row, val.expr()); }
+};
+
+
+template <>
+class Local<Float> : public LocalBase {
+public:
+  Local(int size) : LocalBase(size) {}
+
+  FloatExpr get(IntExpr row) { return FloatExpr(load(row)); }
+  void set(IntExpr row, FloatExpr val) { store(row, val.expr()); }
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_LOCAL_H_
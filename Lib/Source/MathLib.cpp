@@ -0,0 +1,431 @@
+/******************************************************************************
+ * Transcendental functions with precision tiers
+ *
+ * Newton refinement is used where the SFU provides a starting value which is
+ * cheap to correct: recip, rsqrt and sqrt.
+ *
+ * exp and log are done with range reduction and a polynomial instead.
+ * A Newton step for either needs the other at full precision, so it
+ * would not improve on the SFU value.
+ *
+ * The remaining functions are built on top of these.
+ *
+ ******************************************************************************/
+#include "MathLib.h"
+#include <string>
+#include <vector>
+#include "Lang.h"
+#include "Functions.h"
+
+namespace V3DLib {
+namespace math {
+namespace {
+
+float const LOG2E       = 1.44269504089f;
+float const LN2_HI      = 0.693359375f;     // ln(2) = LN2_HI + LN2_LO, LN2_HI exact in 9 bits
+float const LN2_LO      = -2.12194440e-4f;
+float const SQRT2       = 1.41421356237f;
+float const PI          = 3.14159265359f;
+float const PI_2        = 1.57079632679f;
+float const TWO_OVER_PI = 0.636619772368f;
+float const INV_2PI     = 0.159154943092f;
+
+// pi/2 split for Cody-Waite range reduction, two parts
+float const PIO2_HI     = 1.57079637050628662109375f;
+float const PIO2_LO     = -4.37113900018624283e-8f;
+
+// pi/2 split in three parts. The first two have enough trailing zero bits
+// for q*PIO2_1 and q*PIO2_2 to be exact for |q| < 2^13
+float const PIO2_1      = 1.5703125f;
+float const PIO2_2      = 4.837512969970703125e-4f;
+float const PIO2_3      = 7.54978995489188216e-8f;
+
+
+std::string sub_name(char const *name, Precision p) {
+  std::string ret = name;
+
+  switch (p) {
+    case FAST:   ret += "_fast"; break;
+    case MEDIUM:                 break;
+    case HIGH:   ret += "_hp";   break;
+  }
+
+  return ret;
+}
+
+
+int newton_steps(Precision p) {
+  switch (p) {
+    case FAST:   return 0;
+    case MEDIUM: return 1;
+    case HIGH:   return 2;
+  }
+
+  assert(false);
+  return 0;
+}
+
+
+/**
+ * Evaluate polynomial with given coefficients, highest degree first
+ */
+FloatExpr horner(Float const &x, std::vector<float> const &coefs) {
+  assert(!coefs.empty());
+  Float ret = coefs[0];
+
+  for (int i = 1; i < (int) coefs.size(); i++) {
+    ret = ret*x + coefs[i];
+  }
+
+  return ret;
+}
+
+
+/**
+ * Reduce the argument of exp(x) to `scale*(1 + q)`
+ *
+ * scale is a power of 2, q = expm1(r) with |r| <= ln(2)/2.
+ * Keeping q separate allows for an accurate expm1().
+ *
+ * The input is clamped, so that the exponent of scale stays in the valid range.
+ */
+void exp_reduce(FloatExpr x_in, Precision p, Float &scale, Float &q) {
+  Float x = x_in;                                          comment("Start exp reduction");
+
+  // Not using min/max here, float min/max are not supported for v3d
+  Where (x < -87.0f) x = -87.0f; End
+  Where (x >  88.0f) x =  88.0f; End
+
+  Float n = functions::ffloor(x*LOG2E + 0.5f);
+  Float r = (x - n*LN2_HI) - n*LN2_LO;
+
+  // Taylor series of expm1(r)/r, 1/k! for k = degree..1
+  std::vector<float> coefs;
+  int degree = (p == HIGH)?7:6;
+  float fact = 1;
+  for (int k = 2; k <= degree; k++) fact *= (float) k;
+
+  for (int k = degree; k >= 1; k--) {
+    coefs.push_back(1.0f/fact);
+    fact /= (float) k;
+  }
+
+  q = r*horner(r, coefs);
+  scale.as_float((toInt(n) + 127) << 23);
+}
+
+
+FloatExpr log_intern(FloatExpr x_in, Precision p) {
+  Int bits = x_in.as_int();                                comment("Start log");
+  Int e    = (bits >> 23) - 127;
+
+  Float m;                                                 // Mantissa in range 1..2
+  m.as_float((bits & 0x007fffff) | 0x3f800000);
+
+  Where (m > SQRT2)                                        // Shift to range 0.707..1.414
+    m *= 0.5f;
+    e += 1;
+  End
+
+  // ln(m) = 2*atanh(s) = 2*(s + s^3/3 + s^5/5 + ...), with s = (m - 1)/(m + 1)
+  Float s  = (m - 1.0f)*recip(m + 1.0f, p);
+  Float s2 = s*s;
+
+  Float series;
+  if (p == HIGH) {
+    series = horner(s2, { 1.0f/9, 1.0f/7, 1.0f/5, 1.0f/3, 1.0f });
+  } else {
+    series = horner(s2, { 1.0f/7, 1.0f/5, 1.0f/3, 1.0f });
+  }
+
+  Float fe = toFloat(e);
+  return fe*LN2_HI + (fe*LN2_LO + 2.0f*s*series);
+}
+
+
+/**
+ * atan(a) for 0 <= a <= 1
+ *
+ * Source: Abramowitz & Stegun, 4.4.48 (|error| <= 1e-5) and 4.4.49 (|error| <= 2e-8)
+ */
+FloatExpr atan01(FloatExpr a_in, Precision p) {
+  return functions::float_subroutine(sub_name("atan01", p).c_str(), a_in, [p] (FloatExpr a_param) {
+    Float a  = a_param;                                    comment("Start atan");
+    Float a2 = a*a;
+
+    Float ret;
+    if (p == FAST) {
+      ret = a*horner(a2, { 0.0208351f, -0.0851330f, 0.1801410f, -0.3302995f, 0.9998660f });
+    } else {
+      ret = a*horner(a2, {
+         0.0028662257f, -0.0161657367f, 0.0429096138f, -0.0752896400f, 0.1065626393f,
+        -0.1420889944f,  0.1999355085f, -0.3333314528f,  1.0f
+      });
+    }
+
+    return ret;
+  });
+}
+
+}  // anon namespace
+
+
+/**
+ * Reciprocal, refined with Newton steps: r' = r*(2 - x*r)
+ */
+FloatExpr recip(FloatExpr x_in, Precision p) {
+  Float x = x_in;
+  Float r = V3DLib::recip(x);
+
+  int steps = newton_steps(p);
+  if (steps > 0) {
+    Where (x != 0.0f)                                      // Keep inf for zero input
+      for (int i = 0; i < steps; i++) {
+        r = r*(2.0f - x*r);
+      }
+    End
+  }
+
+  return r;
+}
+
+
+/**
+ * Reciprocal square root, refined with Newton steps: y' = y*(1.5 - 0.5*x*y*y)
+ */
+FloatExpr rsqrt(FloatExpr x_in, Precision p) {
+  Float x = x_in;
+  Float y = V3DLib::recipsqrt(x);
+
+  int steps = newton_steps(p);
+  if (steps > 0) {
+    Where (x != 0.0f)
+      for (int i = 0; i < steps; i++) {
+        y = y*(1.5f - 0.5f*x*y*y);
+      }
+    End
+  }
+
+  return y;
+}
+
+
+/**
+ * Square root as x*rsqrt(x).
+ *
+ * For HIGH, the result gets a final correction step on the square root itself,
+ * which makes it correctly rounded in most cases.
+ */
+FloatExpr sqrt(FloatExpr x_in, Precision p) {
+  Float x = x_in;
+  Float y = rsqrt(x, p);
+  Float s = x*y;
+
+  if (p == HIGH) {
+    s = s + 0.5f*y*(x - s*s);
+  }
+
+  Where (x == 0.0f)                                        // Avoid 0*inf
+    s = 0.0f;
+  End
+
+  return s;
+}
+
+
+FloatExpr exp(FloatExpr x_in, Precision p) {
+  if (p == FAST) {
+    return V3DLib::exp(x_in*LOG2E);
+  }
+
+  return functions::float_subroutine(sub_name("exp", p).c_str(), x_in, [p] (FloatExpr x) {
+    Float scale;
+    Float q;
+    exp_reduce(x, p, scale, q);
+
+    Float ret = scale + scale*q;
+    return ret;
+  });
+}
+
+
+/**
+ * Natural logarithm
+ *
+ * The input must be a positive normal float; other values are not checked for.
+ */
+FloatExpr log(FloatExpr x_in, Precision p) {
+  if (p == FAST) {
+    return V3DLib::log(x_in)*(1.0f/LOG2E);
+  }
+
+  return functions::float_subroutine(sub_name("log", p).c_str(), x_in, [p] (FloatExpr x) {
+    return log_intern(x, p);
+  });
+}
+
+
+/**
+ * x^y for x >= 0, as exp(y*log(x))
+ *
+ * The relative error of the log is multiplied by |y*log(x)| in the result.
+ */
+FloatExpr pow(FloatExpr x_in, FloatExpr y, Precision p) {
+  Float x   = x_in;
+  Float ret = exp(y*log(x, p), p);
+
+  Where (x == 0.0f)
+    ret = 0.0f;
+  End
+
+  return ret;
+}
+
+
+/**
+ * tanh(x) = expm1(2x)/(expm1(2x) + 2)
+ *
+ * Using expm1 keeps the relative precision for small x.
+ */
+FloatExpr tanh(FloatExpr x_in, Precision p) {
+  return functions::float_subroutine(sub_name("tanh", p).c_str(), x_in, [p] (FloatExpr x_param) {
+    Float x = x_param;                                     comment("Start tanh");
+    Float ret;
+
+    if (p == FAST) {
+      // Saturates correctly: exp gives inf for large x, 0 for large -x
+      ret = 1.0f - 2.0f*V3DLib::recip(V3DLib::exp(x*(2*LOG2E)) + 1.0f);
+    } else {
+      Float a = functions::fabs(x);
+      Float scale;
+      Float q;
+      exp_reduce(2.0f*a, p, scale, q);
+
+      Float em1 = (scale - 1.0f) + scale*q;
+      ret = em1*recip(em1 + 2.0f, p);
+
+      Where (a > 9.0f)                                     // tanh(9) rounds to 1
+        ret = 1.0f;
+      End
+
+      Where (x < 0.0f)
+        ret = 0.0f - ret;
+      End
+    }
+
+    return ret;
+  });
+}
+
+
+/**
+ * Angle of vector (x, y), in range -pi..pi
+ *
+ * The ratio of the smallest to the largest absolute coordinate is passed to atan(),
+ * and the result is mapped to the correct octant.
+ */
+FloatExpr atan2(FloatExpr y_in, FloatExpr x_in, Precision p) {
+  Float y  = y_in;
+  Float x  = x_in;
+  Float ax = functions::fabs(x);
+  Float ay = functions::fabs(y);
+  Float mn = ax;
+  Float mx = ay;
+
+  Where (ax > ay)
+    mn = ay;
+    mx = ax;
+  End
+
+  Float a = mn*recip(mx, p);
+  Where (mx == 0.0f)
+    a = 0.0f;
+  End
+
+  Float ret = atan01(a, p);
+
+  Where (ay > ax)
+    ret = PI_2 - ret;
+  End
+
+  Where (x < 0.0f)
+    ret = PI - ret;
+  End
+
+  Where (y < 0.0f)
+    ret = 0.0f - ret;
+  End
+
+  return ret;
+}
+
+
+FloatExpr asin(FloatExpr x_in, Precision p) {
+  Float x = x_in;
+  return atan2(x, sqrt((1.0f - x)*(1.0f + x), p), p);
+}
+
+
+FloatExpr acos(FloatExpr x_in, Precision p) {
+  Float x = x_in;
+  return atan2(sqrt((1.0f - x)*(1.0f + x), p), x, p);
+}
+
+
+/**
+ * Sine and cosine of x in radians, with a shared range reduction
+ *
+ * x is reduced to r = x - q*pi/2 with |r| <= pi/4, the quadrant q determines which
+ * polynomial goes where and with which sign.
+ *
+ * The polynomials are minimax fits on -pi/4..pi/4 (Cephes sinf/cosf).
+ * HIGH uses a three-part reduction, which keeps the precision for larger |x|.
+ *
+ * FAST uses the platform `sin()`/`cos()`, which take input normalized to 2*pi.
+ */
+void sincos(FloatExpr x_in, Float &s, Float &c, Precision p) {
+  if (p == FAST) {
+    Float t = x_in*INV_2PI;
+    s = V3DLib::sin(t);
+    c = V3DLib::cos(t);
+    return;
+  }
+
+  Float x = x_in;                                          comment("Start sincos");
+  Float q = functions::ffloor(x*TWO_OVER_PI + 0.5f);
+
+  Float r;
+  if (p == HIGH) {
+    r = ((x - q*PIO2_1) - q*PIO2_2) - q*PIO2_3;
+  } else {
+    r = (x - q*PIO2_HI) - q*PIO2_LO;
+  }
+
+  Float r2 = r*r;
+  Float sr = r + r*r2*horner(r2, { -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f });
+  Float cr = 1.0f - 0.5f*r2
+           + r2*r2*horner(r2, { 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f });
+
+  Int quadrant = toInt(q) & 3;
+
+  s = sr;
+  c = cr;
+
+  Where (quadrant == 1)
+    s = cr;
+    c = 0.0f - sr;
+  End
+
+  Where (quadrant == 2)
+    s = 0.0f - sr;
+    c = 0.0f - cr;
+  End
+
+  Where (quadrant == 3)
+    s = 0.0f - cr;
+    c = sr;
+  End
+}
+
+}  // namespace math
+}  // namespace V3DLib
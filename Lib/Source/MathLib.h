@@ -0,0 +1,66 @@
+#ifndef _V3DLIB_SOURCE_MATHLIB_H_
+#define _V3DLIB_SOURCE_MATHLIB_H_
+#include "Int.h"
+#include "Float.h"
+
+namespace V3DLib {
+
+/**
+ * Transcendental functions at the source language level
+ *
+ * All functions take a precision tier per call:
+ *
+ * - FAST   - Use the SFU directly or with minimal code around it. On vc4 hardware, the SFU
+ *            results have a relative error of about 3e-4; the interpreter and emulator are exact.
+ * - MEDIUM - Refine SFU results with one Newton step, or use range reduction with a polynomial
+ *            that is good to a few ULP. This is the default.
+ * - HIGH   - Two Newton steps, higher-degree polynomials, and a wider valid input range for sincos.
+ *
+ * The larger functions are compiled as subroutines, one per function and tier.
+ *
+ * Max errors in ULP measured with the interpreter (see `Tests/testMath.cpp`):
+ *
+ *   function   MEDIUM  HIGH   input range
+ *   --------   ------  ----   -----------
+ *   recip         1      1    any nonzero; recip(0) = inf
+ *   rsqrt         2      2    x > 0
+ *   sqrt          2      1    x >= 0
+ *   exp           3      1    -87 <= x <= 88, clamped outside
+ *   log           3      3    positive normal floats
+ *   pow          20     20    x >= 0, |y*log(x)| <= 40. The error grows with |y*log(x)|
+ *   tanh          3      3    any
+ *   atan2         2      2    any; atan2(0, 0) = 0
+ *   asin/acos     3      3    -1 <= x <= 1
+ *   sincos        2      2    MEDIUM: |x| <= pi, HIGH: |x| <= 8192
+ *
+ * On vc4 hardware, the MEDIUM results for recip, rsqrt and sqrt are a few ULP worse,
+ * because one Newton step squares the initial relative error of the SFU.
+ *
+ * For FAST, the error is relative or absolute rather than in ULP. sincos FAST uses the
+ * platform's `sin()`/`cos()`, which on vc4 has an absolute error of about 0.06
+ * (see `functions::cos()`).
+ */
+namespace math {
+
+enum Precision {
+  FAST,
+  MEDIUM,
+  HIGH
+};
+
+FloatExpr recip(FloatExpr x, Precision p = MEDIUM);
+FloatExpr rsqrt(FloatExpr x, Precision p = MEDIUM);
+FloatExpr sqrt(FloatExpr x, Precision p = MEDIUM);
+FloatExpr exp(FloatExpr x, Precision p = MEDIUM);
+FloatExpr log(FloatExpr x, Precision p = MEDIUM);
+FloatExpr pow(FloatExpr x, FloatExpr y, Precision p = MEDIUM);
+FloatExpr tanh(FloatExpr x, Precision p = MEDIUM);
+FloatExpr atan2(FloatExpr y, FloatExpr x, Precision p = MEDIUM);
+FloatExpr asin(FloatExpr x, Precision p = MEDIUM);
+FloatExpr acos(FloatExpr x, Precision p = MEDIUM);
+void sincos(FloatExpr x, Float &s, Float &c, Precision p = MEDIUM);
+
+}  // namespace math
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_MATHLIB_H_
@@ -25,6 +25,9 @@ enum OpId {
   // Conversion operators:
   ItoF, FtoI,
 
+  // Packed 8-bit operators, vc4 only (type UINT8)
+  V8ADDS, V8SUBS, V8MUL, V8MIN, V8MAX,
+
   // SFU functions
   RECIP,
   RECIPSQRT,
@@ -38,6 +41,9 @@ enum OpId {
   TIDX,
   EIDX,
   FFLOOR,
+  HALF_PACK,
+  HALF_LO,
+  HALF_HI
 };
 
 
@@ -24,11 +24,21 @@ std::vector<OpItem> m_list = {
   {BXOR,   " ^ ",      false, ALUOp::NONE,     ALUOp::A_BXOR},
   {BNOT,   "~",        false, ALUOp::NONE,     ALUOp::A_BNOT, false, 1},
 
+  // Packed 8-bit, vc4 only
+  {V8ADDS, " +b ",     false, ALUOp::NONE,     ALUOp::A_V8ADDS},
+  {V8SUBS, " -b ",     false, ALUOp::NONE,     ALUOp::A_V8SUBS},
+  {V8MUL,  " *b ",     false, ALUOp::NONE,     ALUOp::M_V8MUL},
+  {V8MIN,  " minb ",   false, ALUOp::NONE,     ALUOp::M_V8MIN},
+  {V8MAX,  " maxb ",   false, ALUOp::NONE,     ALUOp::M_V8MAX},
+
   // v3d-specific
   {FFLOOR, "ffloor",    true, ALUOp::A_FFLOOR, ALUOp::NONE,   true},
   {SIN,    "sin",       true, ALUOp::A_FSIN,   ALUOp::NONE,   true},  // also SFU function
   {TIDX,   "tidx",     false, ALUOp::NONE,     ALUOp::A_TIDX, true, 0},
   {EIDX,   "eidx",     false, ALUOp::NONE,     ALUOp::A_EIDX, true, 0},
+  {HALF_PACK, " vfpack ", false, ALUOp::A_VFPACK,   ALUOp::NONE, true},
+  {HALF_LO,   "half_lo",  true,  ALUOp::A_FUNPACKL, ALUOp::NONE, true},
+  {HALF_HI,   "half_hi",  true,  ALUOp::A_FUNPACKH, ALUOp::NONE, true},
 
   // SFU functions
   {RECIP,     "recip",     true, ALUOp::NONE,     ALUOp::NONE},
@@ -100,6 +100,39 @@ std::string pretty(int indent, Stmt::Ptr s) {
           << "receive(" << s->address()->pretty() << ")";
       break;
 
+    case Stmt::STORE_SCATTER:
+      ret << indentBy(indent)
+          << "scatter(" << s->scatter_addr()->pretty() << ", " << s->scatter_val()->pretty() << ")";
+      break;
+
+    case Stmt::ATOMIC: {
+        auto a = s->atomic();
+        ret << indentBy(indent)
+            << mkVar(a->dst)->pretty() << " = " << Stmt::Atomic::name(a->op) << "(" << a->addr->pretty();
+        if (a->cmp) ret << ", " << a->cmp->pretty();
+        ret << ", " << a->val->pretty() << ")";
+      }
+      break;
+
+    case Stmt::BARRIER:
+      ret << indentBy(indent) << "barrier()";
+      break;
+
+    case Stmt::LOCAL_ACCESS: {
+        auto a = s->local_access();
+        ret << indentBy(indent);
+        if (a->is_store) {
+          ret << "local[" << a->base << " + " << a->row->pretty() << "] = " << a->val->pretty();
+        } else {
+          ret << mkVar(a->dst)->pretty() << " = local[" << a->base << " + " << a->row->pretty() << "]";
+        }
+      }
+      break;
+
+    case Stmt::CALL:
+      ret << indentBy(indent) << "call " << s->subroutine()->name << "()";
+      break;
+
     case Stmt::GATHER_PREFETCH:
       ret << indentBy(indent) << "Prefetch Tag";
       break;
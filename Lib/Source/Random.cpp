@@ -0,0 +1,180 @@
+#include "Random.h"
+#include "Support/basics.h"
+#include "Lang.h"
+
+namespace V3DLib {
+namespace random {
+namespace {
+
+uint32_t const KS_PARITY = 0x1BD11BDA;  // From the Skein key schedule
+
+// Rotation constants of Threefry-2x32, applied cyclically per round
+int const ROTATIONS[8] = { 13, 15, 26, 6, 17, 29, 16, 24 };
+
+float const TWO_POW_M17 = 1.0f/131072.0f;
+float const TWO_POW_M24 = 1.0f/16777216.0f;
+
+int const NORMAL_OFFSET = 12 - 12*65536;  // Centers the sum of `2*h + 1` for 12 halves h
+
+
+uint32_t rotl(uint32_t x, int n) {
+  return (x << n) | (x >> (32 - n));
+}
+
+}  // anon namespace
+
+
+/**
+ * Threefry-2x32 block function
+ *
+ * Verified against the known-answer tests of Random123 in `Tests/testFunctions.cpp`.
+ */
+void threefry2x32(uint32_t const ctr[2], uint32_t const key[2], uint32_t out[2], int rounds) {
+  uint32_t ks[3] = { key[0], key[1], KS_PARITY ^ key[0] ^ key[1] };
+  uint32_t x0 = ctr[0] + ks[0];
+  uint32_t x1 = ctr[1] + ks[1];
+
+  for (int r = 0; r < rounds; r++) {
+    x0 += x1;
+    x1 = rotl(x1, ROTATIONS[r % 8]);
+    x1 ^= x0;
+
+    if (r % 4 == 3) {
+      uint32_t i = (uint32_t) (r + 1)/4;
+      x0 += ks[i % 3];
+      x1 += ks[(i + 1) % 3] + i;
+    }
+  }
+
+  out[0] = x0;
+  out[1] = x1;
+}
+
+
+/**
+ * Convert to a float in [0, 1), using the upper 24 bits
+ */
+float to_uniform(uint32_t x) {
+  return (float) (x >> 8) * TWO_POW_M24;
+}
+
+
+/**
+ * Convert six random words to an approximately normal distributed value,
+ * with mean 0 and variance 1.
+ *
+ * This is the sum of 12 uniform values of 16 bits, minus the mean (Irwin-Hall distribution).
+ * The sum is done with integers, so that the result is exact on all platforms.
+ * The tails are cut off at +/-6.
+ */
+float to_normal(uint32_t const x[6]) {
+  int sum = 0;
+
+  for (int i = 0; i < 6; i++) {
+    sum += (int) (x[i] & 0xffff) + (int) (x[i] >> 16);
+  }
+
+  return (float) (2*sum + NORMAL_OFFSET) * TWO_POW_M17;
+}
+
+}  // namespace random
+
+
+using namespace random;
+
+///////////////////////////////////////////////////////////////////////////////
+// Class Random
+///////////////////////////////////////////////////////////////////////////////
+
+Random::Random(IntExpr seed, int rounds) : Random(seed, 16*me() + index(), rounds) {}
+
+
+/**
+ * @param seed    first word of the key, typically a kernel parameter
+ * @param stream  second word of the key, needs to be different per lane for independent streams
+ * @param rounds  number of Threefry rounds
+ */
+Random::Random(IntExpr seed, IntExpr stream, int rounds) : m_rounds(rounds) {
+  assertq(rounds >= 13, "Random: need at least 13 rounds for usable random numbers", true);
+
+  m_key[0]  = seed;                     comment("Init random stream");
+  m_key[1]  = stream;
+  m_key[2]  = m_key[0] ^ m_key[1] ^ (int) KS_PARITY;
+  m_counter = 0;
+}
+
+
+/**
+ * Get the next block of 64 random bits
+ */
+void Random::next(Int &x0, Int &x1) {
+  x0 = m_counter + m_key[0];            comment("Threefry-2x32");
+  x1 = m_key[1];
+
+  for (int r = 0; r < m_rounds; r++) {
+    x0 += x1;
+    x1 = ror(x1, 32 - ROTATIONS[r % 8]);
+    x1 = x1 ^ x0;
+
+    if (r % 4 == 3) {
+      int i = (r + 1)/4;
+      x0 += m_key[i % 3];
+      x1 += m_key[(i + 1) % 3] + i;
+    }
+  }
+
+  m_counter++;
+}
+
+
+/**
+ * @return 32 random bits
+ */
+IntExpr Random::next_int() {
+  Int x0, x1;
+  next(x0, x1);
+  return x0;
+}
+
+
+/**
+ * @return uniformly distributed value in [0, 1), in steps of 2^-24
+ */
+FloatExpr Random::uniform() {
+  Float ret = toFloat(shr(next_int(), 8)) * TWO_POW_M24;
+  return ret;
+}
+
+
+/**
+ * Get two uniformly distributed values in [0, 1) from a single block.
+ *
+ * Half the cost per value of `uniform()`, which discards the second word of the block.
+ */
+void Random::uniform(Float &u0, Float &u1) {
+  Int x0, x1;
+  next(x0, x1);
+  u0 = toFloat(shr(x0, 8)) * TWO_POW_M24;
+  u1 = toFloat(shr(x1, 8)) * TWO_POW_M24;
+}
+
+
+/**
+ * @return approximately normal distributed value, with mean 0 and variance 1.
+ *
+ * See `random::to_normal()` for details.
+ */
+FloatExpr Random::normal() {
+  Int sum = 0;
+
+  For (Int k = 0, k < 3, k++)
+    Int x0, x1;
+    next(x0, x1);
+    sum += (x0 & 0xffff) + shr(x0, 16) + (x1 & 0xffff) + shr(x1, 16);
+  End
+
+  Float ret = toFloat((sum << 1) + NORMAL_OFFSET) * TWO_POW_M17;
+  return ret;
+}
+
+}  // namespace V3DLib
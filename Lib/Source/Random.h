@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// This module defines counter-based random number streams for kernels.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _V3DLIB_SOURCE_RANDOM_H_
+#define _V3DLIB_SOURCE_RANDOM_H_
+#include <cstdint>
+#include "Int.h"
+#include "Float.h"
+
+namespace V3DLib {
+
+namespace random {
+
+int const DEFAULT_ROUNDS = 20;
+
+//
+// Host versions, for reproducing the kernel values on the CPU.
+// The kernel values are bit-identical to these. For the values from both words of
+// a block, apply `to_uniform()` to both words of the output of `threefry2x32()`.
+//
+void threefry2x32(uint32_t const ctr[2], uint32_t const key[2], uint32_t out[2], int rounds = DEFAULT_ROUNDS);
+float to_uniform(uint32_t x);
+float to_normal(uint32_t const x[6]);
+
+}  // namespace random
+
+
+/**
+ * Random number stream per vector lane, generated with Threefry-2x32.
+ *
+ * Threefry is a counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy
+ * as 1, 2, 3"): a block of 64 random bits is a hash of a counter and a key. It only uses
+ * integer add, rotate and xor, so the values are the same in the interpreter, the emulator
+ * and on the QPUs, and independent streams are obtained by using different keys.
+ *
+ * The key is (seed, stream), the counter is (n, 0) for the n-th block of the stream.
+ * By default, the stream is `16*me() + index()`, giving every lane of every QPU its own stream:
+ *
+ *     void kernel(Float::Ptr out, Int seed) {
+ *       Random rng(seed);
+ *       *out = rng.uniform();
+ *     }
+ *
+ * Every call of `next()`, `next_int()` or `uniform()` consumes one block, `normal()` three.
+ * `next_int()` and `uniform()` use only the first word of the block. When many values are
+ * needed, `next(x0, x1)` and `uniform(u0, u1)` return values for both words at the same cost.
+ *
+ * 20 rounds is the default of Random123. 13 rounds is the minimum which passes
+ * the BigCrush tests according to the paper above, and needs about a third fewer instructions.
+ */
+class Random {
+public:
+  Random(IntExpr seed, int rounds = random::DEFAULT_ROUNDS);
+  Random(IntExpr seed, IntExpr stream, int rounds = random::DEFAULT_ROUNDS);
+
+  void next(Int &x0, Int &x1);
+  IntExpr next_int();
+  FloatExpr uniform();
+  void uniform(Float &u0, Float &u1);
+  FloatExpr normal();
+
+  Int &counter() { return m_counter; }
+
+private:
+  int m_rounds;
+  Int m_key[3];  // Third value is the parity of the key schedule
+  Int m_counter;
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SOURCE_RANDOM_H_
@@ -79,6 +79,20 @@ Expr::Ptr Stmt::address() {
 }
 
 
+Expr::Ptr Stmt::scatter_addr() const {
+  assert(tag == STORE_SCATTER);
+  assert(m_exp_a.get() != nullptr);
+  return m_exp_a;
+}
+
+
+Expr::Ptr Stmt::scatter_val() const {
+  assert(tag == STORE_SCATTER);
+  assert(m_exp_b.get() != nullptr);
+  return m_exp_b;
+}
+
+
 bool Stmt::check_blocks() const {
   // then and else blocks may not both be empty
   if (m_stmts_a.empty() && m_stmts_b.empty()) return false;
@@ -274,6 +288,21 @@ std::string Stmt::disp_intern(bool with_linebreaks, int seq_depth) const {
     case GATHER_PREFETCH:  ret << "GATHER_PREFETCH";  break;
     case FOR:              ret << "FOR";              break;
     case LOAD_RECEIVE:     ret << "LOAD_RECEIVE";     break;
+    case STORE_SCATTER:
+      ret << "SCATTER " << scatter_addr()->dump() << " = " << scatter_val()->dump();
+    break;
+    case CALL:             ret << "CALL " << subroutine()->name; break;
+    case BARRIER:          ret << "BARRIER"; break;
+    case LOCAL_ACCESS:
+      if (local_access()->is_store) {
+        ret << "LOCAL_STORE " << local_access()->row->dump() << " = " << local_access()->val->dump();
+      } else {
+        ret << "LOCAL_LOAD " << local_access()->row->dump();
+      }
+    break;
+    case ATOMIC:
+      ret << "ATOMIC " << Atomic::name(atomic()->op) << " " << atomic()->addr->dump();
+    break;
 
     default: {
         std::string tmp = DMA::disp(tag);
@@ -326,6 +355,12 @@ Stmt::Ptr Stmt::create(Tag in_tag, Expr::Ptr e0, Expr::Ptr e1) {
       ret->m_exp_a = e0;
     break;
 
+    case STORE_SCATTER:
+      assertq(e0 != nullptr && e1 != nullptr, "create 3");
+      ret->m_exp_a = e0;
+      ret->m_exp_b = e1;
+    break;
+
     case GATHER_PREFETCH:
       // Nothing to do
     break;
@@ -346,6 +381,36 @@ Stmt::Ptr Stmt::create_assign(Expr::Ptr lhs, Expr::Ptr rhs) {
 }
 
 
+Stmt::Ptr Stmt::create_call(Subroutine::Ptr sub) {
+  assert(sub.get() != nullptr);
+  Ptr ret = create(CALL);
+  ret->m_subroutine = sub;
+  return ret;
+}
+
+
+Stmt::Ptr Stmt::create_atomic(Atomic::Ptr atomic) {
+  assert(atomic.get() != nullptr);
+  assert(atomic->addr.get() != nullptr && atomic->val.get() != nullptr);
+  assert((atomic->op == Atomic::CMPXCHG) == (atomic->cmp.get() != nullptr));
+
+  Ptr ret = create(ATOMIC);
+  ret->m_atomic = atomic;
+  return ret;
+}
+
+
+Stmt::Ptr Stmt::create_local_access(LocalAccess::Ptr access) {
+  assert(access.get() != nullptr);
+  assert(access->row.get() != nullptr);
+  assert(access->is_store == (access->val.get() != nullptr));
+
+  Ptr ret = create(LOCAL_ACCESS);
+  ret->m_local_access = access;
+  return ret;
+}
+
+
 CExpr::Ptr Stmt::if_cond() const {
   assert(tag == IF);
   assert(m_cond.get() != nullptr);
@@ -360,6 +425,27 @@ CExpr::Ptr Stmt::loop_cond() const {
 }
 
 
+Stmt::Subroutine::Ptr Stmt::subroutine() const {
+  assert(tag == CALL);
+  assert(m_subroutine.get() != nullptr);
+  return m_subroutine;
+}
+
+
+Stmt::Atomic::Ptr Stmt::atomic() const {
+  assert(tag == ATOMIC);
+  assert(m_atomic.get() != nullptr);
+  return m_atomic;
+}
+
+
+Stmt::LocalAccess::Ptr Stmt::local_access() const {
+  assert(tag == LOCAL_ACCESS);
+  assert(m_local_access.get() != nullptr);
+  return m_local_access;
+}
+
+
 /**
  * Do a leftmost search for non-SEQ item
  */
@@ -382,6 +468,24 @@ Stmt *Stmt::first_in_seq() const {
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Class Stmt::Atomic
+///////////////////////////////////////////////////////////////////////////////
+
+char const *Stmt::Atomic::name(Op op) {
+  switch (op) {
+    case ADD:      return "atomic_add";
+    case MIN:      return "atomic_min";
+    case MAX:      return "atomic_max";
+    case EXCHANGE: return "atomic_exchange";
+    case CMPXCHG:  return "atomic_cmpxchg";
+  }
+
+  assert(false);
+  return "";
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Class Stmt::Array
 ///////////////////////////////////////////////////////////////////////////////
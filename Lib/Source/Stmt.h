@@ -40,6 +40,11 @@ struct Stmt : public InstructionComment {
     WHILE,
     FOR,
     LOAD_RECEIVE,
+    STORE_SCATTER,
+    ATOMIC,
+    BARRIER,          // v3d only, vc4 uses semaphores directly
+    LOCAL_ACCESS,
+    CALL,
 
     GATHER_PREFETCH,
 
@@ -66,6 +71,65 @@ struct Stmt : public InstructionComment {
     std::string dump() const;
   };
 
+  /**
+   * Definition of an out-of-line subroutine.
+   *
+   * Parameters and results are passed in fixed variables, which are
+   * assigned around the call sites. The body is translated once per kernel.
+   */
+  struct Subroutine {
+    using Ptr = std::shared_ptr<Subroutine>;
+
+    std::string name;
+    std::vector<Var> params;
+    std::vector<Var> results;
+    Array body;
+  };
+
+  /**
+   * Atomic read-modify-write on the per-lane addresses of a pointer.
+   *
+   * Lanes are handled in order. Platforms without hardware support for atomics
+   * get a lowered version in `body`, which is used for translation.
+   */
+  struct Atomic {
+    using Ptr = std::shared_ptr<Atomic>;
+
+    enum Op {
+      ADD,
+      MIN,
+      MAX,
+      EXCHANGE,
+      CMPXCHG
+    };
+
+    Op op = ADD;
+    Var dst = Var(DUMMY);  // Receives the values before the operation
+    Expr::Ptr addr;
+    Expr::Ptr val;
+    Expr::Ptr cmp;         // CMPXCHG only
+    Array body;            // Lowered version
+
+    static char const *name(Op op);
+  };
+
+  /**
+   * Load or store of a vector row in local memory.
+   *
+   * The row index is taken from the first vector element.
+   */
+  struct LocalAccess {
+    using Ptr = std::shared_ptr<LocalAccess>;
+
+    bool is_store = false;
+    int base = 0;          // First row of the local array in local memory
+    int size = 0;          // Number of rows of the local array
+    Var dst = Var(DUMMY);  // Load only
+    Expr::Ptr row;
+    Expr::Ptr val;         // Store only
+    Array body;            // Lowered version
+  };
+
   ~Stmt() {}
 
   Stmt &header(std::string const &msg) { InstructionComment::header(msg);  return *this; }
@@ -87,6 +151,8 @@ struct Stmt : public InstructionComment {
   Expr::Ptr assign_lhs() const;
   Expr::Ptr assign_rhs() const;
   Expr::Ptr address();
+  Expr::Ptr scatter_addr() const;
+  Expr::Ptr scatter_val() const;
   Stmt *first_in_seq() const;
 
   Array const &then_block() const;
@@ -101,12 +167,19 @@ struct Stmt : public InstructionComment {
   CExpr::Ptr if_cond() const;
   CExpr::Ptr loop_cond() const;
 
+  Subroutine::Ptr subroutine() const;
+  Atomic::Ptr atomic() const;
+  LocalAccess::Ptr local_access() const;
+
   //
   // Instantiation methods
   //
   static Ptr create(Tag in_tag);
   static Ptr create(Tag in_tag, Expr::Ptr e0, Expr::Ptr e1);
   static Ptr create_assign(Expr::Ptr lhs, Expr::Ptr rhs);
+  static Ptr create_call(Subroutine::Ptr sub);
+  static Ptr create_atomic(Atomic::Ptr atomic);
+  static Ptr create_local_access(LocalAccess::Ptr access);
 
   Tag tag;
   DMA::Stmt dma;
@@ -125,6 +198,10 @@ private:
 
   CExpr::Ptr m_cond;
 
+  Subroutine::Ptr m_subroutine;
+  Atomic::Ptr m_atomic;
+  LocalAccess::Ptr m_local_access;
+
   bool m_break_point = false;
 
   static Ptr create(Tag in_tag, Ptr s0, Ptr s1);
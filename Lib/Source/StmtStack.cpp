@@ -8,13 +8,21 @@ namespace {
 
 StmtStack *p_stmtStack = nullptr;
 
-StmtStack::Ptr tempStack(StackCallback f) {
+/**
+ * @param nested  if true, the generated statements are inserted at the current position
+ *                of the global stack. Otherwise, they are independent of it.
+ */
+StmtStack::Ptr tempStack(StackCallback f, bool nested = true) {
   StmtStack::Ptr stack;
   stack.reset(new StmtStack);
   stack->reset();
 
   // Temporarily replace global stack
   StmtStack *global_stack = p_stmtStack;
+  if (nested) {
+    stack->parent(global_stack);
+  }
+
   p_stmtStack = stack.get();
 
   f();  
@@ -26,8 +34,8 @@ StmtStack::Ptr tempStack(StackCallback f) {
 } // anon namespace
 
 
-Stmts tempStmt(StackCallback f) {
-  StmtStack::Ptr assign = tempStack(f);
+Stmts tempStmt(StackCallback f, bool nested) {
+  StmtStack::Ptr assign = tempStack(f, nested);
   assert(assign->size() == 1);
   return *assign->top();
 }
@@ -260,6 +268,32 @@ Stmt *StmtStack::first_in_seq() const {
 }
 
 
+/**
+ * Check if statements are currently being added to the body of a 'Where'.
+ *
+ * The stack levels alternate between blocks and the statements owning these blocks,
+ * with a block on top. Hence only every second level needs to be checked.
+ */
+bool StmtStack::in_where() const {
+  bool ret = false;
+  int level = 0;
+
+  each([&ret, &level] (Stmts const &item) {
+    if (level % 2 == 1 && !item.empty() && item.back()->tag == Stmt::WHERE) {
+      ret = true;
+    }
+
+    level++;
+  });
+
+  if (!ret && m_parent != nullptr) {
+    ret = m_parent->in_where();
+  }
+
+  return ret;
+}
+
+
 StmtStack &stmtStack() {
   assert(p_stmtStack != nullptr);
   return *p_stmtStack;
@@ -32,6 +32,8 @@ public:
   std::string dump() const;
 
   Stmt *first_in_seq() const;
+  bool in_where() const;
+  void parent(StmtStack *p) { m_parent = p; }
 
   void first_prefetch(int prefetch_label);
   void add_prefetch(Pointer &exp, int prefetch_label);
@@ -56,6 +58,7 @@ private:
   };
 
   std::map<int, PrefetchContext> prefetches;
+  StmtStack *m_parent = nullptr;  // Enclosing stack of a temporary stack
 
   void add_prefetch_label(int prefetch_label);
 };
@@ -91,7 +94,7 @@ int prefetch_label();
 
 
 using StackCallback = std::function<void()>;
-Stmts tempStmt(StackCallback f);
+Stmts tempStmt(StackCallback f, bool nested = true);
 
 }  // namespace V3DLib
 
@@ -499,6 +499,7 @@ void translateWhile(Instr::List &seq, Stmt &s) {
       << label(startLabel);                            // Start label
 
   if (!s.body().empty()) stmts(&seq, s.body());        // Compile body
+  seq << getSourceTranslate().loop_end(s);
   condExp(seq, *s.loop_cond());                        // Compute condition again
                                                        // TODO why is this necessary?
 
@@ -507,6 +508,102 @@ void translateWhile(Instr::List &seq, Stmt &s) {
 }
 
 
+// ============================================================================
+// Subroutines
+// ============================================================================
+
+/**
+ * Translation state of a subroutine called from the kernel.
+ *
+ * A call site stores its index in the link variable and branches to the entry label.
+ * On exit, the subroutine dispatches on the link variable to the return label of the
+ * call site. All branches go to labels, so that liveness analysis and register allocation
+ * see a regular control flow graph.
+ */
+struct SubroutineInfo {
+  SubroutineInfo(Stmt::Subroutine::Ptr in_def) : def(in_def), entry(freshLabel()), link(VarGen::fresh()) {}
+
+  Stmt::Subroutine::Ptr def;
+  Label entry;
+  Var link;
+  std::vector<Label> returns;  // Return label per call site, index is the link value
+  Instr::List code;            // Translated body
+};
+
+std::vector<SubroutineInfo> subroutines;  // Subroutines in order of first call
+
+
+int subroutine_index(Stmt::Subroutine::Ptr def) {
+  for (int i = 0; i < (int) subroutines.size(); i++) {
+    if (subroutines[i].def == def) return i;
+  }
+
+  subroutines.push_back(SubroutineInfo(def));
+
+  return (int) subroutines.size() - 1;
+}
+
+
+void translateCall(Instr::List &seq, Stmt &s) {
+  using namespace Target::instr;
+
+  auto &info = subroutines[subroutine_index(s.subroutine())];
+  Label retLabel = freshLabel();
+  int link_value = (int) info.returns.size();
+  info.returns.push_back(retLabel);
+
+  std::string cmt;
+  cmt << "Call " << info.def->name;
+
+  seq << li(info.link, link_value).comment(cmt)
+      << branch(info.entry).call(retLabel)
+      << label(retLabel);
+}
+
+
+/**
+ * Emit the bodies of all called subroutines after the kernel code.
+ *
+ * Bodies may contain calls themselves, which adds call sites and possibly new subroutines.
+ * Therefore, all bodies are translated before any dispatch code is generated.
+ */
+void translateSubroutines(Instr::List &seq) {
+  using namespace Target::instr;
+
+  if (subroutines.empty()) return;
+
+  for (int i = 0; i < (int) subroutines.size(); i++) {  // size may grow during the loop
+    Instr::List code;
+    stmts(&code, subroutines[i].def->body);
+    subroutines[i].code = code;
+  }
+
+  Label endLabel = freshLabel();
+  seq << branch(endLabel).comment("Skip subroutines");
+
+  for (auto &info : subroutines) {
+    assert(!info.returns.empty());
+
+    std::string msg;
+    msg << "Subroutine " << info.def->name;
+    seq << label(info.entry).header(msg)
+        << info.code;
+
+    // Return to caller
+    for (int k = 0; k < (int) info.returns.size() - 1; k++) {
+      auto bexpr = std::make_shared<BExpr>(mkVar(info.link), CmpOp(CmpOp::EQ, INT32), mkIntLit(k));
+      BranchCond cond = condExp(seq, *mkAll(bexpr));
+      seq << branch(info.returns[k]).branch_cond(cond).subroutine_exit();
+    }
+
+    seq << branch(info.returns.back()).subroutine_exit();
+  }
+
+  seq << label(endLabel);
+  subroutines.clear();
+}
+
+
 // ============================================================================
 // Statements
 // ============================================================================
@@ -541,6 +638,25 @@ void stmt(Instr::List *seq, Stmt::Ptr s) {
       assert(s->address()->tag() == Expr::VAR);
       *seq << recv(s->address()->var());
       break;
+    case Stmt::STORE_SCATTER: {          // 'scatter(a, v)', where a and v are expressions
+        Var addr = putInVar(seq, s->scatter_addr())->var();
+        Var val  = putInVar(seq, s->scatter_val())->var();
+        *seq << getSourceTranslate().scatter_var(addr, val);
+      }
+      break;
+    case Stmt::ATOMIC:                   // Atomic operation, use the lowered version if present
+      if (!s->atomic()->body.empty()) {
+        stmts(seq, s->atomic()->body);
+      } else if (!getSourceTranslate().stmt(*seq, s)) {
+        assert(false);                   // Platform should support atomics
+      }
+      break;
+    case Stmt::LOCAL_ACCESS:             // Local memory access, use the lowered version
+      stmts(seq, s->local_access()->body);
+      break;
+    case Stmt::CALL:                     // Call to out-of-line subroutine
+      translateCall(*seq, *s);
+      break;
     default:
       if (!getSourceTranslate().stmt(*seq, s)) {
         assert(false); // Should not be reachable
@@ -679,6 +795,18 @@ Expr::Ptr putInVar(Instr::List *seq, Expr::Ptr e) {
 }
 
 
+/**
+ * Translate statements generated during translation.
+ *
+ * In contrast to `translate_stmt()`, this can be called from within a translation.
+ */
+Instr::List translate_block(Stmts const &s) {
+  Instr::List ret;
+  stmts(&ret, s);
+  return ret;
+}
+
+
 /**
  * Translate to target code
  *
@@ -686,10 +814,13 @@ Expr::Ptr putInVar(Instr::List *seq, Expr::Ptr e) {
  */
 void translate_stmt(Instr::List &seq, Stmts &s) {
   assert(seq.empty());  // TODO perhaps move this test up, or seq as return value
+  subroutines.clear();
 
   for (int i = 0; i < (int) s.size(); i++) {
     stmt(&seq, s[i]);
   }
+
+  translateSubroutines(seq);
 }
 
 }  // namespace V3DLib
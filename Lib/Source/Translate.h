@@ -14,6 +14,7 @@ void insertInitBlock(Instr::List &code);
 Instr::List varAssign(AssignCond cond, Var v, Expr::Ptr expr);
 Instr::List varAssign(Var v, Expr::Ptr expr);
 Expr::Ptr putInVar(Instr::List *seq, Expr::Ptr e);
+Instr::List translate_block(Stmts const &s);
 
 }  // namespace V3DLib
 
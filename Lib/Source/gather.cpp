@@ -28,6 +28,31 @@ void receive(Int &dest)   { receiveExpr(dest.expr()); }
 void receive(Float &dest) { receiveExpr(dest.expr()); }
 
 
+//=============================================================================
+// Scatter
+//=============================================================================
+
+/**
+ * Store the vector elements of `val` to the per-lane addresses in `addr`.
+ *
+ * This is the store counterpart of `gather()`. In contrast to a regular store,
+ * which writes the 16 elements consecutively from the address in the first lane,
+ * every element goes to its own address, e.g.:
+ *
+ *     scatter(dst + (perm - index()), val);  // dst[perm[i]] = val[i]
+ *
+ * On v3d, this is a regular TMU write. On vc4, the value is placed in the VPM
+ * and written with a separate DMA store per lane. This is correct but slow,
+ * use it only where the addresses are really arbitrary.
+ *
+ * If several lanes have the same address, the highest lane wins in the
+ * interpreter and the emulator. On v3d hardware, the order is unspecified.
+ */
+void scatterExpr(Expr::Ptr addr, Expr::Ptr val) {
+  stmtStack() << Stmt::create(Stmt::STORE_SCATTER, addr, val);
+}
+
+
 //=============================================================================
 // With gather limit
 //=============================================================================
@@ -33,6 +33,18 @@ void receive(Float &dest);
 inline void receive(BaseExpr &dest) { receiveExpr(dest.expr()); }
 
 
+//=============================================================================
+// Scatter operations
+//=============================================================================
+
+void scatterExpr(Expr::Ptr addr, Expr::Ptr val);
+
+inline void scatter(PtrExpr<Int> addr, IntExpr val)     { scatterExpr(addr.expr(), val.expr()); }
+inline void scatter(PtrExpr<Float> addr, FloatExpr val) { scatterExpr(addr.expr(), val.expr()); }
+inline void scatter(Int::Ptr &addr, IntExpr val)        { scatterExpr(addr.expr(), val.expr()); }
+inline void scatter(Float::Ptr &addr, FloatExpr val)    { scatterExpr(addr.expr(), val.expr()); }
+
+
 //=============================================================================
 // Gather, receive with gather limit
 //=============================================================================
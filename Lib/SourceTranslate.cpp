@@ -37,6 +37,28 @@ Instr::List ISourceTranslate::load_var(Var &in_dst, Expr &e) {
   return ret;
 }
 
+
+/**
+ * Store every vector element to the address in its own lane.
+ *
+ * By default the same as a regular store, which is the case when the store
+ * itself handles per-lane addresses (TMU writes on v3d).
+ */
+Instr::List ISourceTranslate::scatter_var(Var dst_addr, Var src) {
+  return store_var(dst_addr, src);
+}
+
+
+/**
+ * Code to add at the end of the body of given loop, before the loop condition is evaluated again.
+ *
+ * Default none.
+ */
+Instr::List ISourceTranslate::loop_end(Stmt const &loop) {
+  return Instr::List();
+}
+
+
 /**
  * Generate code to add an offset to the uniforms which are pointers.
  *
@@ -11,6 +11,8 @@ public:
 
   virtual Instr::List load_var(Var &dst, Expr &e);
   virtual Instr::List store_var(Var dst_addr, Var src) = 0;
+  virtual Instr::List scatter_var(Var dst_addr, Var src);
+  virtual Instr::List loop_end(Stmt const &loop);
   virtual void regAlloc(Instr::List &instrs) = 0;
   virtual bool stmt(Instr::List &seq, Stmt::Ptr s) = 0;
 };
@@ -0,0 +1,146 @@
+#include "CoExecutor.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "basics.h"
+
+namespace V3DLib {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+float const MIN_RATIO = 0.05f;  // Keep some work on both sides, so that calibration can continue
+float const MAX_RATIO = 0.95f;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // anon namespace
+
+
+/**
+ * @param granularity  split points are a multiple of this value
+ * @param num_threads  number of host threads to use. If -1, use all cores except
+ *                     one, which drives the QPUs.
+ */
+CoExecutor::CoExecutor(int granularity, int num_threads) : m_granularity(granularity) {
+  assertq(granularity > 0, "CoExecutor: granularity must be positive", true);
+
+  if (num_threads == -1) {
+    num_threads = std::max(1, (int) std::thread::hardware_concurrency() - 1);
+  }
+
+  assertq(num_threads > 0, "CoExecutor: need at least one host thread", true);
+  m_num_threads = num_threads;
+}
+
+
+/**
+ * Set the part of the range handled by the QPUs.
+ *
+ * This is the starting point; it is adjusted after every run.
+ */
+void CoExecutor::gpu_ratio(float val) {
+  assertq(0.0f <= val && val <= 1.0f, "CoExecutor: ratio must be in range 0..1", true);
+  m_ratio = val;
+}
+
+
+int CoExecutor::split(int size) const {
+  int ret = (int) ((float) size*m_ratio);
+  ret -= ret % m_granularity;
+  return std::min(ret, size);
+}
+
+
+/**
+ * Run given range on QPUs and host threads
+ *
+ * @param gpu  runs the kernel on the QPUs for the passed range. `begin` is always 0.
+ * @param cpu  runs the host version for the passed range. Called in parallel from multiple threads.
+ */
+void CoExecutor::run(int size, Part gpu, Part cpu) {
+  assert(size >= 0);
+  int const gpu_end = split(size);
+  m_last_split = gpu_end;
+
+  //
+  // Start the host threads on the upper part
+  //
+  int const cpu_items = size - gpu_end;
+  int const blocks    = (cpu_items + m_granularity - 1)/m_granularity;
+  int const threads   = std::min(m_num_threads, blocks);
+
+  std::vector<std::thread> pool;
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<double> times(threads, 0.0);
+  auto cpu_start = Clock::now();
+
+  for (int t = 0; t < threads; t++) {
+    int begin = gpu_end + m_granularity*((blocks*t)/threads);
+    int end   = std::min(size, gpu_end + m_granularity*((blocks*(t + 1))/threads));
+
+    pool.emplace_back([&cpu, &errors, &times, t, begin, end, cpu_start] {
+      try {
+        cpu(begin, end);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+      times[t] = seconds_since(cpu_start);
+    });
+  }
+
+  //
+  // Run the lower part on the QPUs meanwhile
+  //
+  double gpu_time = 0.0;
+  std::exception_ptr gpu_error;
+
+  if (gpu_end > 0) {
+    auto gpu_start = Clock::now();
+    try {
+      gpu(0, gpu_end);
+    } catch (...) {
+      gpu_error = std::current_exception();
+    }
+    gpu_time = seconds_since(gpu_start);
+  }
+
+  for (auto &thread : pool) {
+    thread.join();
+  }
+
+  if (gpu_error) std::rethrow_exception(gpu_error);
+  for (auto &err : errors) {
+    if (err) std::rethrow_exception(err);
+  }
+
+  double cpu_time = 0.0;
+  for (auto t : times) {
+    cpu_time = std::max(cpu_time, t);
+  }
+
+  calibrate(gpu_end, gpu_time, cpu_items, cpu_time);
+}
+
+
+/**
+ * Adjust the ratio so that both parts would have taken the same time.
+ *
+ * The new value is averaged with the previous one, to dampen the effect of outliers.
+ */
+void CoExecutor::calibrate(int gpu_items, double gpu_time, int cpu_items, double cpu_time) {
+  if (gpu_items == 0 || cpu_items == 0) return;
+  if (gpu_time <= 0.0 || cpu_time <= 0.0) return;
+
+  double gpu_rate = gpu_items/gpu_time;
+  double cpu_rate = cpu_items/cpu_time;
+  float ratio = (float) (gpu_rate/(gpu_rate + cpu_rate));
+
+  m_ratio = std::min(MAX_RATIO, std::max(MIN_RATIO, 0.5f*(m_ratio + ratio)));
+}
+
+}  // namespace V3DLib
@@ -0,0 +1,44 @@
+#ifndef _V3DLIB_SUPPORT_COEXECUTOR_H_
+#define _V3DLIB_SUPPORT_COEXECUTOR_H_
+#include <functional>
+
+namespace V3DLib {
+
+/**
+ * Split an index range between the QPUs and host threads
+ *
+ * The first part of the range is handled by the QPUs, the rest is divided
+ * over a number of host threads. Both run at the same time.
+ * The ratio between the parts is recalibrated after every run from the
+ * measured throughput, so that both parts take about the same time.
+ *
+ * Both parts should write into the same shared array, each in its own index range.
+ * The split points are multiples of the granularity; for a kernel this is typically
+ * 16*numQPUs, so that no QPU handles indexes beyond its part.
+ */
+class CoExecutor {
+public:
+  using Part = std::function<void(int begin, int end)>;
+
+  CoExecutor(int granularity = 16, int num_threads = -1);
+
+  void run(int size, Part gpu, Part cpu);
+
+  float gpu_ratio() const { return m_ratio; }
+  void gpu_ratio(float val);
+  int num_threads() const { return m_num_threads; }
+  int last_split() const { return m_last_split; }
+
+private:
+  int   m_granularity;
+  int   m_num_threads;
+  float m_ratio      = 0.5f;  // Part of the range handled by the QPUs
+  int   m_last_split = 0;
+
+  int split(int size) const;
+  void calibrate(int gpu_items, double gpu_time, int cpu_items, double cpu_time);
+};
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SUPPORT_COEXECUTOR_H_
@@ -0,0 +1,71 @@
+#include "interleave.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace V3DLib {
+
+/**
+ * Split `count` interleaved complex values into real and imaginary parts.
+ *
+ * @param src  `2*count` floats
+ */
+void deinterleave(float const *src, float *re, float *im, size_t count) {
+  size_t i = 0;
+
+#if defined(__ARM_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4x2_t v = vld2q_f32(src + 2*i);
+    vst1q_f32(re + i, v.val[0]);
+    vst1q_f32(im + i, v.val[1]);
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    __m128 a = _mm_loadu_ps(src + 2*i);      // re0 im0 re1 im1
+    __m128 b = _mm_loadu_ps(src + 2*i + 4);  // re2 im2 re3 im3
+    _mm_storeu_ps(re + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(im + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    re[i] = src[2*i];
+    im[i] = src[2*i + 1];
+  }
+}
+
+
+/**
+ * Combine real and imaginary parts into `count` interleaved complex values.
+ *
+ * @param dst  `2*count` floats
+ */
+void interleave(float const *re, float const *im, float *dst, size_t count) {
+  size_t i = 0;
+
+#if defined(__ARM_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4x2_t v;
+    v.val[0] = vld1q_f32(re + i);
+    v.val[1] = vld1q_f32(im + i);
+    vst2q_f32(dst + 2*i, v);
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    __m128 r = _mm_loadu_ps(re + i);
+    __m128 m = _mm_loadu_ps(im + i);
+    _mm_storeu_ps(dst + 2*i,     _mm_unpacklo_ps(r, m));
+    _mm_storeu_ps(dst + 2*i + 4, _mm_unpackhi_ps(r, m));
+  }
+#endif
+
+  for (; i < count; i++) {
+    dst[2*i]     = re[i];
+    dst[2*i + 1] = im[i];
+  }
+}
+
+}  // namespace V3DLib
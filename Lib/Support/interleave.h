@@ -0,0 +1,19 @@
+#ifndef _V3DLIB_SUPPORT_INTERLEAVE_H_
+#define _V3DLIB_SUPPORT_INTERLEAVE_H_
+#include <cstddef>
+
+namespace V3DLib {
+
+//
+// Bulk conversion between interleaved complex values (re, im, re, im, ...)
+// and separate arrays of real and imaginary parts.
+//
+// Uses NEON or SSE when the compiler supports it, with a scalar loop for the remainder.
+//
+
+void deinterleave(float const *src, float *re, float *im, size_t count);
+void interleave(float const *re, float const *im, float *dst, size_t count);
+
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_SUPPORT_INTERLEAVE_H_
@@ -1,4 +1,5 @@
 #include "EmuSupport.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstring>  // strlen()
@@ -12,7 +13,9 @@ namespace {
 // Bitwise rotate-right
 inline int32_t rotRight(int32_t x, int32_t n) {
   uint32_t ux = (uint32_t) x;
-  return (ux >> n) | (x << (32-n));
+  n &= 31;
+  if (n == 0) return x;
+  return (int32_t) ((ux >> n) | (ux << (32 - n)));
 }
 
 
@@ -30,6 +33,41 @@ inline int32_t clz(int32_t x) {
 }
 
 
+/**
+ * Perform a packed 8-bit operation
+ *
+ * The 4 bytes in the 32-bit values are handled as separate unsigned values.
+ * Results are saturated to the range 0..255.
+ * Multiplication treats the values as fractions of 255, as vc4 does (v8muld).
+ */
+int32_t v8op(ALUOp::Enum op, int32_t x, int32_t y) {
+  uint32_t ret = 0;
+
+  for (int n = 0; n < 4; n++) {
+    int a = (int) ((((uint32_t) x) >> (8*n)) & 0xff);
+    int b = (int) ((((uint32_t) y) >> (8*n)) & 0xff);
+    int d = 0;
+
+    switch (op) {
+      case ALUOp::A_V8ADDS:
+      case ALUOp::M_V8ADDS: d = std::min(a + b, 255); break;
+      case ALUOp::A_V8SUBS:
+      case ALUOp::M_V8SUBS: d = std::max(a - b, 0);   break;
+      case ALUOp::M_V8MUL:  d = (a*b + 127)/255;      break;
+      case ALUOp::M_V8MIN:  d = std::min(a, b);       break;
+      case ALUOp::M_V8MAX:  d = std::max(a, b);       break;
+      default:
+        assertq(false, "v8op(): not a packed 8-bit operation", true);
+        break;
+    }
+
+    ret |= ((uint32_t) d) << (8*n);
+  }
+
+  return (int32_t) ret;
+}
+
+
 /**
  * Rotate a vector
  */
@@ -247,10 +285,11 @@ bool Vec::apply(ALUOp const &op, Vec a, Vec b) {
     int &d = elems[i].intVal;
 
     switch (op.value()) {
-    case ALUOp::A_ADD:   d = x+y;            break;
-    case ALUOp::A_SUB:   d = x-y;            break;
+    // Wrap around on overflow, as the hardware does
+    case ALUOp::A_ADD:   d = (int32_t) ((uint32_t) x + (uint32_t) y); break;
+    case ALUOp::A_SUB:   d = (int32_t) ((uint32_t) x - (uint32_t) y); break;
     case ALUOp::A_ROR:   d = rotRight(x, y); break;
-    case ALUOp::A_SHL:   d = x<<y;           break;
+    case ALUOp::A_SHL:   d = (int32_t) ((uint32_t) x << y); break;
     case ALUOp::A_SHR:   d = (int32_t) (((uint32_t) x) >> y); break;
     case ALUOp::A_ASR:   d = x >> y; break;
     case ALUOp::A_MIN:   d = x<y?x:y;        break;
@@ -269,12 +308,7 @@ bool Vec::apply(ALUOp const &op, Vec a, Vec b) {
     case ALUOp::M_V8MIN:
     case ALUOp::M_V8MAX:
     case ALUOp::M_V8ADDS:
-    case ALUOp::M_V8SUBS: {
-      std::string buf;
-      buf << "V3DLib: unsupported operator " << op.value();
-      assertq(false, buf);
-    }
-    break;
+    case ALUOp::M_V8SUBS: d = v8op(op.value(), x, y); break;
 
     default:
       handled = false;
@@ -328,6 +362,30 @@ void Vec::assign(Vec const &rhs) {
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Class SemaphoreWaitLimit
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+int const DEFAULT_SEMAPHORE_WAIT = 1024;
+int max_semaphore_wait = DEFAULT_SEMAPHORE_WAIT;
+}  // anon namespace
+
+
+SemaphoreWaitLimit::SemaphoreWaitLimit(int limit) : m_prev(max_semaphore_wait) {
+  assert(limit > 0);
+  max_semaphore_wait = std::max(limit, m_prev);  // Nested instances can not lower the limit
+}
+
+
+SemaphoreWaitLimit::~SemaphoreWaitLimit() {
+  max_semaphore_wait = m_prev;
+}
+
+
+int SemaphoreWaitLimit::get() { return max_semaphore_wait; }
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Class EmuState
 ///////////////////////////////////////////////////////////////////////////////
@@ -372,7 +430,7 @@ bool EmuState::sema_inc(int sema_id) {
   assert(sema_id >= 0 && sema_id < 16);
   if (sema[sema_id] == 15) {
     semaphore_wait_count++;
-    assertq(semaphore_wait_count < MAX_SEMAPHORE_WAIT, "Semaphore wait for SINC appears to be stuck");
+    assertq(semaphore_wait_count < SemaphoreWaitLimit::get(), "Semaphore wait for SINC appears to be stuck");
     return true;
   } else {
     semaphore_wait_count = 0;
@@ -389,7 +447,7 @@ bool EmuState::sema_dec(int sema_id) {
   assert(sema_id >= 0 && sema_id < 16);
   if (sema[sema_id] == 0) {
     semaphore_wait_count++;
-    assertq(semaphore_wait_count < MAX_SEMAPHORE_WAIT, "Semaphore wait for SDEC appears to be stuck");
+    assertq(semaphore_wait_count < SemaphoreWaitLimit::get(), "Semaphore wait for SDEC appears to be stuck");
     return true;
   } else {
     semaphore_wait_count = 0;
@@ -75,6 +75,25 @@ private:
 };
 
 
+/**
+ * Limit on the number of consecutive semaphore waits in the emulator and interpreter.
+ *
+ * The count is reset as soon as any QPU makes progress, so that waiting for other QPUs
+ * doing long computations is fine. Exceeding the limit is taken as a deadlock.
+ * The limit can be raised for the lifetime of an instance of this class.
+ */
+class SemaphoreWaitLimit {
+public:
+  SemaphoreWaitLimit(int limit);
+  ~SemaphoreWaitLimit();
+
+  static int get();
+
+private:
+  int m_prev;
+};
+
+
 class EmuState {
 public:
   int num_qpus;
@@ -84,6 +103,7 @@ public:
   Vec get_uniform(int id, int &next_uniform);
   bool sema_inc(int sema_id);
   bool sema_dec(int sema_id);
+  void progress() { semaphore_wait_count = 0; }  // Called when a QPU does something besides waiting
 
   static Vec const index_vec;
 
@@ -91,8 +111,7 @@ private:
   IntList uniforms;        // Kernel parameters
   int sema[16];            // Semaphores
 
-  // Protection against locks due to semaphore waiting
-  int const MAX_SEMAPHORE_WAIT = 1024;
+  // Protection against locks due to semaphore waiting, see `SemaphoreWaitLimit`
   int semaphore_wait_count = 0;
 };
 
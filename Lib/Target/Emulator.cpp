@@ -77,7 +77,9 @@ private:
 
 // State of a single QPU.
 struct QPUState {
-  int id = 0;                          // QPU id
+  int id = 0;                          // QPU id, unique over all running kernels
+  int job = 0;                         // Index of kernel run by this QPU
+  int local_id = 0;                    // QPU id within the kernel
   int nextUniform = -2;                // Pointer to next uniform to read
   Seq<Vec> loadBuffer = 8;             // Load buffer for loads via TMU, 8 is initial size
 
@@ -136,8 +138,26 @@ struct QPUState {
 struct State : public EmuState {
   QPUState qpu[MAX_QPUS];  // State of each QPU
   Data emuHeap;
+  std::vector<EmuJob> &jobs;
 
-  State(int in_num_qpus, IntList const &in_uniforms) : EmuState(in_num_qpus, in_uniforms, true) {}
+  State(int in_num_qpus, std::vector<EmuJob> &in_jobs) : EmuState(in_num_qpus, IntList()), jobs(in_jobs) {}
+
+
+  /**
+   * Get the next uniform for the given QPU, from the parameters of its kernel.
+   *
+   * A final dummy uniform is added, see Note 1, function `invoke()` in `vc4/Invoke.cpp`.
+   */
+  Vec get_uniform(QPUState &s) {
+    EmuJob const &job = jobs[s.job];
+    int const next = s.nextUniform++;
+    assert(next <= job.uniforms->size());
+
+    if (next == -2) return Vec(s.local_id);
+    if (next == -1) return Vec(job.numQPUs);
+    if (next == job.uniforms->size()) return Vec(0);
+    return Vec((*job.uniforms)[next]);
+  }
 };
 
 
@@ -157,7 +177,7 @@ Vec DMA_readReg(QPUState* s, State* g, Reg reg, bool &handled) {
           // Horizontal load
           for (int i = 0; i < NUM_LANES; i++) {
             int index = (16*req->addr+i);
-            assert(index < VPM_SIZE);
+            assertq(index < VPM_SIZE, "VPM access out of range");
             v[i] = g->vpm[index];
           }
         } else {
@@ -166,7 +186,7 @@ Vec DMA_readReg(QPUState* s, State* g, Reg reg, bool &handled) {
             uint32_t x = req->addr & 0xf;
             uint32_t y = req->addr >> 4;
             int index = (y*16*16 + x + i*16);
-            assert(index < VPM_SIZE);
+            assertq(index < VPM_SIZE, "VPM access out of range");
             v[i] = g->vpm[index];
           }
         }
@@ -486,7 +506,7 @@ void writeReg(QPUState* s, State* g, bool setFlags, AssignCond cond, Reg dest, V
             // Horizontal store
             for (int i = 0; i < NUM_LANES; i++) {
               int index = (16*req->addr+i);
-              assert(index < VPM_SIZE);
+              assertq(index < VPM_SIZE, "VPM access out of range");
               g->vpm[index] = v[i];
             }
           } else {
@@ -495,7 +515,7 @@ void writeReg(QPUState* s, State* g, bool setFlags, AssignCond cond, Reg dest, V
             uint32_t y = req->addr >> 4;
             for (int i = 0; i < NUM_LANES; i++) {
               int index = (y*16*16 + x + i*16);
-              assert(index < VPM_SIZE);
+              assertq(index < VPM_SIZE, "VPM access out of range");
               g->vpm[index] = v[i];
             }
           }
@@ -588,21 +608,57 @@ Vec readRegOrImm(QPUState* s, State &state, RegOrImm const &src) {
  * @param heap
  */
 void emulate(int numQPUs, Instr::List &instrs, int maxReg, IntList &uniforms, BufferObject &heap) {
-  State state(numQPUs, uniforms);
+  std::vector<EmuJob> jobs(1);
+  jobs[0].numQPUs  = numQPUs;
+  jobs[0].instrs   = &instrs;
+  jobs[0].maxReg   = maxReg;
+  jobs[0].uniforms = &uniforms;
+
+  emulate(jobs, heap);
+}
+
+
+/**
+ * Run multiple kernels concurrently, each on its own subset of the QPUs.
+ *
+ * The QPUs are assigned to the kernels in order. `me()` and `numQPUs()` are
+ * relative to the kernel, the hardware QPU number is unique over all QPUs.
+ * On return, the field `steps` of each job is set.
+ */
+void emulate(std::vector<EmuJob> &jobs, BufferObject &heap) {
+  int numQPUs = 0;
+  for (auto const &job : jobs) {
+    assert(job.numQPUs > 0);
+    assert(job.instrs != nullptr && job.uniforms != nullptr);
+    numQPUs += job.numQPUs;
+  }
+  assertq(numQPUs <= MAX_QPUS, "emulate(): too many QPUs for the kernels to run", true);
+
+  State state(numQPUs, jobs);
   state.emuHeap.heap_view(heap);
 
   // Initialise state
-  for (int i = 0; i < numQPUs; i++) {
-    QPUState &q = state.qpu[i];
-    q.id                 = i;
-    q.init(maxReg);
+  int id = 0;
+  for (int j = 0; j < (int) jobs.size(); j++) {
+    jobs[j].steps = 0;
+
+    for (int i = 0; i < jobs[j].numQPUs; i++) {
+      QPUState &q = state.qpu[id];
+      q.id       = id;
+      q.job      = j;
+      q.local_id = i;
+      q.init(jobs[j].maxReg);
+      id++;
+    }
   }
 
+  int steps = 0;
   bool anyRunning = true;
 
   while (anyRunning) {
     auto ALWAYS = AssignCond::Tag::ALWAYS;
     anyRunning = false;
+    steps++;
 
     // Execute an instruction in each active QPU
     for (int i = 0; i < numQPUs; i++) {
@@ -610,6 +666,8 @@ void emulate(int numQPUs, Instr::List &instrs, int maxReg, IntList &uniforms, Bu
 
       if (s->running) {
         anyRunning = true;
+        jobs[s->job].steps = steps;
+        Instr::List &instrs = *jobs[s->job].instrs;
         assert(s->pc < instrs.size());
 
         s->upkeep();
@@ -619,6 +677,10 @@ void emulate(int numQPUs, Instr::List &instrs, int maxReg, IntList &uniforms, Bu
         //
         Instr const instr = instrs.get(s->pc++);
 
+        if (instr.tag != SINC && instr.tag != SDEC) {
+          state.progress();
+        }
+
         if (instr.break_point()) {
 #ifdef DEBUG
           printf("Emulator: hit breakpoint\n");
@@ -639,11 +701,17 @@ void emulate(int numQPUs, Instr::List &instrs, int maxReg, IntList &uniforms, Bu
             Vec b;
 
             if (instr.isUniformLoad()) {
-              a = state.get_uniform(s->id, s->nextUniform);
+              a = state.get_uniform(*s);
               b = a; 
             } else {
               a = readRegOrImm(s, state, instr.ALU.srcA);
-              b = readRegOrImm(s, state, instr.ALU.srcB);
+
+              // Same source is read only once, this matters for FIFOs like VPM_READ
+              if (instr.ALU.srcB == instr.ALU.srcA) {
+                b = a;
+              } else {
+                b = readRegOrImm(s, state, instr.ALU.srcB);
+              }
             }
 
             Vec result;
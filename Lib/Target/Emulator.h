@@ -1,12 +1,25 @@
 #ifndef _V3DLIB_TARGET_EMULATOR_H_
 #define _V3DLIB_TARGET_EMULATOR_H_
+#include <vector>
 #include "instr/Instr.h"
 
 namespace V3DLib {
 
 class BufferObject;
 
+/**
+ * Kernel to run on a subset of the QPUs
+ */
+struct EmuJob {
+  int numQPUs = 1;
+  Instr::List *instrs = nullptr;
+  int maxReg = 0;                    // Max reg id used
+  IntList const *uniforms = nullptr; // Kernel parameters
+  int steps = 0;                     // Output: number of steps till all QPUs of the kernel halted
+};
+
 void emulate(int numQPUs, Instr::List &instrs, int maxReg, IntList &uniforms, BufferObject &heap);
+void emulate(std::vector<EmuJob> &jobs, BufferObject &heap);
 
 }  // namespace V3DLib
 
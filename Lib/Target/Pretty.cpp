@@ -39,7 +39,11 @@ std::string pretty_instr(Instr const &instr) {
     case BR:   buf << "if " << instr.branch_cond().to_string()
                    << " goto " << instr.branch_target().to_string();
     break;
-    case BRL:  buf << "if " << instr.branch_cond().to_string() << " goto L" << instr.branch_label(); break;
+    case BRL:
+      buf << "if " << instr.branch_cond().to_string() << " goto L" << instr.branch_label();
+      if (instr.is_call())            buf << " (call, return L" << instr.return_label() << ")";
+      if (instr.is_subroutine_exit()) buf << " (return)";
+    break;
     case LAB:  buf << "L" << instr.label();                                                          break;
     case RECV: buf << "RECV(" <<  instr.dest().dump() << ")";                                        break;
     case SINC: buf << "SINC " << instr.semaId;                                                       break;
@@ -30,6 +30,8 @@ void removeLabels(Instructions &instrs) {
 
   // First, remove labels, remembering the index of the instruction
   // pointed to by each label.
+  // Comments on labels are transferred to the next instruction
+  std::string last_header;
   std::string last_comment;
   for (int i = 0, j = 0; i < (int) instrs.size(); i++) {
     auto &instr = instrs[i];
@@ -37,13 +39,27 @@ void removeLabels(Instructions &instrs) {
     if (instr.is_label()) {
       labels[instr.label()] = j;
 
+      if (last_header.empty()) {
+        last_header = instr.header();
+      }
+
       if (!last_comment.empty()) {
         last_comment << "; ";
       }
 
       last_comment << "Label L" << instr.label();
+
+      if (!instr.comment().empty()) {
+        last_comment << "; " << instr.comment();
+      }
     } else {
-      newInstrs << instr.comment(last_comment);
+      auto out = instr;
+      if (out.header().empty()) {
+        out.header(last_header);
+      }
+
+      newInstrs << out.comment(last_comment);
+      last_header.clear();
       last_comment.clear();
 
       j++;
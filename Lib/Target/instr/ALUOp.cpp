@@ -56,6 +56,10 @@ std::string ALUOp::pretty() const {
     case A_FFLOOR:  return "ffloor";
     case A_FSIN:    return "sin";
     case A_TMUWT:   return "tmuwt";
+    case A_BARRIERID: return "barrierid";
+    case A_VFPACK:  return "vfpack";
+    case A_FUNPACKL: return "funpackl";
+    case A_FUNPACKH: return "funpackh";
     default:
       assertq(false, "pretty(): Unknown ALU opcode", true);
       return "";
@@ -63,7 +63,11 @@ public:
     A_EIDX,
     A_FFLOOR,
     A_FSIN,
-    A_TMUWT
+    A_TMUWT,
+    A_BARRIERID,    // Wait for all QPUs of the workgroup
+    A_VFPACK,       // Pack two floats as fp16 into lower and upper 16 bits
+    A_FUNPACKL,     // fp16 in lower 16 bits to float
+    A_FUNPACKH      // fp16 in upper 16 bits to float
   };
 
   ALUOp() = default;
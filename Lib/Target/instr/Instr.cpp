@@ -258,6 +258,36 @@ BranchTarget Instr::branch_target() const { assert(tag == V3DLib::BR); return m_
 void  Instr::branch_label(Label rhs) { assert(tag == InstrTag::BRL); m_branch_label = rhs; }
 Label Instr::branch_label() const    { assert(tag == InstrTag::BRL); return m_branch_label; }
 
+
+/**
+ * Mark this branch as a subroutine call
+ *
+ * The return label is needed by the liveness analysis, to handle the call as a
+ * single instruction at the call site.
+ */
+Instr &Instr::call(Label return_label) {
+  assert(tag == InstrTag::BRL);
+  assert(return_label >= 0);
+  m_return_label = return_label;
+  return *this;
+}
+
+
+Label Instr::return_label() const {
+  assert(is_call());
+  return m_return_label;
+}
+
+
+/**
+ * Mark this branch as a return from a subroutine to a call site
+ */
+Instr &Instr::subroutine_exit() {
+  assert(tag == InstrTag::BRL);
+  m_subroutine_exit = true;
+  return *this;
+}
+
 Instr &Instr::branch_cond(BranchCond rhs) {
   assert(tag == V3DLib::BR || tag == V3DLib::BRL);
   m_branch_cond = rhs;
@@ -188,6 +188,13 @@ struct Instr : public InstructionComment {
   Label branch_label() const;
   void  branch_label(Label rhs);
   void label_to_target(int offset);
+
+  // Subroutine support
+  Instr &call(Label return_label);
+  bool  is_call() const { return is_branch_label() && m_return_label != -1; }
+  Label return_label() const;
+  Instr &subroutine_exit();
+  bool  is_subroutine_exit() const { return is_branch_label() && m_subroutine_exit; }
     
   void label(Label val) {
     assert(tag == InstrTag::LAB);
@@ -216,6 +223,8 @@ private:
   BranchTarget m_branch_target;
   Label        m_branch_label;      // Label to jump to in BRL instruction
   Label        m_label;             // Label denoting branch target
+  Label        m_return_label = -1; // Label to return to for a subroutine call in BRL instruction
+  bool         m_subroutine_exit = false;  // BRL instruction returns from subroutine to caller
 };
 
 
@@ -74,6 +74,10 @@ Reg const SFU_LOG(      SPECIAL, SPECIAL_SFU_LOG);
 Reg const TMUD(SPECIAL, SPECIAL_VPM_WRITE);
 Reg const TMUA(SPECIAL, SPECIAL_DMA_ST_ADDR);
 
+// v3d only
+Reg const TMUAU(       SPECIAL, SPECIAL_TMUAU);
+Reg const UNIFORM_ADDR(SPECIAL, SPECIAL_UNIFORM_ADDR);
+
 Reg rf(uint8_t index) {
   return Reg(REG_A, index);
 }
@@ -113,6 +117,15 @@ Instr shr(Reg dst, Reg srcA, int n) {
 }
 
 
+/**
+ * Generate vector rotation, element `i` moves to element `(i + n) % 16`.
+ */
+Instr rotate(Reg dst, Reg src, int n) {
+  assert(n >= 1 && n <= 15);
+  return genInstr(ALUOp::M_ROTATE, dst, src, n);
+}
+
+
 /**
  * Generate addition instruction.
  */
@@ -196,6 +209,14 @@ Instr tmuwt() {
   return genInstr(ALUOp::A_TMUWT, None, None, None);
 }
 
+
+/**
+ * v3d only
+ */
+Instr barrierid() {
+  return genInstr(ALUOp::A_BARRIERID, None, None, None);
+}
+
 }  // namespace instr
 }  // namespace Target
 }  // namespace V3DLib
@@ -36,6 +36,10 @@ extern Reg const SFU_LOG;
 extern Reg const TMUD;
 extern Reg const TMUA;
 
+// v3d only
+extern Reg const TMUAU;
+extern Reg const UNIFORM_ADDR;
+
 Reg rf(uint8_t index);
 
 Instr bor(Reg dst, RegOrImm const &srcA, RegOrImm const &srcB);
@@ -48,6 +52,7 @@ Instr add(Reg dst, Reg srcA, Reg srcB);
 Instr add(Reg dst, Reg srcA, int n);
 Instr sub(Reg dst, Reg srcA, int n);
 Instr shr(Reg dst, Reg srcA, int n);
+Instr rotate(Reg dst, Reg src, int n);
 Instr li(Reg dst, Imm const &src);
 Instr branch(Label label);
 Instr label(Label in_label);
@@ -64,6 +69,7 @@ Instr recv(Reg dst);
 
 // v3d only
 Instr tmuwt();
+Instr barrierid();
 
 }  // namespace instr
 }  // namespace Target
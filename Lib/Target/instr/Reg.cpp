@@ -25,6 +25,8 @@ char const *specialStr(RegId rid) {
     case SPECIAL_SFU_RECIPSQRT: return "SFU_RECIPSQRT";
     case SPECIAL_SFU_EXP:       return "SFU_EXP";
     case SPECIAL_SFU_LOG:       return "SFU_LOG";
+    case SPECIAL_TMUAU:         return "TMUAU";
+    case SPECIAL_UNIFORM_ADDR:  return "UNIFORM_ADDR";
   }
 
   // Unreachable
@@ -131,7 +133,8 @@ bool Reg::can_read(bool check) const {
   bool ret = true;
 
   if (tag == SPECIAL) {
-    if (regId == SPECIAL_VPM_WRITE || regId == SPECIAL_TMU0_S) {
+    if (regId == SPECIAL_VPM_WRITE || regId == SPECIAL_TMU0_S
+     || regId == SPECIAL_TMUAU     || regId == SPECIAL_UNIFORM_ADDR) {
       ret = false;
     }
   }
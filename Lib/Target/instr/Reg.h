@@ -50,7 +50,12 @@ enum Special {
   SPECIAL_SFU_RECIP,
   SPECIAL_SFU_RECIPSQRT,
   SPECIAL_SFU_EXP,
-  SPECIAL_SFU_LOG
+  SPECIAL_SFU_LOG,
+
+  // v3d only
+  // Write-only
+  SPECIAL_TMUAU,          // TMU address, with the TMU configuration taken from the uniform stream
+  SPECIAL_UNIFORM_ADDR    // Address of the uniform stream
 };
 
 
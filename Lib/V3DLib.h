@@ -2,10 +2,16 @@
 #define _V3DLIB_H_
 
 #include "Source/Float.h"
+#include "Source/Int8x4.h"
+#include "Source/Half.h"
+#include "Source/Atomic.h"
+#include "Source/Local.h"
 #include "Source/Cond.h"
 #include "Source/Lang.h"
 #include "Source/gather.h"
 #include "Source/Functions.h"
+#include "Source/MathLib.h"
+#include "Source/Random.h"
 #include "Kernel.h"
 
 #endif
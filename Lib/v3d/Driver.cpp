@@ -63,9 +63,24 @@ namespace v3d {
  * 2. Totally no clue what the workgroup if for and what it does.
  *    Can't find anything about it online, just what `py-videocore6` gives,
  *    which I plain took over.
+ *
+ * 3. `barrierid` only syncs the threads within a workgroup. With the default workgroup size,
+ *    every QPU has its own workgroup. If `single_workgroup` is set, all QPUs are put into
+ *    one workgroup, so that a barrier syncs them all. The workgroup size field has 8 bits,
+ *    so this only works for a single thread per QPU.
+ *
+ * 4. Param `thread` is the number of batches of 16 lanes to run; each batch runs as a hardware thread.
+ *    If `threading` is set, a QPU runs 4 threads, switching between them on thread switch signals.
+ *    The shader code needs to be compiled for this, see `Threading.cpp`.
+ *    As in Mesa, kernels compiled for 2 threads are run without this flag.
  */
-bool Driver::execute(Code &code, Data *uniforms, uint32_t thread) {
+bool Driver::execute(Code &code, Data *uniforms, uint32_t thread, bool single_workgroup, bool threading) {
+  uint32_t const CFG5_THREADING = 1;
+
   uint32_t code_phyaddr = code.getAddress();
+  if (threading) {
+    code_phyaddr |= CFG5_THREADING;
+  }
 
   // Technically, you are not required to pass in uniforms.
   // If there are none, set the address to zero.
@@ -76,6 +91,12 @@ bool Driver::execute(Code &code, Data *uniforms, uint32_t thread) {
   WorkGroup workgroup;
   uint32_t wgs_per_sg = 16;
 
+  if (single_workgroup) {
+    assertq(16*thread <= 0xff, "v3d execute: too many threads for a single workgroup", true);
+    workgroup  = WorkGroup(16*thread);
+    wgs_per_sg = 1;
+  }
+
   st_v3d_submit_csd st = {
     {
       workgroup.wg_x << 16,
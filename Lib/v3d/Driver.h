@@ -20,7 +20,8 @@ public:
     m_bo_handles.push_back(handle);
   }
 
-  bool execute(Code &code, Data *uniforms = nullptr, uint32_t thread = 1);
+  bool execute(Code &code, Data *uniforms = nullptr, uint32_t thread = 1, bool single_workgroup = false,
+               bool threading = false);
 
 private:
   BoHandles m_bo_handles;
@@ -0,0 +1,116 @@
+#include "Invoke.h"
+#include "Driver.h"
+#include "Common/BufferObject.h"
+#include "Source/Stmt.h"
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace v3d {
+
+#ifdef QPU_MODE
+
+namespace {
+
+// TMU configuration fields, see `v3d_packet_v41_pack.h` in mesa
+uint32_t const PER_PIXEL  = (1 << 7);
+uint32_t const TYPE_32BIT = 7;
+
+// TMU operations for writes
+uint32_t const TMU_OP_WRITE_ADD     = 0;
+uint32_t const TMU_OP_WRITE_XCHG    = 2;
+uint32_t const TMU_OP_WRITE_CMPXCHG = 3;
+uint32_t const TMU_OP_WRITE_SMIN    = 6;
+uint32_t const TMU_OP_WRITE_SMAX    = 7;
+
+// Same value as UMIN for writes; for reads, the operation clears the entire L1 cache
+uint32_t const TMU_OP_READ_FULL_L1_CLEAR = 4;
+
+
+/**
+ * TMU configuration for an atomic operation, as generated by mesa.
+ *
+ * The lookup is per pixel, so that all lanes take part.
+ * CMPXCHG writes two values per lane to TMUD; this needs the VEC2 type.
+ */
+uint32_t atomic_config(Stmt::Atomic::Op op) {
+  uint32_t const TYPE_VEC2 = 2;
+
+  uint32_t tmu_op = 0;
+  switch (op) {
+    case Stmt::Atomic::ADD:      tmu_op = TMU_OP_WRITE_ADD;     break;
+    case Stmt::Atomic::MIN:      tmu_op = TMU_OP_WRITE_SMIN;    break;
+    case Stmt::Atomic::MAX:      tmu_op = TMU_OP_WRITE_SMAX;    break;
+    case Stmt::Atomic::EXCHANGE: tmu_op = TMU_OP_WRITE_XCHG;    break;
+    case Stmt::Atomic::CMPXCHG:  tmu_op = TMU_OP_WRITE_CMPXCHG; break;
+  }
+
+  uint32_t type = (op == Stmt::Atomic::CMPXCHG)?TYPE_VEC2:TYPE_32BIT;
+  return 0xffffff00 | (tmu_op << 3) | PER_PIXEL | type;
+}
+
+
+/**
+ * TMU configuration for a read which clears the L1 cache of the slice
+ */
+uint32_t l1_clear_config() {
+  return 0xffffff00 | (TMU_OP_READ_FULL_L1_CLEAR << 3) | PER_PIXEL | TYPE_32BIT;
+}
+
+
+void load_uniforms(Data &unif, int numQPUs, Data const &devnull, Data const &done, IntList const &params) {
+  int offset = 0;
+
+  // Add the common uniforms
+  unif[offset++] = 0;                     // qpu number (id for current qpu) - 0 is for 1 QPU
+  unif[offset++] = numQPUs;               // num qpu's running for this job
+  unif[offset++] = devnull.getAddress();  // Memory location for values to be discarded
+
+  for (int j = 0; j < params.size(); j++) {
+    unif[offset++] = params[j];
+  }
+
+  // The last item is for the 'done' location;
+  unif[offset] = (uint32_t) done.getAddress();
+}
+
+}  // anon namespace
+
+#endif  // QPU_MODE
+
+
+/**
+ * Run given code on the v3d hardware
+ *
+ * This only needs the opcodes and the launch settings of a kernel,
+ * not the kernel driver which generated them.
+ *
+ * @param num_threads  number of hardware threads per QPU.
+ *                     For 8 QPUs, each thread is run as a separate QPU.
+ *                     A single QPU runs a single thread.
+ */
+void invoke(int numQPUs, int num_threads, Data &devnull, Code &codeMem, IntList &params, bool single_workgroup) {
+#ifndef QPU_MODE
+  assertq(false, "Cannot run v3d invoke(), QPU_MODE not enabled");
+#else
+  assert(!codeMem.empty());
+
+  Data unif(params.size() + 4);
+  Data done(1);
+  done[0] = 0;
+
+  for (int op = Stmt::Atomic::ADD; op <= Stmt::Atomic::CMPXCHG; op++) {
+    devnull[ATOMIC_CONFIG_OFFSET + op] = atomic_config((Stmt::Atomic::Op) op);
+  }
+  devnull[L1_CLEAR_CONFIG_OFFSET] = l1_clear_config();
+
+  int num_workers = (numQPUs == 1)?1:numQPUs*num_threads;
+  load_uniforms(unif, num_workers, devnull, done, params);
+
+  Driver drv;
+  drv.add_bo(getBufferObject().getHandle());
+  drv.execute(codeMem, &unif, num_workers, single_workgroup, num_threads == 4);
+#endif  // QPU_MODE
+}
+
+}  // namespace v3d
+}  // namespace V3DLib
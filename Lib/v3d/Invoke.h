@@ -0,0 +1,27 @@
+#ifndef _V3DLIB_V3D_INVOKE_H_
+#define _V3DLIB_V3D_INVOKE_H_
+#include "Common/Seq.h"
+#include "Common/SharedArray.h"
+
+namespace V3DLib {
+namespace v3d {
+
+//
+// Layout of the devnull buffer, in words.
+//
+// The first 16 words receive the values to be discarded. They are followed by the TMU
+// configurations of the atomic operations, indexed by `Stmt::Atomic::Op`, the TMU configuration
+// for clearing the L1 cache, and the local arrays.
+//
+int const ATOMIC_CONFIG_OFFSET   = 16;
+int const L1_CLEAR_CONFIG_OFFSET = 31;
+int const LOCAL_OFFSET           = 32;
+
+inline int devnull_size(int local_rows) { return LOCAL_OFFSET + 16*local_rows; }
+
+void invoke(int numQPUs, int num_threads, Data &devnull, Code &codeMem, IntList &params, bool single_workgroup);
+
+}  // namespace v3d
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_V3D_INVOKE_H_
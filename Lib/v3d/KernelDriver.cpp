@@ -1,14 +1,17 @@
 #include "KernelDriver.h"
 #include <iostream>
 #include <memory>
-#include "Driver.h"
+#include "Invoke.h"
 #include "Source/Translate.h"
+#include "Source/Local.h"
 #include "Target/SmallLiteral.h"  // decodeSmallLit()
 #include "Target/RemoveLabels.h"
+#include "Target/instr/Mnemonics.h"  // UNIFORM_ADDR
 #include "instr/Snippets.h"
 #include "Support/basics.h"
 #include "Support/Timer.h"
 #include "SourceTranslate.h"
+#include "Threading.h"
 #include "instr/Encode.h"
 #include "instr/Mnemonics.h"
 #include "instr/OpItems.h"
@@ -109,6 +112,26 @@ bool handle_special_index(V3DLib::Instr const &src_instr, Instructions &ret) {
     return true;
   }
 
+  if (src_instr.tag == ALU && src_instr.ALU.op == ALUOp::A_BARRIERID) {
+    // The wait happens on the next thread switch
+    ret << barrierid(syncb).thrsw()
+        << nop()
+        << nop();
+    return true;
+  }
+
+  if (src_instr.tag == ALU && src_instr.dest() == Target::instr::UNIFORM_ADDR) {
+    auto src = src_instr.ALU.srcA;
+    assertq(src.is_reg() && src.reg().tag == REG_A,
+      "The uniform stream address can only be set from the register file", true);
+
+    ret << unif_addr(RFAddress(to_waddr(src.reg())))
+        << nop()
+        << nop()
+        << nop();
+    return true;
+  }
+
   auto dst_reg = encodeDestReg(src_instr);
   assert(dst_reg);
 
@@ -152,6 +175,11 @@ bool translateOpcode(V3DLib::Instr const &src_instr, Instructions &ret) {
     assert(src_instr.ALU.oneOperand());
     ret << ffloor(*dst_reg, reg_a);
     break;
+  case ALUOp::A_FUNPACKL:
+  case ALUOp::A_FUNPACKH:
+    assertq(reg_a.is_reg(), "funpack: expecting register as source", true);
+    ret << funpack(*dst_reg, *encodeSrcReg(reg_a.reg()), src_instr.ALU.op == ALUOp::A_FUNPACKH);
+    break;
   case ALUOp::A_TMUWT:
     assert(src_instr.ALU.noOperands());
     ret << tmuwt();
@@ -728,16 +756,41 @@ bool checkUniformAtTop(V3DLib::Instr::List const &instrs) {
 #endif  // DEBUG
 
 
+/**
+ * Thread switch before a TMU load.
+ *
+ * The switch takes effect after two delay slots, so that the load
+ * itself runs when the thread continues.
+ */
+Instructions thread_switch() {
+  Instructions ret;
+
+  ret << nop().thrsw().comment("thread switch")
+      << nop()
+      << nop();
+
+  return ret;
+}
+
+
 /**
  * Translate instructions from target to v3d
+ *
+ * @param num_threads  number of hardware threads per QPU. If > 1, thread switches are
+ *                     inserted before TMU loads where possible.
  */
-void _encode(V3DLib::Instr::List const &instrs, Instructions &instructions) {
+void _encode(V3DLib::Instr::List const &instrs, Instructions &instructions, int num_threads) {
 #ifdef DEBUG
   assertq(checkUniformAtTop(instrs), "_encode(): checkUniformAtTop() failed (v3d)", true);
 #endif
   bool prev_was_init_begin = false;
   bool prev_was_init_end    = false;
 
+  std::vector<bool> switch_points;
+  if (num_threads > 1) {
+    switch_points = threading::switch_points(instrs);
+  }
+
   // Main loop
   for (int i = 0; i < instrs.size(); i++) {
     V3DLib::Instr instr = instrs[i];
@@ -750,7 +803,13 @@ void _encode(V3DLib::Instr::List const &instrs, Instructions &instructions) {
       instructions << encode_init();
       prev_was_init_end = true;
     } else {
-      Instructions ret = v3d::encodeInstr(instr);
+      Instructions ret;
+
+      if (!switch_points.empty() && switch_points[i]) {
+        ret << thread_switch();
+      }
+
+      ret << v3d::encodeInstr(instr);
 
       if (prev_was_init_begin) {
         ret.front().header("Init block");
@@ -1180,42 +1239,6 @@ void combine(Instructions &instructions) {
   }
 }
 
-
-void load_uniforms(Data &unif, int numQPUs, Data const &devnull, Data const &done, IntList const &params) {
-  int offset = 0;
-
-  // Add the common uniforms
-  unif[offset++] = 0;                     // qpu number (id for current qpu) - 0 is for 1 QPU
-  unif[offset++] = numQPUs;               // num qpu's running for this job
-  unif[offset++] = devnull.getAddress();  // Memory location for values to be discarded
-
-  for (int j = 0; j < params.size(); j++) {
-    unif[offset++] = params[j];
-  }
-
-  // The last item is for the 'done' location;
-  unif[offset] = (uint32_t) done.getAddress();
-}
-
-
-void invoke(int numQPUs, Data &devnull, Code &codeMem, IntList &params) {
-#ifndef QPU_MODE
-  assertq(false, "Cannot run v3d invoke(), QPU_MODE not enabled");
-#else
-  assert(!codeMem.empty());
-
-  Data unif(params.size() + 4);
-  Data done(1);
-  done[0] = 0;
-
-  load_uniforms(unif, numQPUs, devnull, done, params);
-
-  Driver drv;
-  drv.add_bo(getBufferObject().getHandle());
-  drv.execute(codeMem, &unif, numQPUs);
-#endif  // QPU_MODE
-}
-
 }  // anon namespace
 
 
@@ -1232,7 +1255,7 @@ void KernelDriver::encode() {
   assert(!qpuCodeMem.allocated());
 
   // Encode target instructions
-  _encode(m_targetCode, instructions);
+  _encode(m_targetCode, instructions, m_threads);
   combine(instructions);
   removeLabels(instructions);
 
@@ -1272,12 +1295,29 @@ std::vector<uint64_t> KernelDriver::to_opcodes() {
 void KernelDriver::compile_intern() {
   //Timer t1("compile_intern", true);
 
+  threading::reset();
   obtain_ast();
 
   //Timer t3("translate_stmt");
   translate_stmt(m_targetCode, m_body);  // performance hog 2 12/45s
   //t3.end();
 
+  m_local_rows   = local::rows_used();
+  m_uses_barrier = false;
+  for (int i = 0; i < m_targetCode.size(); i++) {
+    auto const &instr = m_targetCode[i];
+    if (instr.tag == ALU && instr.ALU.op == ALUOp::A_BARRIERID) {
+      m_uses_barrier = true;
+      break;
+    }
+  }
+
+  // With a barrier, all threads run in a single workgroup. The workgroup size is 8 bits,
+  // so it can only hold 16 lanes for every QPU.
+  if (m_uses_barrier && threading::num_threads() > 1) {
+    threading::num_threads(1);
+  }
+
   insertInitBlock(m_targetCode);
   add_init(m_targetCode);
 
@@ -1285,6 +1325,8 @@ void KernelDriver::compile_intern() {
   compile_postprocess(m_targetCode);  // performance hog 1 31/45s
   //t5.end();
 
+  m_threads = threading::num_threads();  // Can be lowered by register allocation
+
   encode();
 }
 
@@ -1320,10 +1362,20 @@ void KernelDriver::invoke_intern(int numQPUs, IntList &params) {
   assert(qpuCodeMem.allocated());
 
   if (!devnull.allocated()) {
-    devnull.alloc(16);
+    devnull.alloc(v3d::devnull_size(m_local_rows));  // Also holds the atomics configurations and local arrays
   }
 
-  v3d::invoke(numQPUs, devnull, qpuCodeMem, params);
+  v3d::invoke(numQPUs, m_threads, devnull, qpuCodeMem, params, m_uses_barrier);
+}
+
+
+void KernelDriver::to_blob(KernelBlob::Target &target) {
+  Parent::to_blob(target);
+
+  target.code         = to_opcodes();
+  target.num_threads  = m_threads;
+  target.local_rows   = m_local_rows;
+  target.uses_barrier = m_uses_barrier;
 }
 
 
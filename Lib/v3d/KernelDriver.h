@@ -29,12 +29,18 @@ public:
 
   void encode() override;
   int kernel_size() const { return (int) instructions.size(); }
+  int num_threads() const { return m_threads; }
+  Instructions const &instructions_v3d() const { return instructions; }
+  void to_blob(KernelBlob::Target &target) override;
 
 private:
   Instructions  instructions;
   BufferObject  code_bo;
   Code          qpuCodeMem;
   Data          devnull;
+  bool          m_uses_barrier = false;  // If true, run all QPUs in a single workgroup
+  int           m_local_rows   = 0;      // Number of vectors used by local arrays
+  int           m_threads      = 1;      // Number of hardware threads per QPU
 
   void compile_intern() override;
   void invoke_intern(int numQPUs, IntList &params) override;
@@ -9,6 +9,8 @@
 #include "vc4/DMA/DMA.h"
 #include "Target/instr/Mnemonics.h"
 #include "Common/CompileData.h"
+#include "Threading.h"
+#include "Invoke.h"  // ATOMIC_CONFIG_OFFSET, L1_CLEAR_CONFIG_OFFSET
 
 namespace V3DLib {
 
@@ -33,19 +35,113 @@ Instr::List SourceTranslate::store_var(Var dst_addr, Var src) {
 }
 
 
+namespace {
+
+/**
+ * Allocate a register to each variable
+ *
+ * @param num_regs  number of registers in the register file available for allocation
+ *
+ * @return -1 if all went well, otherwise index of first variable which could not be allocated
+ */
+int allocate_vars(RegUsage &reg_usage, LiveSets &liveWith, int numVars, int num_regs) {
+  for (int i = 0; i < numVars; i++) {
+    reg_usage[i].reg.tag = NONE;
+  }
+
+  for (int i = 0; i < numVars; i++) {
+    auto possible = liveWith.possible_registers(i, reg_usage);
+    possible.resize(num_regs);
+
+    reg_usage[i].reg.tag = REG_A;
+    RegId regId = LiveSets::choose_register(possible, false);
+    if (regId < 0) return i;
+
+    reg_usage[i].reg.regId = regId;
+  }
+
+  return -1;
+}
+
+
+/**
+ * Point the uniform stream to a TMU configuration in the devnull buffer, see `v3d/Invoke.h`.
+ *
+ * The configuration is taken from the uniform stream on the next write to TMUAU.
+ * This is allowed because all uniforms are loaded at the start of the kernel.
+ *
+ * @param offset  offset of the configuration in the devnull buffer, in words
+ */
+Instr::List set_tmu_config(int offset) {
+  using namespace V3DLib::Target::instr;
+
+  Var byte_offset = VarGen::fresh();
+  Var config      = VarGen::fresh();
+
+  Instr::List ret;
+  ret << li(byte_offset, 4*offset)
+      << add(config, rf(RSV_DEVNULL), byte_offset)
+      << mov(UNIFORM_ADDR, config);
+
+  return ret;
+}
+
+
+/**
+ * Atomic operation, using the TMU atomic write operations
+ *
+ * The operation is selected by the TMU configuration for the operation.
+ * For CMPXCHG, the value to compare with is written to TMUD before the new value.
+ */
+void atomic(Instr::List &seq, Stmt::Atomic const &a) {
+  using namespace V3DLib::Target::instr;
+
+  Var addr = putInVar(&seq, a.addr)->var();
+  Var val  = putInVar(&seq, a.val)->var();
+  Var cmp  = (a.op == Stmt::Atomic::CMPXCHG)?putInVar(&seq, a.cmp)->var():Var(DUMMY);
+
+  Instr::List config = set_tmu_config(ATOMIC_CONFIG_OFFSET + (int) a.op);
+  config.front().comment(Stmt::Atomic::name(a.op));
+  seq << config;
+
+  if (a.op == Stmt::Atomic::CMPXCHG) {
+    seq << mov(TMUD, cmp);
+  }
+
+  seq << mov(TMUD, val)
+      << mov(TMUAU, addr)
+      << recv(a.dst);
+}
+
+
+/**
+ * Clear the TMU L1 cache of the slice of the current QPU.
+ *
+ * The L1 cache is not updated by the stores of QPUs in other slices. This is a read
+ * with the TMU operation 'full L1 clear'; the value read is discarded.
+ */
+void clear_l1_cache(Instr::List &seq) {
+  using namespace V3DLib::Target::instr;
+
+  Instr::List config = set_tmu_config(L1_CLEAR_CONFIG_OFFSET);
+  config.front().comment("Clear TMU L1 cache");
+  seq << config
+      << mov(TMUAU, rf(RSV_DEVNULL))
+      << recv(VarGen::fresh());
+}
+
+}  // anon namespace
+
+
 void SourceTranslate::regAlloc(Instr::List &instrs) {
   //Timer t1("regAlloc", true);
   int numVars = VarGen::count();
 
+  // Step 0 - Perform liveness analysis, along with optimizations
   //Timer t2("regAlloc optimize");
-  Liveness::optimize(instrs, numVars);
-  //t2.end();
-
-  // Step 0 - Perform liveness analysis
-  //Timer t3("regAlloc compute");
   Liveness live(numVars);
-  live.compute(instrs);
-  //t3.end();
+  live.optimize(instrs);
+  //t2.end();
 
   // Step 2 - For each variable, determine all variables ever live at the same time
   //Timer t4("regAlloc liveWith");
@@ -56,23 +152,25 @@ void SourceTranslate::regAlloc(Instr::List &instrs) {
   //Timer t5("regAlloc Allocate reg to var");
 
   // Step 3 - Allocate a register to each variable
-  for (int i = 0; i < numVars; i++) {
-    if (live.reg_usage()[i].reg.tag != NONE) continue;
-
-    auto possible = liveWith.possible_registers(i, live.reg_usage());
-
-    live.reg_usage()[i].reg.tag = REG_A;
-    RegId regId = LiveSets::choose_register(possible, false);
+  //
+  // The register file is divided over the hardware threads.
+  // If the variables don't fit, retry with fewer threads.
+  int threads = threading::num_threads();
+  int failed_var = allocate_vars(live.reg_usage(), liveWith, numVars, threading::regfile_size(threads));
+
+  while (failed_var >= 0 && threads > 1) {
+    threads /= 2;
+    failed_var = allocate_vars(live.reg_usage(), liveWith, numVars, threading::regfile_size(threads));
+  }
 
-    if (regId < 0) {
-      std::string buf = "v3d regAlloc(): register allocation failed for target instruction ";
-      buf << i << ": " << instrs[i].mnemonic();
-      error(buf, true);
-    } else {
-      live.reg_usage()[i].reg.regId = regId;
-    }
+  if (failed_var >= 0) {
+    std::string buf = "v3d regAlloc(): register allocation failed for target instruction ";
+    buf << failed_var << ": " << instrs[failed_var].mnemonic();
+    error(buf, true);
   }
 
+  threading::num_threads(threads);
+
   //t5.end();
 
   compile_data.allocated_registers_dump = live.reg_usage().dump(true);
@@ -110,20 +208,22 @@ void add_init(Instr::List &code) {
   //
   // Broadly:
   //
-  // If (numQPUs() == 8)  // Alternative is 1, then qpu num initalized to 0 is ok
-  //   me() = (thread_index() >> 2) & 0b1111;
+  // If (numQPUs() != 1)  // Alternative is 1, then qpu num initalized to 0 is ok
+  //   me() = (thread_index() >> 2) & (numQPUs() - 1);
   // End
   //
   // This works because the thread indexes are consecutive for multiple reserved
   // threads. It's probably also the reason why you can select only 1 or 8 (max)
   // threads, otherwise there would be gaps in the qpu id.
   //
+  // With multiple hardware threads per QPU, numQPUs() is 8 times the number of threads.
+  //
   ret << mov(rf(RSV_QPU_ID), 0)           // not needed, already init'd to 0. Left here to counter future brainfarts
-      << sub(ACC0, rf(RSV_NUM_QPUS), 8).pushz()
+      << sub(ACC1, rf(RSV_NUM_QPUS), 1).pushz()
       << branch(endifLabel).allzc()       // nop()'s added downstream
       << mov(ACC0, QPU_ID)
       << shr(ACC0, ACC0, 2)
-      << band(rf(RSV_QPU_ID), ACC0, 15)
+      << band(rf(RSV_QPU_ID), ACC0, ACC1)
       << label(endifLabel)
 
       << add_uniform_pointer_offset(code);
@@ -136,11 +236,30 @@ void add_init(Instr::List &code) {
  * @return true if statement handled, false otherwise
  */
 bool SourceTranslate::stmt(Instr::List &seq, Stmt::Ptr s) {
+  using namespace V3DLib::Target::instr;
+
   if (DMA::Stmt::is_dma_tag(s->tag)) {
     fatal("VPM and DMA reads and writes can not be used for v3d");
     return true;
   }
 
+  if (s->tag == Stmt::ATOMIC) {
+    atomic(seq, *s->atomic());
+    return true;
+  }
+
+  if (s->tag == Stmt::BARRIER) {
+    // No TMU operations may be outstanding when blocking on the barrier.
+    // Not a header; this can be the first instruction, which gets the header of the program.
+    seq << tmuwt().comment("barrier")
+        << barrierid();
+
+    // Let the loads after the barrier see the stores of all QPUs before it.
+    // The preceding `tmuwt` ensures that the stores of this QPU are done.
+    clear_l1_cache(seq);
+    return true;
+  }
+
   return false;
 }
 
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// Support for multiple hardware threads per QPU on v3d
+//
+// With 2 or 4 threads, a QPU switches to another thread while waiting
+// for a TMU load. The price is that the register file is divided
+// over the threads, and that the accumulators and condition flags are
+// not preserved over a thread switch.
+//
+// Every thread runs as a separate QPU as far as the kernel is concerned,
+// i.e. `numQPUs()` is the number of QPUs times the number of threads.
+///////////////////////////////////////////////////////////////////////////////
+#include "Threading.h"
+#include <cstdint>
+#include "LibSettings.h"
+#include "Liveness/CFG.h"
+#include "Support/basics.h"
+#include "Support/Platform.h"
+
+namespace V3DLib {
+namespace v3d {
+namespace threading {
+namespace {
+
+int m_num_threads = 1;
+
+using Bits = uint8_t;   // bits 0-5: accumulators, bit 6: condition flags
+
+Bits const FLAGS = (1 << 6);
+Bits const ALL   = 0x7f;
+
+
+bool is_sfu_write(V3DLib::Instr const &instr) {
+  Reg dst = instr.dst_reg();
+  if (dst.tag != SPECIAL) return false;
+
+  return dst.regId == SPECIAL_SFU_RECIP || dst.regId == SPECIAL_SFU_RECIPSQRT
+      || dst.regId == SPECIAL_SFU_EXP   || dst.regId == SPECIAL_SFU_LOG;
+}
+
+
+/**
+ * Accumulators and flags read by given instruction
+ */
+Bits use(V3DLib::Instr const &instr) {
+  Bits ret = 0;
+
+  if (instr.has_registers()) {
+    for (auto const &r : instr.src_regs()) {
+      if (r.tag == ACC) ret |= (1 << r.regId);
+    }
+  }
+
+  if (!instr.is_always()) ret |= FLAGS;
+  if (instr.is_branch() && !instr.branch_cond().is_always()) ret |= FLAGS;
+
+  return ret;
+}
+
+
+/**
+ * Accumulators and flags overwritten by given instruction
+ *
+ * A conditional assignment does not overwrite the destination.
+ * SFU functions deliver their result in ACC4.
+ */
+Bits def(V3DLib::Instr const &instr) {
+  Bits ret = 0;
+  if (!instr.has_registers()) return ret;
+
+  if (instr.is_always()) {
+    Reg dst = instr.dst_reg();
+    if (dst.tag == ACC) ret |= (1 << dst.regId);
+  }
+
+  if (is_sfu_write(instr)) ret |= (1 << 4);
+  if (instr.tag != RECV && instr.set_cond().flags_set()) ret |= FLAGS;
+
+  return ret;
+}
+
+}  // anon namespace
+
+
+/**
+ * Needs to be called for every kernel compilation.
+ */
+void reset() {
+  m_num_threads = LibSettings::v3d_threads();
+}
+
+
+/**
+ * @return number of threads per QPU for the kernel being compiled
+ */
+int num_threads() {
+  return m_num_threads;
+}
+
+
+/**
+ * Set the number of threads actually used.
+ *
+ * This can be lower than the requested number if register allocation fails.
+ */
+void num_threads(int val) {
+  assert(val == 1 || val == 2 || val == 4);
+  m_num_threads = val;
+}
+
+
+/**
+ * @return number of registers in the register file per thread
+ */
+int regfile_size(int threads) {
+  return Platform::size_regfile()/threads;
+}
+
+
+/**
+ * Determine the TMU loads before which a thread switch can be placed.
+ *
+ * A thread switch is placed before the first of consecutive loads, so that
+ * the other threads can run while waiting for the results.
+ * This is only allowed if no accumulators or condition flags are live
+ * at that point. Accumulator and flag liveness is determined here from the
+ * allocated target code. Where it can't be determined, e.g. for subroutine calls,
+ * everything is assumed to be live.
+ *
+ * @return list of flags, true if a thread switch can be placed before the instruction
+ */
+std::vector<bool> switch_points(V3DLib::Instr::List const &instrs) {
+  int const size = instrs.size();
+  std::vector<bool> ret(size, false);
+
+  Instr::List &list = const_cast<Instr::List &>(instrs);  // CFG::build() does not take const
+  CFG cfg;
+  cfg.build(list);
+
+  std::vector<Bits> live_in(size, 0);
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+
+    for (int i = size - 1; i >= 0; i--) {
+      auto const &instr = instrs[i];
+      Bits out = 0;
+
+      if (instr.is_call() || instr.is_subroutine_exit()) {
+        out = ALL;
+      } else {
+        for (auto succ : cfg[i]) {
+          out |= live_in[succ];
+        }
+      }
+
+      Bits in = (Bits) ((out & ~def(instr)) | use(instr));
+
+      if (in != live_in[i]) {
+        live_in[i] = in;
+        changed = true;
+      }
+    }
+  }
+
+  for (int i = 0; i < size; i++) {
+    if (instrs[i].tag != RECV) continue;
+    if (i > 0 && instrs[i - 1].tag == RECV) continue;
+
+    ret[i] = (live_in[i] == 0);
+  }
+
+  return ret;
+}
+
+}  // namespace threading
+}  // namespace v3d
+}  // namespace V3DLib
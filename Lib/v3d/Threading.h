@@ -0,0 +1,20 @@
+#ifndef _V3DLIB_V3D_THREADING_H_
+#define _V3DLIB_V3D_THREADING_H_
+#include <vector>
+#include "Target/instr/Instr.h"
+
+namespace V3DLib {
+namespace v3d {
+namespace threading {
+
+void reset();
+int  num_threads();
+void num_threads(int val);
+int  regfile_size(int threads);
+std::vector<bool> switch_points(V3DLib::Instr::List const &instrs);
+
+}  // namespace threading
+}  // namespace v3d
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_V3D_THREADING_H_
@@ -170,6 +170,9 @@ std::unique_ptr<Location> encodeDestReg(V3DLib::Instr const &src_instr) {
         case SPECIAL_TMU0_S:              // Read TMU
           ret = loc_ptr(tmua);
           break;
+        case SPECIAL_TMUAU:               // Write TMU, with configuration from uniform stream
+          ret = loc_ptr(tmuau);
+          break;
 
         // SFU registers
         case SPECIAL_SFU_RECIP    : ret = loc_ptr(recip);     break;
@@ -194,6 +194,7 @@ Register const r4("r4", V3D_QPU_WADDR_R4, V3D_QPU_MUX_R4, true);
 Register const r5("r5", V3D_QPU_WADDR_R5, V3D_QPU_MUX_R5);
 Register const tmua("tmua", V3D_QPU_WADDR_TMUA);
 Register const tmud("tmud", V3D_QPU_WADDR_TMUD);
+Register const tmuau("tmuau", V3D_QPU_WADDR_TMUAU);
 Register const tlb("tlb", V3D_QPU_WADDR_TLB);
 Register const recip("recip", V3D_QPU_WADDR_RECIP);
 Register const rsqrt("rsqrt", V3D_QPU_WADDR_RSQRT);
@@ -302,6 +303,27 @@ Mnemonic ffloor(Location const &dst, Source const &srca) {
 }
 
 
+/**
+ * Convert the fp16 value in the lower or upper 16 bits of src to float.
+ *
+ * This is an fmov on the mul alu with input unpack set.
+ */
+Mnemonic funpack(Location const &dst, Location const &src, bool high) {
+  Mnemonic instr;
+
+  auto const *reg = dynamic_cast<Register const *>(&src);
+  if (reg != nullptr) {
+    instr.fmov(dst, high?reg->h():reg->l());
+    return instr;
+  }
+
+  auto const *rf_addr = dynamic_cast<RFAddress const *>(&src);
+  assertq(rf_addr != nullptr, "funpack(): unknown type of source location", true);
+  instr.fmov(dst, high?rf_addr->h():rf_addr->l());
+  return instr;
+}
+
+
 Mnemonic flpop(RFAddress rf_addr1, RFAddress rf_addr2) {
   Mnemonic instr;
 
@@ -639,6 +661,30 @@ Mnemonic bu(BranchDest const &loc1, Location const &loc2) {
 }
 
 
+/**
+ * Set the uniform stream address from a register file register.
+ *
+ * This is a branch to the instruction following the delay slots, so only the uniform
+ * stream address changes. The caller needs to add the 3 delay slots.
+ */
+Mnemonic unif_addr(Location const &reg) {
+  Mnemonic instr;
+  instr.type = V3D_QPU_INSTR_TYPE_BRANCH;
+
+  instr.branch.cond = V3D_QPU_BRANCH_COND_ALWAYS;
+  instr.branch.ub =  true;
+
+  instr.branch.bdi =  V3D_QPU_BRANCH_DEST_REL;
+  instr.branch.bdu =  V3D_QPU_BRANCH_DEST_REGFILE;
+
+  instr.branch.msfign = V3D_QPU_MSFIGN_NONE;
+  instr.branch.raddr_a = reg.to_waddr();
+  instr.branch.offset = 0;   // Relative to the instruction after the delay slots
+
+  return instr;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // SFU instructions - NOT WORKING, they return nothing
 //
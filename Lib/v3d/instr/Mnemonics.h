@@ -119,6 +119,7 @@ extern Register const r4;
 extern Register const r5;
 extern Register const tmua;
 extern Register const tmud;
+extern Register const tmuau;
 extern Register const tlb;
 extern Register const recip;
 extern Register const rsqrt;
@@ -195,6 +196,7 @@ Mnemonic barrierid(v3d_qpu_waddr waddr);
 Mnemonic vpmsetup(Register const &reg2);
 
 Mnemonic ffloor(Location const &dst, Source const &srca);
+Mnemonic funpack(Location const &dst, Location const &src, bool high);
 Mnemonic flpop(RFAddress rf_addr1, RFAddress rf_addr2);
 
 Mnemonic fdx(Location const &dst, Location const &srca);
@@ -220,6 +222,7 @@ Mnemonic bb(BranchDest const &loc1);
 Mnemonic bb(uint32_t addr);
 Mnemonic bu(uint32_t addr, Location const &loc2);
 Mnemonic bu(BranchDest const &loc1, Location const &loc2);
+Mnemonic unif_addr(Location const &reg);
 
 
 ///////////////////////////////////////////////////////////////////////////////
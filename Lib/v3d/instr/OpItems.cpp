@@ -46,12 +46,14 @@ std::vector<op_item> op_items = {
   { ALUOp::A_SUB,    V3D_QPU_A_SUB,   V3D_QPU_M_SUB },
   { ALUOp::A_SHR,    V3D_QPU_A_SHR    },
   { ALUOp::A_ASR,    V3D_QPU_A_ASR    },
+  { ALUOp::A_ROR,    V3D_QPU_A_ROR    },
   { ALUOp::A_SHL,    V3D_QPU_A_SHL    },
   { ALUOp::A_MIN,    V3D_QPU_A_MIN    },
   { ALUOp::A_MAX,    V3D_QPU_A_MAX    },
   { ALUOp::A_BAND,   V3D_QPU_A_AND    },
   { ALUOp::A_BOR,    V3D_QPU_A_OR     },
   { ALUOp::A_BXOR,   V3D_QPU_A_XOR    },
+  { ALUOp::A_BNOT,   V3D_QPU_A_NOT    },
   { ALUOp::M_FMUL,   false,           V3D_QPU_M_FMUL },
   { ALUOp::M_MUL24,  false,           V3D_QPU_M_SMUL24 },
   { ALUOp::M_ROTATE, false,           V3D_QPU_M_MOV },     // Special case: it's a mul alu mov with sig.rotate set
@@ -59,7 +61,8 @@ std::vector<op_item> op_items = {
   { ALUOp::A_EIDX,   V3D_QPU_A_EIDX   },
   { ALUOp::A_FFLOOR, V3D_QPU_A_FFLOOR },
   { ALUOp::A_FSIN,   V3D_QPU_A_SIN    },                   // NOTE: Extra NOP's and read in generation
-  { ALUOp::A_TMUWT,  V3D_QPU_A_TMUWT  }                    // NOTE: Extra NOP's and read in generation
+  { ALUOp::A_TMUWT,  V3D_QPU_A_TMUWT  },                   // NOTE: Extra NOP's and read in generation
+  { ALUOp::A_VFPACK, V3D_QPU_A_VFPACK }
 };
 
 
@@ -612,6 +612,47 @@ Instr::List storeRequest(Var dst_addr, Var src) {
 }
 
 
+/**
+ * Store every vector element to the address in its own lane.
+ *
+ * The vector is written to the VPM as with `storeRequest()`, after which every
+ * element is written to memory with a separate DMA store of a single word.
+ * The DMA store address is taken from the first lane only, so the address vector
+ * is rotated by one lane for every element.
+ */
+Instr::List scatterRequest(Var dst_addr, Var src) {
+  using namespace V3DLib::Target::instr;
+
+  Reg addr      = freshReg();
+  Reg storeAddr = freshReg();
+  Reg laneAddr  = freshReg();
+
+  Instr::List ret;
+
+  ret << li(addr, 16).comment("Start DMA scatter request")                     // Setup VPM
+      << add(addr, addr, QPU_ID)
+      << genSetupVPMStore(addr, 0, 1)
+      << genWaitDMAStore()                                                  // Wait for any previous store to complete
+      << shl(Target::instr::VPM_WRITE, src, 0)                                 // Put to VPM
+      << mov(laneAddr, dst_addr);
+
+  for (int i = 0; i < 16; i++) {
+    if (i > 0) {
+      ret << genWaitDMAStore()
+          << rotate(laneAddr, laneAddr, 15);                                  // Next lane to first lane
+    }
+
+    ret << li(storeAddr, 256 + 16*i)                                           // VPM row of element i
+        << add(storeAddr, storeAddr, QPU_ID)
+        << genSetupDMAStore(1, 1, 1, storeAddr)
+        << genStartDMAStore(laneAddr);
+  }
+
+  ret.back().comment("End DMA scatter request");
+  return ret;
+}
+
+
 /**
  * @return true if statement handled, false otherwise
  */
@@ -8,6 +8,7 @@ namespace DMA {
 
 Instr::List loadRequest(Var &dst, Expr &e);
 Instr::List storeRequest(Var dst_addr, Var src);
+Instr::List scatterRequest(Var dst_addr, Var src);
 bool translate_stmt(Instr::List &seq, int in_tag, Stmt &s);
 
 }  // namespace DMA
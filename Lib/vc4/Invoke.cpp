@@ -86,31 +86,47 @@ void init_launch_messages(Data &launch_messages, Code const &code, IntList const
 
 /**
  * Run the kernel on vc4 hardware
+ *
+ * Within a `LaunchSession`, the QPUs are already enabled and are left enabled.
+ *
+ * @return true if the launch succeeded, false otherwise
  */
-void invoke(int numQPUs, Data const &launch_messages) {
-#ifndef ARM32
-  error("invoke() will not run on this platform, only on ARM 32-bits");
-  error("Failed to invoke kernel on QPUs\n");
-  return;
-#else
-  enableQPUs();
+bool invoke(int numQPUs, Data const &launch_messages) {
+  if (!qpu_mailbox().available()) {
+    error("invoke() will not run on this platform, only on vc4 with ARM 32-bits");
+    error("Failed to invoke kernel on QPUs\n");
+    return false;
+  }
 
-  auto mb = getMailbox();
+  enableQPUs();
 
-  unsigned result = execute_qpu(
-    mb,
+  bool ok = qpu_mailbox().execute(
     numQPUs,
     launch_messages.getAddress(),
-    1,
-    LibSettings::qpu_timeout()*1000
+    (unsigned) (LibSettings::qpu_timeout()*1000)
   );
 
   disableQPUs();
 
-  if (result != 0) {
+  if (!ok) {
     error("Failed to invoke kernel on QPUs\n");
   }
-#endif
+
+  return ok;
+}
+
+
+/**
+ * Make sure the array is allocated with exactly the given size
+ */
+void realloc(Data &arr, int size) {
+  if (arr.allocated() && (int) arr.size() == size) return;
+
+  if (arr.allocated()) {
+    arr.dealloc();
+  }
+
+  arr.alloc((uint32_t) size);
 }
 
 }  // anon namespace
@@ -126,4 +142,50 @@ void MailBoxInvoke::invoke(int numQPUs, Code const &code, IntList const &params)
   V3DLib::invoke(numQPUs, launch_messages);
 }
 
+
+/**
+ * Run the given kernels in a single launch
+ *
+ * The QPUs are assigned to the kernels in order. QPU id and num QPUs
+ * in the uniforms are relative to the kernel.
+ */
+bool MailBoxCoInvoke::invoke(std::vector<MailBoxLaunch> const &launches) {
+  assert(!launches.empty());
+
+  int numQPUs      = 0;
+  int num_uniforms = 0;
+  for (auto const &l : launches) {
+    assertq(l.code != nullptr && !l.code->empty(), "MailBoxCoInvoke::invoke(): no code to invoke", true);
+    assert(l.params != nullptr);
+    numQPUs      += l.numQPUs;
+    num_uniforms += num_params(*l.params)*l.numQPUs;
+  }
+  assertq(numQPUs <= Platform::max_qpus(), "MailBoxCoInvoke::invoke(): more QPUs requested than available", true);
+
+  realloc(m_uniforms, num_uniforms);
+  realloc(launch_messages, 2*numQPUs);
+
+  int offset = 0;
+  int qpu    = 0;
+  for (auto const &l : launches) {
+    for (int i = 0; i < l.numQPUs; i++) {
+      launch_messages[2*qpu]     = m_uniforms.getAddress() + 4*offset;  // 4* for uint32_t offset
+      launch_messages[2*qpu + 1] = l.code->getAddress();
+      qpu++;
+
+      m_uniforms[offset++] = (uint32_t) i;            // QPU ID within kernel
+      m_uniforms[offset++] = (uint32_t) l.numQPUs;    // QPU count of kernel
+
+      for (int j = 0; j < l.params->size(); j++) {
+        m_uniforms[offset++] = (*l.params)[j];
+      }
+
+      m_uniforms[offset++] = 0;                       // Dummy final parameter, see Note 1.
+    }
+  }
+
+  assert(offset == num_uniforms);
+  return V3DLib::invoke(numQPUs, launch_messages);
+}
+
 }  // namespace V3DLib
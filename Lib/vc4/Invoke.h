@@ -1,6 +1,7 @@
 #ifndef _V3DLIB_VC4_INVOKE_H_
 #define _V3DLIB_VC4_INVOKE_H_
 #include <stdint.h>
+#include <vector>
 #include "Common/Seq.h"
 #include "Common/SharedArray.h"
 
@@ -34,6 +35,32 @@ private:
   Data launch_messages;
 };
 
+
+/**
+ * Kernel to run with `MailBoxCoInvoke`
+ */
+struct MailBoxLaunch {
+  Code const *code = nullptr;
+  IntList const *params = nullptr;
+  int numQPUs = 1;
+};
+
+
+/**
+ * Runs multiple kernels in a single launch, each on its own QPUs
+ *
+ * Every QPU gets its own entry in the launch messages, so the QPUs of
+ * different kernels can run different code with different uniforms.
+ */
+class MailBoxCoInvoke {
+public:
+  bool invoke(std::vector<MailBoxLaunch> const &launches);
+
+private:
+  Data m_uniforms;
+  Data launch_messages;
+};
+
 }  // namespace V3DLib
 
 #endif  // _V3DLIB_VC4_INVOKE_H_
@@ -3,12 +3,14 @@
 #include <sstream>
 #include "Source/Lang.h"
 #include "Source/Translate.h"
+#include "Source/Atomic.h"
 #include "Target/RemoveLabels.h"
 #include "vc4.h"
 #include "DMA/Operations.h"
 #include "dump_instr.h"
 #include "Target/instr/Mnemonics.h"
 #include "SourceTranslate.h"  // add_uniform_pointer_offset()
+#include "LoadPath.h"
 #include "Instr.h"
 
 namespace V3DLib {
@@ -73,6 +75,24 @@ CodeList encode_instructions(V3DLib::Instr::List &instrs) {
 }
 
 
+/**
+ * Insert statements directly after the uniform loads at the top of the kernel
+ */
+void insert_after_uniforms(Stmts &body, Stmts const &stmts) {
+  auto is_uniform_load = [] (Stmt::Ptr s) {
+    return s->tag == Stmt::ASSIGN
+        && s->assign_rhs()->tag() == Expr::VAR
+        && s->assign_rhs()->var().tag() == UNIFORM;
+  };
+
+  int index = 0;
+  while (index < (int) body.size() && is_uniform_load(body[index])) {
+    index++;
+  }
+
+  body.insert(body.begin() + index, stmts.begin(), stmts.end());
+}
+
 } // anon namespace
 
 KernelDriver::KernelDriver() : V3DLib::KernelDriver(Vc4Buffer) {}
@@ -99,6 +119,11 @@ void KernelDriver::kernelFinish() {
     For (Int i = 0, i < n, i++)
       semaDec(15);
     End
+
+    if (atomics::used()) {
+      atomics::release_mutex();
+    }
+
     hostIRQ();                  comment("Send host IRQ");
   Else
     semaInc(15);
@@ -129,6 +154,25 @@ void KernelDriver::encode() {
 }
 
 
+/**
+ * Get the encoded kernel, for launching it with other kernels
+ */
+Code const &KernelDriver::code() {
+  encode();
+  return qpuCodeMem;
+}
+
+
+void KernelDriver::to_blob(KernelBlob::Target &target) {
+  Parent::to_blob(target);
+  encode();
+
+  for (int i = 0; i < (int) qpuCodeMem.size(); i++) {
+    target.code.push_back(qpuCodeMem[i]);
+  }
+}
+
+
 void KernelDriver::emit_opcodes(FILE *f) {
   fprintf(f, "Opcodes for vc4\n");
   fprintf(f, "===============\n\n");
@@ -148,6 +192,11 @@ void KernelDriver::emit_opcodes(FILE *f) {
 void KernelDriver::compile_intern() {
   using Instr = V3DLib::Instr;
 
+  Stmts init;
+  if (atomics::used()) {
+    init = tempStmt([] { atomics::init_mutex(); });
+  }
+
   kernelFinish();
 
   // NOTE During debugging, I noticed that the sequence on the statement stack is duplicated here.
@@ -156,6 +205,11 @@ void KernelDriver::compile_intern() {
 
   obtain_ast();
 
+  load_path::plan(m_body);
+  Stmts load_init = load_path::init();
+  init.insert(init.end(), load_init.begin(), load_init.end());
+  insert_after_uniforms(m_body, init);
+
   V3DLib::translate_stmt(m_targetCode, m_body);
 
   {
@@ -15,7 +15,9 @@ public:
   KernelDriver(KernelDriver &&k) = default;
 
   void encode() override;
+  Code const &code();
   int kernel_size() const;
+  void to_blob(KernelBlob::Target &target) override;
 
 private:
   Code qpuCodeMem;     // Memory region for QPU code
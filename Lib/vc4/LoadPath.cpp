@@ -0,0 +1,639 @@
+///////////////////////////////////////////////////////////////////////////////
+// Selection of the load path per load site for vc4
+//
+// On vc4, vectors can be loaded from main memory via the TMU or via DMA to the VPM.
+// The TMU handles any address per lane, DMA loads 16 consecutive words starting
+// at the address in the first lane.
+//
+// Measurements show that the TMU is faster for single loads (see `Doc/FAQ.md`).
+// DMA can overlap a load with computation, however. For loads within a loop,
+// from a pointer which is stepped by a fixed amount per iteration, the block for the
+// next iteration is prefetched with DMA at the end of the loop body, if the loop continues.
+// The prefetch overlaps with the evaluation of the loop condition and the start of the next
+// iteration, up to the load site. There is a single VPM buffer per QPU; the block is read
+// from it before the next prefetch is issued.
+//
+// The selection depends on a flow-insensitive analysis of the kernel source, which
+// determines for every variable if it is uniform over the lanes, a contiguous
+// address, or anything else.
+//
+// The prefetched block is loaded before the next iteration of the loop. Stores
+// done in the meantime to that block are therefore not seen by the load.
+// Kernels which sync with other QPUs or use the VPM themselves are not pipelined.
+//
+// This is only done with `LibSettings::load_path()` set to `LOAD_AUTO`.
+//
+// Regardless of the setting, kernels which sync with other QPUs, e.g. with `barrier()`,
+// load contiguous vectors with DMA. The TMU cache is not updated by the DMA stores,
+// so TMU loads after a sync could miss the stores of the other QPUs.
+///////////////////////////////////////////////////////////////////////////////
+#include "LoadPath.h"
+#include <functional>
+#include <map>
+#include <set>
+#include "LibSettings.h"
+#include "Source/Lang.h"
+#include "Source/StmtStack.h"
+#include "Source/Translate.h"
+#include "DMA/Operations.h"
+#include "Support/basics.h"
+
+namespace V3DLib {
+namespace vc4 {
+namespace load_path {
+namespace {
+
+/**
+ * Classification of the lane values of a variable.
+ */
+enum Kind {
+  UNSET,       // Not assigned (yet)
+  SAME,        // Same value in all lanes
+  CONTIGUOUS,  // Address of 16 consecutive words: uniform base + 4*lane
+  VARYING      // Anything else
+};
+
+
+Kind join(Kind a, Kind b) {
+  if (a == UNSET) return b;
+  if (b == UNSET || a == b) return a;
+  return VARYING;
+}
+
+
+using Defs = std::map<VarId, Kind>;
+using VarSet = std::set<VarId>;
+
+Defs m_kinds;
+std::map<VarId, Expr::Ptr> m_single_defs;  // Vars assigned exactly once, with the assigned expr
+VarSet m_in_where;                          // Pointers dereferenced within `Where`
+bool m_coherent = false;                    // If true, contiguous loads need to see stores of other QPUs
+
+// Pipelined load, at most one pointer per kernel
+bool      m_pipelined = false;
+Var       m_ptr(DUMMY);         // Pointer which is loaded pipelined
+Expr::Ptr m_inc;                // Step of pointer per loop iteration
+Var       m_prefetched(DUMMY);  // Address of prefetched block, -1 if none
+Var       m_column(DUMMY);      // VPM column of the QPU
+Stmt const *m_loop = nullptr;   // Loop containing the load site
+bool      m_inc_first = false;  // True if the pointer is incremented before the load site in the loop
+
+
+using Visitor = std::function<void(Stmt const &s, bool in_where)>;
+
+/**
+ * Call visitor for all statements, including nested and lowered ones, in program order.
+ */
+void visit(Stmts const &stmts, Visitor const &f, bool in_where = false) {
+  for (auto const &ptr : stmts) {
+    Stmt const &s = *ptr;
+    f(s, in_where);
+
+    switch (s.tag) {
+      case Stmt::SEQ:
+      case Stmt::WHILE:
+        visit(s.body(), f, in_where);
+        break;
+      case Stmt::IF:
+        visit(s.then_block(), f, in_where);
+        visit(s.else_block(), f, in_where);
+        break;
+      case Stmt::WHERE:
+        visit(s.then_block(), f, true);
+        visit(s.else_block(), f, true);
+        break;
+      case Stmt::ATOMIC:
+        visit(s.atomic()->body, f, in_where);
+        break;
+      case Stmt::CALL:
+        visit(s.subroutine()->body, f, in_where);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+
+/**
+ * @return Var assigned to by given statement, DUMMY if none
+ */
+Var assigned_var(Stmt const &s) {
+  switch (s.tag) {
+    case Stmt::ASSIGN:
+      if (s.assign_lhs()->tag() == Expr::VAR) return s.assign_lhs()->var();
+      break;
+    case Stmt::LOAD_RECEIVE:
+      return const_cast<Stmt &>(s).address()->var();
+    case Stmt::ATOMIC:
+      return s.atomic()->dst;
+    case Stmt::LOCAL_ACCESS:
+      if (!s.local_access()->is_store) return s.local_access()->dst;
+      break;
+    default:
+      break;
+  }
+
+  return Var(DUMMY);
+}
+
+
+Kind kind(Var v) {
+  switch (v.tag()) {
+    case UNIFORM:
+      return v.is_uniform_ptr()?CONTIGUOUS:SAME;
+    case QPU_NUM:
+      return SAME;
+    case STANDARD: {
+      if (v.id() == RSV_QPU_ID || v.id() == RSV_NUM_QPUS) return SAME;
+      auto it = m_kinds.find(v.id());
+      return (it == m_kinds.end())?UNSET:it->second;
+    }
+    default:
+      return VARYING;
+  }
+}
+
+
+Kind kind(Expr::Ptr e) {
+  switch (e->tag()) {
+    case Expr::INT_LIT:
+    case Expr::FLOAT_LIT:
+      return SAME;
+    case Expr::VAR:
+      return kind(e->var());
+    case Expr::APPLY: {
+      Kind a = kind(e->lhs());
+      Kind b = kind(e->rhs());
+
+      if (a == VARYING || b == VARYING) return VARYING;
+      if (a == UNSET   || b == UNSET)   return UNSET;
+      if (a == SAME    && b == SAME)    return SAME;
+
+      OpId op = e->apply_op().op;
+      if (op == ADD && (a == SAME || b == SAME)) return CONTIGUOUS;
+      if (op == SUB && b == SAME) return CONTIGUOUS;
+      return VARYING;
+    }
+    default:
+      return VARYING;  // DEREF
+  }
+}
+
+
+/**
+ * Determine the kind of all variables in the kernel.
+ *
+ * Iterates until nothing changes; kinds only go up in the order UNSET, SAME/CONTIGUOUS, VARYING.
+ */
+void classify(Stmts const &body) {
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+
+    visit(body, [&changed] (Stmt const &s, bool in_where) {
+      Var v = assigned_var(s);
+      if (v.tag() != STANDARD) return;
+
+      Kind k = VARYING;
+      if (s.tag == Stmt::ASSIGN && !in_where) {
+        k = kind(s.assign_rhs());
+      }
+
+      Kind prev = kind(v);
+      Kind next = join(prev, k);
+      if (next != prev) {
+        m_kinds[v.id()] = next;
+        changed = true;
+      }
+    });
+  }
+}
+
+
+/**
+ * Collect the variables which are assigned only once in the kernel.
+ */
+void collect_single_defs(Stmts const &body) {
+  std::map<VarId, int> count;
+
+  visit(body, [&count] (Stmt const &s, bool in_where) {
+    Var v = assigned_var(s);
+    if (v.tag() != STANDARD) return;
+
+    if (s.tag == Stmt::ASSIGN && !in_where) {
+      m_single_defs[v.id()] = s.assign_rhs();
+      count[v.id()]++;
+    } else {
+      count[v.id()] += 2;  // Not a plain assignment, disqualify
+    }
+  });
+
+  for (auto const &it : count) {
+    if (it.second != 1) m_single_defs.erase(it.first);
+  }
+}
+
+
+/**
+ * Check if the kernel uses the VPM and DMA itself.
+ *
+ * Regular stores are not included, they use VPM rows 16-31.
+ * Atomics are included, they use the VPM on vc4.
+ */
+bool uses_vpm(Stmts const &body) {
+  bool ret = false;
+
+  visit(body, [&ret] (Stmt const &s, bool in_where) {
+    switch (s.tag) {
+      case Stmt::SET_READ_STRIDE:
+      case Stmt::SETUP_VPM_READ:
+      case Stmt::SETUP_DMA_READ:
+      case Stmt::DMA_START_READ:
+      case Stmt::SET_WRITE_STRIDE:
+      case Stmt::SETUP_VPM_WRITE:
+      case Stmt::SETUP_DMA_WRITE:
+      case Stmt::DMA_START_WRITE:
+      case Stmt::ATOMIC:
+        ret = true;
+        break;
+      default:
+        break;
+    }
+  });
+
+  return ret;
+}
+
+
+/**
+ * Check if the kernel syncs with other QPUs, e.g. with `barrier()`.
+ *
+ * Syncing QPUs implies that they read each other's stores.
+ * Semaphore 15 is skipped, it is used for the end of the kernel.
+ */
+bool uses_sync(Stmts const &body) {
+  bool ret = false;
+
+  visit(body, [&ret] (Stmt const &s, bool in_where) {
+    if ((s.tag == Stmt::SEMA_INC || s.tag == Stmt::SEMA_DEC) && s.dma.semaId() != 15) {
+      ret = true;
+    }
+  });
+
+  return ret;
+}
+
+
+void collect_derefs(Expr::Ptr e, VarSet &ptrs) {
+  switch (e->tag()) {
+    case Expr::APPLY:
+      collect_derefs(e->lhs(), ptrs);
+      collect_derefs(e->rhs(), ptrs);
+      break;
+    case Expr::DEREF:
+      if (e->deref_ptr()->tag() == Expr::VAR) ptrs.insert(e->deref_ptr()->var().id());
+      collect_derefs(e->deref_ptr(), ptrs);
+      break;
+    default:
+      break;
+  }
+}
+
+
+void collect_derefs(BExpr::Ptr b, VarSet &ptrs) {
+  switch (b->tag()) {
+    case NOT:
+      collect_derefs(b->neg(), ptrs);
+      break;
+    case AND:
+    case OR:
+      collect_derefs(b->lhs(), ptrs);
+      collect_derefs(b->rhs(), ptrs);
+      break;
+    case CMP:
+      collect_derefs(b->cmp_lhs(), ptrs);
+      collect_derefs(b->cmp_rhs(), ptrs);
+      break;
+  }
+}
+
+
+/**
+ * Collect the pointers which are dereferenced within `Where`-statements.
+ *
+ * Loads from these can not be pipelined, because the pipelined load sets the condition flags.
+ */
+VarSet derefs_in_where(Stmts const &body) {
+  VarSet ret;
+
+  visit(body, [&ret] (Stmt const &s, bool in_where) {
+    if (s.tag == Stmt::WHERE) {
+      collect_derefs(s.where_cond(), ret);
+    } else if (s.tag == Stmt::ASSIGN && in_where) {
+      collect_derefs(s.assign_lhs(), ret);
+      collect_derefs(s.assign_rhs(), ret);
+    }
+  });
+
+  return ret;
+}
+
+
+/**
+ * Create a copy of the step of a pointer, for usage at the load site.
+ *
+ * The step must have the same value at the load site as where the pointer is incremented.
+ * This is the case for literals, vars assigned once with a literal, and vars not assigned
+ * within the loop which are assigned before the loop.
+ *
+ * @return copy of the expression if usable, nullptr otherwise
+ */
+Expr::Ptr copy_step(Expr::Ptr e, VarSet const &in_loop, VarSet const &before_loop) {
+  switch (e->tag()) {
+    case Expr::INT_LIT:
+      return mkIntLit(e->intLit);
+
+    case Expr::VAR: {
+      Var v = e->var();
+      if (v.tag() != STANDARD) return nullptr;
+      if (v.id() == RSV_QPU_ID || v.id() == RSV_NUM_QPUS) return mkVar(v);
+
+      auto it = m_single_defs.find(v.id());
+      if (it != m_single_defs.end() && it->second->tag() == Expr::INT_LIT) {
+        return mkIntLit(it->second->intLit);
+      }
+
+      if (in_loop.count(v.id()) == 0 && before_loop.count(v.id()) != 0) return mkVar(v);
+      return nullptr;
+    }
+
+    case Expr::APPLY: {
+      auto lhs = copy_step(e->lhs(), in_loop, before_loop);
+      auto rhs = copy_step(e->rhs(), in_loop, before_loop);
+      if (lhs == nullptr || rhs == nullptr) return nullptr;
+      return mkApply(lhs, e->apply_op(), rhs);
+    }
+
+    default:
+      return nullptr;
+  }
+}
+
+
+/**
+ * Check if loads from given pointer in given loop can be pipelined.
+ *
+ * This is the case if the pointer is incremented exactly once in the loop,
+ * by a step which is the same over all lanes.
+ *
+ * @param site  statement with the load
+ */
+bool try_pipeline(Var ptr, Stmt const &loop, VarSet const &before_loop, Stmt const &site) {
+  VarSet in_loop;
+  Expr::Ptr step;
+  int num_defs = 0;
+  bool site_seen = false;
+  bool inc_first = false;
+
+  visit(loop.body(), [&] (Stmt const &s, bool in_where) {
+    if (&s == &site) site_seen = true;
+
+    Var v = assigned_var(s);
+    if (v.tag() != STANDARD) return;
+    in_loop.insert(v.id());
+
+    if (v.id() != ptr.id()) return;
+    num_defs++;
+    inc_first = !site_seen;
+
+    if (s.tag != Stmt::ASSIGN || in_where) return;
+    auto rhs = s.assign_rhs();
+    if (rhs->tag() != Expr::APPLY || rhs->apply_op().op != ADD) return;
+
+    auto is_ptr = [&ptr] (Expr::Ptr e) {
+      return e->tag() == Expr::VAR && e->var().tag() == STANDARD && e->var().id() == ptr.id();
+    };
+
+    if (is_ptr(rhs->lhs())) {
+      step = rhs->rhs();
+    } else if (is_ptr(rhs->rhs())) {
+      step = rhs->lhs();
+    }
+  });
+
+  if (num_defs != 1 || step == nullptr || kind(step) != SAME) return false;
+
+  m_inc = copy_step(step, in_loop, before_loop);
+  if (m_inc == nullptr) return false;
+
+  m_pipelined  = true;
+  m_ptr        = ptr;
+  m_loop       = &loop;
+  m_inc_first  = inc_first;
+  m_prefetched = VarGen::fresh();
+  m_column     = VarGen::fresh();
+  return true;
+}
+
+
+/**
+ * Find the first load site which can be pipelined.
+ *
+ * Only sites directly within a loop are considered, not within nested loops.
+ */
+void find_pipelined(Stmts const &stmts, Stmt const *loop, VarSet &assigned, VarSet const &before_loop) {
+  for (auto const &ptr : stmts) {
+    if (m_pipelined) return;
+    Stmt const &s = *ptr;
+
+    switch (s.tag) {
+      case Stmt::ASSIGN: {
+        auto rhs = s.assign_rhs();
+        if (loop != nullptr && rhs->tag() == Expr::DEREF && rhs->deref_ptr()->tag() == Expr::VAR) {
+          Var p = rhs->deref_ptr()->var();
+          if (kind(p) == CONTIGUOUS && m_in_where.count(p.id()) == 0 && try_pipeline(p, *loop, before_loop, s)) {
+            return;
+          }
+        }
+      }
+      break;
+
+      case Stmt::SEQ:
+        find_pipelined(s.body(), loop, assigned, before_loop);
+        break;
+
+      case Stmt::IF:
+        find_pipelined(s.then_block(), loop, assigned, before_loop);
+        find_pipelined(s.else_block(), loop, assigned, before_loop);
+        break;
+
+      case Stmt::WHILE: {
+        VarSet before = assigned;
+        find_pipelined(s.body(), &s, assigned, before);
+      }
+      break;
+
+      default:
+        break;
+    }
+
+    Var v = assigned_var(s);
+    if (v.tag() == STANDARD) assigned.insert(v.id());
+  }
+}
+
+
+/**
+ * Start a DMA load of a block into the VPM buffer of the current QPU.
+ *
+ * The buffer is the column of the QPU in VPM rows 0-15.
+ */
+void start_load(IntExpr addr) {
+  dmaSetReadPitch(4);
+  dmaSetupRead(HORIZ, 16, IntExpr(mkVar(m_column)), 1, 1);
+  dmaStartReadExpr(addr.expr());
+}
+
+
+void assign(Var dst, IntExpr e) {
+  stmtStack() << Stmt::create_assign(mkVar(dst), e.expr());
+}
+
+}  // anon namespace
+
+
+/**
+ * Analyze the kernel and select the pipelined load site, if any.
+ *
+ * Needs to be called for every kernel compilation.
+ */
+void plan(Stmts const &body) {
+  m_kinds.clear();
+  m_single_defs.clear();
+  m_in_where.clear();
+  m_coherent  = false;
+  m_pipelined = false;
+  m_loop      = nullptr;
+  m_inc.reset();
+
+  classify(body);
+
+  bool vpm  = uses_vpm(body);
+  bool sync = uses_sync(body);
+  m_coherent = sync && !vpm;  // With own VPM usage, the kernel takes care of this itself
+
+  if (LibSettings::load_path() != LibSettings::LOAD_AUTO) return;
+  if (vpm || sync) return;
+
+  collect_single_defs(body);
+  m_in_where = derefs_in_where(body);
+
+  VarSet assigned;
+  find_pipelined(body, nullptr, assigned, assigned);
+}
+
+
+/**
+ * @return statements to initialize the pipelined load, to be placed at the start of the kernel
+ */
+Stmts init() {
+  if (!m_pipelined) return Stmts();
+
+  return tempStmt([] {
+    assign(m_prefetched, -1);  comment("Init pipelined DMA load");
+
+    // Hardware QPU number rather than `me()`, which is not unique with co-scheduled kernels
+    assign(m_column, IntExpr(mkVar(Var(QPU_NUM))));
+  });
+}
+
+
+/**
+ * Select the path for loading a vector from the pointer in given expression.
+ *
+ * Pointers which are not contiguous always use the TMU, DMA can not load them.
+ * Pointers created during translation are not classified; they use the legacy
+ * selection from `LibSettings::use_tmu_for_load()`.
+ * In kernels which sync with other QPUs, contiguous pointers always use DMA.
+ */
+Path select(Expr &e) {
+  assert(e.tag() == Expr::DEREF && e.deref_ptr()->tag() == Expr::VAR);
+  Var ptr = e.deref_ptr()->var();
+
+  if (m_pipelined && ptr.tag() == STANDARD && ptr.id() == m_ptr.id()) {
+    return PIPELINED;
+  }
+
+  Kind k = kind(ptr);
+  if (m_coherent && k == CONTIGUOUS) return DMA;
+
+  switch (LibSettings::load_path()) {
+    case LibSettings::LOAD_DMA:
+      return (k == CONTIGUOUS || k == UNSET)?DMA:TMU;
+    case LibSettings::LOAD_AUTO:
+    case LibSettings::LOAD_TMU:
+    default:
+      return TMU;
+  }
+}
+
+
+/**
+ * Load a vector from the prefetched block.
+ *
+ * If the prefetched block is not the one requested, it is loaded here.
+ * Since the QPU can only have one DMA load in progress, other loads in the kernel use the TMU.
+ */
+Instr::List pipelined_load(Var &dst, Expr &e) {
+  assert(m_pipelined);
+
+  Stmts code = tempStmt([&dst] {
+    IntExpr ptr(mkVar(m_ptr));
+    IntExpr prefetched(mkVar(m_prefetched));
+
+    dmaWaitRead();  comment("Start pipelined DMA load");
+    If (any(prefetched != ptr))
+      start_load(ptr);
+      dmaWaitRead();
+    End
+
+    vpmSetupRead(VERT, 1, IntExpr(mkVar(m_column)));
+    assign(dst, vpmGetInt());  comment("End pipelined DMA load");
+  });
+
+  return translate_block(code);
+}
+
+
+/**
+ * Prefetch the block for the next iteration, at the end of the body of the loop with the load site.
+ *
+ * The prefetch is skipped on the final iteration, so that there is no read past the data.
+ * The loop condition is evaluated here for this, in addition to the regular evaluation.
+ */
+Instr::List loop_end(Stmt const &loop) {
+  if (!m_pipelined || &loop != m_loop) return Instr::List();
+
+  Stmts code = tempStmt([&loop] {
+    IntExpr ptr(mkVar(m_ptr));
+    IntExpr prefetched(mkVar(m_prefetched));
+
+    dmaWaitRead();  comment("Start pipelined DMA prefetch");
+    If (Cond(loop.loop_cond()))
+      if (m_inc_first) {
+        assign(m_prefetched, ptr + IntExpr(m_inc));
+      } else {
+        assign(m_prefetched, ptr);
+      }
+      start_load(prefetched);
+    End
+  });
+
+  return translate_block(code);
+}
+
+}  // namespace load_path
+}  // namespace vc4
+}  // namespace V3DLib
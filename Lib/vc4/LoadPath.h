@@ -0,0 +1,26 @@
+#ifndef _V3DLIB_VC4_LOADPATH_H_
+#define _V3DLIB_VC4_LOADPATH_H_
+#include "Source/Stmt.h"
+#include "Target/instr/Instr.h"
+
+namespace V3DLib {
+namespace vc4 {
+namespace load_path {
+
+enum Path {
+  TMU,
+  DMA,
+  PIPELINED   // DMA, with a prefetch of the next block
+};
+
+void plan(Stmts const &body);
+Stmts init();
+Path select(Expr &e);
+Instr::List pipelined_load(Var &dst, Expr &e);
+Instr::List loop_end(Stmt const &loop);
+
+}  // namespace load_path
+}  // namespace vc4
+}  // namespace V3DLib
+
+#endif  // _V3DLIB_VC4_LOADPATH_H_
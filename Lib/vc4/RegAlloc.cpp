@@ -152,16 +152,11 @@ void regAlloc(Instr::List &instrs) {
 
   int numVars = VarGen::count();
 
-//{
-//  Timer t("vc4 regAlloc optimize", true);
-  Liveness::optimize(instrs, numVars);
-//}
-
-  // Step 0 - Perform liveness analysis
+  // Step 0 - Perform liveness analysis, along with optimizations
   Liveness live(numVars);
 //{
-//  Timer t("vc4 regAlloc compute", true);
-  live.compute(instrs);
+//  Timer t("vc4 regAlloc optimize", true);
+  live.optimize(instrs);
 //}
 
 
@@ -4,20 +4,17 @@
 #include "Target/Subst.h"
 #include "DMA/LoadStore.h"
 #include "RegAlloc.h"
-#include "LibSettings.h"
+#include "LoadPath.h"
 
 namespace V3DLib {
 namespace vc4 {
 
 Instr::List SourceTranslate::load_var(Var &in_dst, Expr &e) {
-  using namespace Target::instr;
-
-  if (LibSettings::use_tmu_for_load()) {
-    //warning("Using TMU for var load");
-    return Parent::load_var(in_dst, e);
-  } else {
-    //warning("Using DMA for var load");
-    return DMA::loadRequest(in_dst, e);
+  switch (load_path::select(e)) {
+    case load_path::DMA:       return DMA::loadRequest(in_dst, e);
+    case load_path::PIPELINED: return load_path::pipelined_load(in_dst, e);
+    case load_path::TMU:
+    default:                   return Parent::load_var(in_dst, e);
   }
 }
 
@@ -27,6 +24,16 @@ Instr::List SourceTranslate::store_var(Var dst_addr, Var src) {
 }
 
 
+Instr::List SourceTranslate::scatter_var(Var dst_addr, Var src) {
+  return DMA::scatterRequest(dst_addr, src);
+}
+
+
+Instr::List SourceTranslate::loop_end(Stmt const &loop) {
+  return load_path::loop_end(loop);
+}
+
+
 void SourceTranslate::regAlloc(Instr::List &instrs) {
   vc4::regAlloc(instrs);
 }
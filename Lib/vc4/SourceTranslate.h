@@ -12,6 +12,8 @@ class SourceTranslate : public ISourceTranslate {
 public:
   Instr::List load_var(Var &dst, Expr &e) override;
   Instr::List store_var(Var dst_addr, Var src) override;
+  Instr::List scatter_var(Var dst_addr, Var src) override;
+  Instr::List loop_end(Stmt const &loop) override;
   void regAlloc(Instr::List &instrs) override;
   bool stmt(Instr::List &seq, Stmt::Ptr s) override; 
 };
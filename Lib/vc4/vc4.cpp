@@ -2,8 +2,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "vc4.h"
+#include "defines.h"
 #include "Mailbox.h"
 #include "Support/basics.h"  // fatal()
+#include "Support/Platform.h"
 #include "../Support/debug.h"
 
 namespace V3DLib {
@@ -11,10 +13,80 @@ namespace {
 
 int mailbox     = -1;
 int numQPUUsers = 0;
+int numSessions = 0;
+
+
+/**
+ * Runs the QPUs through the mailbox device
+ */
+class DeviceMailbox : public QPUMailbox {
+public:
+  /**
+   * The mailbox device is only present on a Pi with vc4, running ARM 32-bits
+   */
+  bool available() override {
+#ifndef ARM32
+    return false;
+#else
+    return Platform::has_vc4();
+#endif
+  }
+
+
+  bool enable(bool on) override {
+    return !qpu_enable(getMailbox(), on?1:0);
+  }
+
+
+  bool execute(int numQPUs, uint32_t launch_messages, unsigned timeout_ms) override {
+#ifndef ARM32
+    error("invoke() will not run on this platform, only on ARM 32-bits");
+    return false;
+#else
+    unsigned result = execute_qpu(getMailbox(), (unsigned) numQPUs, launch_messages, 1, timeout_ms);
+    return (result == 0);
+#endif
+  }
+};
+
+
+DeviceMailbox device_mailbox;
+QPUMailbox *current_mailbox = &device_mailbox;
 
 }  // anon namespace
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Class LaunchSession
+///////////////////////////////////////////////////////////////////////////////
+
+LaunchSession::LaunchSession() {
+  if (!qpu_mailbox().available()) return;
+
+  enableQPUs();
+  numSessions++;
+  m_enabled = true;
+}
+
+
+LaunchSession::~LaunchSession() {
+  if (!m_enabled) return;
+
+  assert(numSessions > 0);
+  numSessions--;
+  disableQPUs();
+}
+
+
+bool LaunchSession::active() {
+  return (numSessions > 0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Operations
+///////////////////////////////////////////////////////////////////////////////
+
 /**
  * Get mailbox id, opening it if not already open.
  */
@@ -24,15 +96,29 @@ int getMailbox() {
 }
 
 
+QPUMailbox &qpu_mailbox() {
+  return *current_mailbox;
+}
+
+
+/**
+ * Replace the mailbox calls for running the QPUs
+ *
+ * @param mailbox  stand-in to use, nullptr to use the mailbox device again.
+ *                 Caller keeps ownership.
+ */
+void set_qpu_mailbox(QPUMailbox *mailbox) {
+  assertq(numQPUUsers == 0, "set_qpu_mailbox(): QPUs are still enabled", true);
+  current_mailbox = (mailbox == nullptr)?&device_mailbox:mailbox;
+}
+
+
 /**
  * Enable QPUs if not already enabled.
  */
 void enableQPUs() {
-  int mb = getMailbox();
-
   if (numQPUUsers == 0) {
-    int qpu_enabled = !qpu_enable(mb, 1);
-    if (!qpu_enabled) {
+    if (!qpu_mailbox().enable(true)) {
       fatal("Unable to enable QPUs. Check your firmware is latest.");
     }
   }
@@ -45,11 +131,10 @@ void enableQPUs() {
  */
 void disableQPUs() {
   assert(numQPUUsers > 0);
-  int mb = getMailbox();
 
   numQPUUsers--;
   if (numQPUUsers == 0) {
-    qpu_enable(mb, 0);
+    qpu_mailbox().enable(false);
   }
 }
 
@@ -1,14 +1,58 @@
 #ifndef _V3DLIB_VC4_VC4_H_
 #define _V3DLIB_VC4_VC4_H_
+#include <stdint.h>
 
 namespace V3DLib {
 
-// Globals
-//extern int mailbox;
-//extern int numQPUUsers;
+/**
+ * Interface for the mailbox calls which run kernels on the vc4 QPUs
+ *
+ * The default implementation uses the mailbox device.
+ * A stand-in can be set with `set_qpu_mailbox()`, for testing the launch logic
+ * without vc4 hardware.
+ */
+class QPUMailbox {
+public:
+  virtual ~QPUMailbox() {}
+
+  virtual bool available() { return true; }
+  virtual bool enable(bool on) = 0;
+  virtual bool execute(int numQPUs, uint32_t launch_messages, unsigned timeout_ms) = 0;
+};
+
+
+/**
+ * Keeps the QPUs enabled for the lifetime of the instance
+ *
+ * Normally, every kernel call on vc4 enables the QPUs before the launch and disables
+ * them afterwards. Within a session, this is done only once:
+ *
+ *    {
+ *      LaunchSession session;
+ *      for (...) {
+ *        k.load(...).call();  // No power toggling
+ *      }
+ *    }                        // QPUs disabled here
+ *
+ * Sessions can be nested. Has no effect on v3d, or on platforms which can not run vc4 kernels.
+ */
+class LaunchSession {
+public:
+  LaunchSession();
+  LaunchSession(LaunchSession const &) = delete;
+  ~LaunchSession();
+
+  static bool active();
+
+private:
+  bool m_enabled = false;
+};
+
 
 // Operations
 int getMailbox();
+QPUMailbox &qpu_mailbox();
+void set_qpu_mailbox(QPUMailbox *mailbox);
 void enableQPUs();
 void disableQPUs();
 
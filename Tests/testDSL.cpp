@@ -1,12 +1,18 @@
 #include <iostream>
+#include <cmath>
 #include <string>
 #include <sstream>
 #include <V3DLib.h>
+#include "BlobKernel.h"
+#include "PersistentKernel.h"
+#include "CoSchedule.h"
+#include "Common/StreamExecutor.h"
 #include "LibSettings.h"
 #include "Support/pgm.h"
 #include "support/support.h"
 #include "Source/Complex.h"
 #include "Source/Functions.h"
+#include "vc4/DMA/Operations.h"
 
 using namespace V3DLib;
 using namespace std;
@@ -575,6 +581,1037 @@ TEST_CASE("Test specific operations in DSL [dsl][ops]") {
 }
 
 
+void int8x4_kernel(Int::Ptr result, Int::Ptr a_in, Int::Ptr b_in) {
+  auto store = [&result] (Int8x4 const &val) {
+    Int tmp = val.as_int();
+    *result = tmp;
+    result += 16;
+  };
+
+  Int8x4 a = *a_in;
+  Int8x4 b = *b_in;
+
+  store(a + b);
+  store(a - b);
+  store(a*b);
+  store(V3DLib::min(a, b));  // Avoid confusion with std::min()
+  store(V3DLib::max(a, b));
+
+  // Pack and unpack
+  Int8x4 c = pack8x4(a.get(3), a.get(2), a.get(1), a.get(0));
+  store(c);
+}
+
+
+TEST_CASE("Test packed 8-bit operations [dsl][int8x4]") {
+  int const N = 6;  // Number of expected results
+
+  Int::Array a(16);
+  Int::Array b(16);
+  Int::Array result(16*N);
+
+  int const vals[] = {0, 1, 2, 3, 64, 100, 127, 128, 129, 200, 254, 255};
+  int const NUM_VALS = (int) (sizeof(vals)/sizeof(vals[0]));
+
+  for (int i = 0; i < 16; i++) {
+    a[i] = Int8x4::pack(vals[i % NUM_VALS], vals[(i + 3) % NUM_VALS], vals[(i*5) % NUM_VALS], 255 - i);
+    b[i] = Int8x4::pack(vals[(i + 7) % NUM_VALS], vals[i % NUM_VALS], vals[(i*7 + 1) % NUM_VALS], 17*i);
+  }
+
+  auto expected = [&a, &b] (int n, int i) -> int {
+    int ret[4];
+
+    for (int j = 0; j < 4; j++) {
+      int x = Int8x4::unpack(a[i], j);
+      int y = Int8x4::unpack(b[i], j);
+
+      switch (n) {
+        case 0: ret[j] = std::min(x + y, 255); break;
+        case 1: ret[j] = std::max(x - y, 0);   break;
+        case 2: ret[j] = (x*y + 127)/255;      break;
+        case 3: ret[j] = std::min(x, y);       break;
+        case 4: ret[j] = std::max(x, y);       break;
+        case 5: ret[j] = Int8x4::unpack(a[i], 3 - j); break;
+      }
+    }
+
+    return Int8x4::pack(ret[0], ret[1], ret[2], ret[3]);
+  };
+
+  auto check = [&] () {
+    for (int n = 0; n < N; n++) {
+      for (int i = 0; i < 16; i++) {
+        INFO("n: " << n << ", i: " << i);
+        REQUIRE(result[16*n + i] == expected(n, i));
+      }
+    }
+  };
+
+  auto k = compile(int8x4_kernel);  // v3d emulates packed ops with 32-bit ops, this should compile
+  k.load(&result, &a, &b);
+
+  result.fill(-1);
+  k.interpret();
+  check();
+
+  result.fill(-1);
+  k.emu();
+  check();
+}
+
+
+void half_kernel(Half::Ptr result, Float::Ptr result_float, Half::Ptr src) {
+  For (Int n = 0, n < 2, n++)
+    Float lo, hi;
+    half_load(src, lo, hi);
+
+    *result_float = lo; result_float += 16;
+    *result_float = hi; result_float += 16;
+    half_store(result, lo*2.0f + 1.0f, hi*hi);
+
+    src += 16;
+    result += 16;
+  End
+}
+
+
+TEST_CASE("Test half-precision storage [dsl][half]") {
+  int const N = 64;
+
+  float const vals[] = {0.0f, 1.0f, -1.0f, 0.1f, 1.5f, -2.75f, 1000.0f, 65504.0f, 70000.0f, 1e-3f, -3.14159f, 1e-6f};
+  int const NUM_VALS = (int) (sizeof(vals)/sizeof(vals[0]));
+
+  SUBCASE("Test host conversion") {
+    for (int i = 0; i < NUM_VALS; i++) {
+      INFO("i: " << i);
+      float val = vals[i];
+
+      if (val == 70000.0f) {
+        REQUIRE(Half::to_half(val) == 0x7c00);
+        REQUIRE(std::isinf(Half::to_float(Half::to_half(val))));
+      } else if (val == 1e-6f) {
+        REQUIRE(Half::to_half(val) == 0);  // denormal, flushed to zero
+      } else {
+        REQUIRE(Half::to_float(Half::to_half(val)) == doctest::Approx(val).epsilon(0.001));
+      }
+    }
+
+    REQUIRE(Half::to_half(-2.0f) == 0xc000);
+    REQUIRE(Half::to_float(0x3c00) == 1.0f);
+    REQUIRE(Half::to_float(0x7bff) == 65504.0f);
+  }
+
+  SUBCASE("Test kernel") {
+    Half::Array src(N);
+    Half::Array result(N);
+    Float::Array result_float(N);
+    REQUIRE(src.size() == N/2);
+
+    for (int i = 0; i < N; i++) {
+      src.set(i, vals[i % NUM_VALS]*((float) (1 + i/NUM_VALS)));
+    }
+
+    auto check = [&] () {
+      for (int i = 0; i < N; i++) {
+        INFO("i: " << i);
+        float x = src.get(i);
+        REQUIRE(result_float[i] == x);
+
+        float expected = (i % 32 < 16)? (x*2.0f + 1.0f) : (x*x);
+        REQUIRE(result.get(i) == Half::to_float(Half::to_half(expected)));
+      }
+    };
+
+    auto k = compile(half_kernel);
+    REQUIRE(!k.has_errors());
+    std::string v3d_code = k.v3d().targetCode().mnemonics();
+    REQUIRE(v3d_code.find("vfpack") != std::string::npos);  // v3d uses hardware conversion
+    REQUIRE(v3d_code.find("funpackh") != std::string::npos);
+    k.load(&result, &result_float, &src);
+
+    result.fill(-1.0f);
+    k.interpret();
+    check();
+
+    result.fill(-1.0f);
+    k.emu();
+    check();
+  }
+}
+
+
+void scatter_kernel(Int::Ptr result, Float::Ptr result_float, Int::Ptr result_dup, Int::Ptr perm) {
+  Int offset = 32*me();
+  Int p = *perm;
+
+  scatter(result + (offset + p - index()), 100*me() + index());
+  scatter(result_float + (offset + p - index()), toFloat(index())*0.5f);
+
+  Int::Ptr dst = result_dup + ((offset >> 2) + (index() >> 2) - index());
+  scatter(dst, index());
+}
+
+
+TEST_CASE("Test scatter [dsl][scatter]") {
+  int const MAX_QPUS = 4;
+
+  Int::Array perm(16);
+  for (int i = 0; i < 16; i++) {
+    perm[i] = (7*i + 3) % 32;
+  }
+
+  Int::Array result(32*MAX_QPUS);
+  Float::Array result_float(32*MAX_QPUS);
+  Int::Array result_dup(8*MAX_QPUS);
+
+  auto check = [&] (int num_qpus) {
+    for (int q = 0; q < num_qpus; q++) {
+      for (int i = 0; i < 32; i++) {
+        INFO("q: " << q << ", i: " << i);
+        int lane = -1;
+
+        for (int j = 0; j < 16; j++) {
+          if (perm[j] == i) lane = j;
+        }
+
+        if (lane == -1) {
+          REQUIRE(result[32*q + i] == -1);
+          REQUIRE(result_float[32*q + i] == -1.0f);
+        } else {
+          REQUIRE(result[32*q + i] == 100*q + lane);
+          REQUIRE(result_float[32*q + i] == 0.5f*((float) lane));
+        }
+      }
+
+      // With duplicate addresses, the highest lane wins
+      for (int i = 0; i < 4; i++) {
+        INFO("q: " << q << ", i: " << i);
+        REQUIRE(result_dup[8*q + i] == 4*i + 3);
+      }
+    }
+  };
+
+  auto reset = [&] () {
+    result.fill(-1);
+    result_float.fill(-1.0f);
+    result_dup.fill(-1);
+  };
+
+  auto k = compile(scatter_kernel);
+  REQUIRE(!k.has_errors());
+  k.load(&result, &result_float, &result_dup, &perm);
+
+  reset();
+  k.interpret();
+  check(1);
+
+  reset();
+  k.emu();
+  check(1);
+
+  reset();
+  k.setNumQPUs(MAX_QPUS);
+  k.emu();
+  check(MAX_QPUS);
+}
+
+
+void atomic_kernel(Int::Ptr counter, Int::Ptr old_vals, Int::Ptr hist, Int::Ptr minmax,
+                   Int::Ptr claims, Int::Ptr prev_claims) {
+  Int val = 16*me() + index();
+
+  // All lanes on the same address
+  Int old = atomic_add(counter - index(), 1);
+  Int::Ptr dst = old_vals + 16*me();
+  *dst = old;
+
+  atomic_add(hist + ((index() & 3) - index()), 1);
+  atomic_min(minmax - index(), val);
+  atomic_max(minmax + (1 - index()), val);
+
+  // Only the first lane to arrive at a slot claims it
+  Int prev = atomic_cmpxchg(claims + ((index() & 7) - index()), -1, val);
+  dst = prev_claims + 16*me();
+  *dst = prev;
+}
+
+
+TEST_CASE("Test atomic operations [dsl][atomic]") {
+  int const MAX_QPUS = 4;
+
+  Int::Array counter(16);
+  Int::Array old_vals(16*MAX_QPUS);
+  Int::Array hist(16);
+  Int::Array minmax(16);
+  Int::Array claims(16);
+  Int::Array prev_claims(16*MAX_QPUS);
+
+  auto reset = [&] () {
+    counter.fill(0);
+    old_vals.fill(-1);
+    hist.fill(0);
+    minmax.fill(0);
+    minmax[0] = 1000;
+    minmax[1] = -1000;
+    claims.fill(-1);
+    prev_claims.fill(-2);
+  };
+
+  auto check = [&] (int num_qpus) {
+    int const count = 16*num_qpus;
+    REQUIRE(counter[0] == count);
+
+    // Returned values are unique
+    std::vector<bool> seen(count, false);
+    for (int i = 0; i < count; i++) {
+      INFO("i: " << i);
+      REQUIRE(0 <= old_vals[i]);
+      REQUIRE(old_vals[i] < count);
+      REQUIRE(!seen[old_vals[i]]);
+      seen[old_vals[i]] = true;
+    }
+
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(hist[i] == 4*num_qpus);
+    }
+
+    REQUIRE(minmax[0] == 0);
+    REQUIRE(minmax[1] == count - 1);
+
+    // Every slot claimed exactly once, by a lane which saw it unclaimed
+    int num_claimed = 0;
+    for (int i = 0; i < count; i++) {
+      INFO("i: " << i);
+      int slot = i & 7;
+
+      if (prev_claims[i] == -1) {
+        num_claimed++;
+        REQUIRE(claims[slot] == i);
+      } else {
+        REQUIRE(claims[slot] != i);
+        REQUIRE(prev_claims[i] == claims[slot]);
+      }
+    }
+    REQUIRE(num_claimed == 8);
+  };
+
+  auto k = compile(atomic_kernel);
+  REQUIRE(!k.has_errors());
+
+  // v3d uses the TMU atomic operations. Every operation sets the uniform stream address
+  // to its TMU configuration before writing the address to TMUAU.
+  {
+    auto const &drv = static_cast<V3DLib::v3d::KernelDriver const &>(k.v3d());
+    int num_unif_addr = 0;
+    int num_tmuau     = 0;
+
+    for (auto const &instr : drv.instructions_v3d()) {
+      if (instr.is_branch()) {
+        if (instr.branch.ub && instr.branch.bdu == V3D_QPU_BRANCH_DEST_REGFILE) num_unif_addr++;
+        continue;
+      }
+
+      if ((instr.alu.add.magic_write && instr.alu.add.waddr == V3D_QPU_WADDR_TMUAU)
+       || (instr.alu.mul.magic_write && instr.alu.mul.waddr == V3D_QPU_WADDR_TMUAU)) {
+        REQUIRE(num_unif_addr == num_tmuau + 1);
+        num_tmuau++;
+      }
+    }
+
+    REQUIRE(num_tmuau == 5);
+    REQUIRE(num_unif_addr == 5);
+  }
+
+  k.load(&counter, &old_vals, &hist, &minmax, &claims, &prev_claims);
+
+  reset();
+  k.interpret();
+  check(1);
+
+  reset();
+  k.emu();
+  check(1);
+
+  reset();
+  k.setNumQPUs(MAX_QPUS);
+  k.emu();
+  check(MAX_QPUS);
+}
+
+
+void local_kernel(Int::Ptr result, Float::Ptr result_float) {
+  Local<Int> a(8);
+  Local<Float> f(4);
+
+  For (Int i = 0, i < 2, i++)
+    a.set(2*me() + i, 100*me() + 10*i + index());
+  End
+  f.set(me(), toFloat(index())*0.5f + toFloat(me()));
+
+  barrier();
+
+  Int next = me() + 1;
+  If (next == numQPUs())
+    next = 0;
+  End
+
+  Int val = a.get(2*next);
+  val += a.get(2*next + 1);
+
+  Int::Ptr dst = result + 16*me();
+  *dst = val;
+
+  Float::Ptr dst_float = result_float + 16*me();
+  *dst_float = f.get(next);
+}
+
+
+void local_too_large_kernel(Int::Ptr result) {
+  Local<Int> a(local::MAX_ROWS);
+  Local<Int> b(1);
+  b.set(0, index());
+  *result = b.get(0);
+}
+
+
+TEST_CASE("Test local arrays [dsl][local]") {
+  int const MAX_QPUS = 4;
+
+  Int::Array result(16*MAX_QPUS);
+  Float::Array result_float(16*MAX_QPUS);
+
+  auto check = [&] (int num_qpus) {
+    for (int q = 0; q < num_qpus; q++) {
+      int next = (q + 1) % num_qpus;
+
+      for (int i = 0; i < 16; i++) {
+        INFO("num_qpus: " << num_qpus << ", q: " << q << ", i: " << i);
+        REQUIRE(result[16*q + i] == 200*next + 10 + 2*i);
+        REQUIRE(result_float[16*q + i] == 0.5f*((float) i) + (float) next);
+      }
+    }
+  };
+
+  auto k = compile(local_kernel);
+  REQUIRE(!k.has_errors());
+  k.load(&result, &result_float);
+
+  for (int num_qpus : {1, MAX_QPUS}) {
+    k.setNumQPUs(num_qpus);
+
+    result.fill(-1);
+    result_float.fill(-1.0f);
+    k.interpret();
+    check(num_qpus);
+
+    result.fill(-1);
+    result_float.fill(-1.0f);
+    k.emu();
+    check(num_qpus);
+  }
+
+  auto k2 = compile(local_too_large_kernel);
+  REQUIRE(k2.has_errors());
+}
+
+
+/**
+ * Mixes a streaming load with a gather from the same array.
+ */
+void load_path_kernel(Int::Ptr result, Int::Ptr src, Int n) {
+  Int inc = 16*numQPUs();
+  Int::Ptr p   = src + 16*me();
+  Int::Ptr rev = src + 16*me() + (15 - 2*index());  // Reverse of block
+  Int::Ptr dst = result + 16*me();
+
+  For (Int i = me(), i < n, i += numQPUs())
+    Int a = *p;
+    Int b = *rev;
+    *dst = 100*a + b;
+
+    p   += inc;
+    rev += inc;
+    dst += inc;
+  End
+}
+
+
+TEST_CASE("Test selection of load path on vc4 [dsl][loadpath]") {
+  int const N        = 6;
+  int const MAX_QPUS = 4;
+
+  Int::Array src(16*N);
+  for (int i = 0; i < (int) src.size(); i++) {
+    src[i] = i + 1;
+  }
+
+  Int::Array result(16*N);
+
+  auto check = [&result] (char const *label) {
+    for (int i = 0; i < (int) result.size(); i++) {
+      int block = i/16;
+      int lane  = i%16;
+
+      INFO("label: " << label << ", block: " << block << ", lane: " << lane);
+      REQUIRE(result[i] == 100*(i + 1) + (16*block + (15 - lane) + 1));
+    }
+  };
+
+  auto run = [&] (char const *label) {
+    auto k = compile(load_path_kernel);
+    REQUIRE(!k.has_errors());
+    k.load(&result, &src, N);
+
+    for (int num_qpus : {1, MAX_QPUS}) {
+      k.setNumQPUs(num_qpus);
+
+      result.fill(-1);
+      k.interpret();
+      check(label);
+
+      result.fill(-1);
+      k.emu();
+      check(label);
+    }
+
+    return k.vc4().targetCode().mnemonics(true);
+  };
+
+  LibSettings::load_path(LibSettings::LOAD_AUTO);
+  std::string code = run("auto");
+  REQUIRE(code.find("Start pipelined DMA load") != std::string::npos);
+  REQUIRE(code.find("Start pipelined DMA prefetch") != std::string::npos);
+
+  LibSettings::use_tmu_for_load(false);  // Gather must still use TMU
+  code = run("dma");
+  REQUIRE(code.find("Start pipelined DMA load") == std::string::npos);
+  REQUIRE(code.find("Start DMA load var") != std::string::npos);
+
+  LibSettings::use_tmu_for_load(true);
+  code = run("tmu");
+  REQUIRE(code.find("DMA load var") == std::string::npos);
+}
+
+
+/**
+ * Streaming load in a kernel which writes to the VPM itself, vc4 only.
+ *
+ * VPM row `me()` overlaps with the buffer of a pipelined load.
+ */
+void load_path_vpm_kernel(Float::Ptr result, Float::Ptr src, Int n) {
+  Int inc = 16*numQPUs();
+  Float sum = 0;
+  Float::Ptr dst = result + 16*me();
+  src += 16*me();
+
+  For (Int i = me(), i < n, i += numQPUs())
+    Float x = *src;
+    sum += x;
+    src += inc;
+
+    dmaWaitWrite();
+    vpmSetupWrite(HORIZ, me());
+    vpmPut(sum);
+    dmaSetupWrite(HORIZ, 1, 16*me());
+    dmaStartWrite(dst);
+    dst += inc;
+  End
+
+  dmaWaitWrite();
+}
+
+
+TEST_CASE("Test no pipelined load with VPM usage in kernel [dsl][loadpath]") {
+  int const N = 8;
+
+  Float::Array src(16*N);
+  for (int i = 0; i < (int) src.size(); i++) {
+    src[i] = (float) (i + 1);
+  }
+
+  Float::Array result(16*N);
+
+  LibSettings::load_path(LibSettings::LOAD_AUTO);
+  auto k = compile(load_path_vpm_kernel, VC4);
+  LibSettings::load_path(LibSettings::LOAD_TMU);
+  REQUIRE(!k.has_errors());
+  REQUIRE(k.vc4().targetCode().mnemonics(true).find("pipelined DMA") == std::string::npos);
+
+  for (int num_qpus : {1, 4}) {
+    k.setNumQPUs(num_qpus);
+    k.load(&result, &src, N);
+    result.fill(-1);
+    k.emu();
+
+    for (int i = 0; i < (int) result.size(); i++) {
+      int block = i/16;
+      float expected = 0;
+      for (int b = block % num_qpus; b <= block; b += num_qpus) {
+        expected += src[16*b + i%16];
+      }
+
+      INFO("num_qpus: " << num_qpus << ", i: " << i);
+      REQUIRE(result[i] == expected);
+    }
+  }
+}
+
+
+void threads_kernel(Float::Ptr result, Float::Ptr src) {
+  Float sum = 0;
+
+  For (Int i = 0, i < 4, i++)
+    sum += *src;
+    src += 16;
+  End
+
+  *result = sum;
+}
+
+
+/**
+ * Keeps more values live than fit in the register file of 4 threads
+ */
+void threads_pressure_kernel(Float::Ptr result, Float::Ptr src) {
+  int const COUNT = 24;
+  std::vector<Float> vals;
+
+  for (int i = 0; i < COUNT; i++) {
+    vals.push_back(*(src + 16*i));
+  }
+
+  Float sum = 0;
+  for (int i = COUNT - 1; i >= 0; i--) {
+    sum = sum*2.0f + vals[i];
+  }
+
+  *result = sum;
+}
+
+
+void threads_barrier_kernel(Float::Ptr result, Float::Ptr src) {
+  Float sum = 0;
+
+  For (Int i = 0, i < 4, i++)
+    sum += *src;
+    src += 16;
+  End
+
+  barrier();
+  *result = sum;
+}
+
+
+TEST_CASE("Test multiple hardware threads on v3d [dsl][threads]") {
+  using V3dDriver = V3DLib::v3d::KernelDriver;
+
+  auto count_thrsw = [] (V3dDriver const &drv) -> int {
+    int ret = 0;
+    for (auto const &instr : drv.instructions_v3d()) {
+      if (!instr.is_branch() && instr.sig.thrsw) ret++;
+    }
+    return ret;
+  };
+
+  Float::Array src(16*24);
+  for (int i = 0; i < (int) src.size(); i++) {
+    src[i] = (float) (i/16);
+  }
+  Float::Array result(16);
+
+  // Baseline, single thread
+  auto k1 = compile(threads_kernel);
+  REQUIRE(!k1.has_errors());
+  auto const &drv1 = static_cast<V3dDriver const &>(k1.v3d());
+  REQUIRE(drv1.num_threads() == 1);
+
+  LibSettings::v3d_threads(4);
+
+  auto k4 = compile(threads_kernel);
+  REQUIRE(!k4.has_errors());
+  auto const &drv4 = static_cast<V3dDriver const &>(k4.v3d());
+  REQUIRE(drv4.num_threads() == 4);
+  REQUIRE(count_thrsw(drv4) > count_thrsw(drv1));    // Thread switch added for load in loop
+
+  // vc4 code is not affected
+  k4.load(&result, &src);
+  k4.emu();
+  REQUIRE(result[0] == 6.0f);  // 0 + 1 + 2 + 3
+
+  // Too many live variables, should fall back to fewer threads
+  auto kp = compile(threads_pressure_kernel);
+  REQUIRE(!kp.has_errors());
+  auto const &drvp = static_cast<V3dDriver const &>(kp.v3d());
+  REQUIRE(drvp.num_threads() < 4);
+
+  // A barrier needs all threads in a single workgroup, should fall back to a single thread
+  auto kb = compile(threads_barrier_kernel);
+  REQUIRE(!kb.has_errors());
+  auto const &drvb = static_cast<V3dDriver const &>(kb.v3d());
+  REQUIRE(drvb.num_threads() == 1);
+
+  LibSettings::v3d_threads(1);
+}
+
+
+void stream_kernel(Int n, Float::Ptr in, Float::Ptr out) {
+  in  += 16*me();
+  out += 16*me();
+
+  For (Int i = 16*me(), i < n, i += 16*numQPUs())
+    *out = 2.0f*(*in);
+    in  += 16*numQPUs();
+    out += 16*numQPUs();
+  End
+}
+
+
+TEST_CASE("Test streaming executor [dsl][stream]") {
+  using Stream = StreamExecutor<float>;
+  int const SIZE = 1000;      // Deliberately not a multiple of the chunk size
+
+  std::vector<float> input(SIZE);
+  for (int i = 0; i < SIZE; i++) {
+    input[i] = (float) i;
+  }
+
+  auto k = compile(stream_kernel);
+  k.setNumQPUs(2);
+
+  int launches = 0;
+  auto launch = [&k, &launches] (Float::Array &in, Float::Array &out, int count) {
+    k.load(count, &in, &out).emu();
+    launches++;
+  };
+
+  auto check = [&input] (std::vector<float> const &output) {
+    REQUIRE(output.size() == input.size());
+    for (int i = 0; i < (int) input.size(); i++) {
+      INFO("i: " << i);
+      REQUIRE(output[i] == 2*input[i]);
+    }
+  };
+
+  SUBCASE("Stream from and to vectors") {
+    std::vector<float> output;
+
+    Stream stream(128);
+    REQUIRE(stream.run(Stream::from_vector(input), Stream::to_vector(output), launch) == SIZE);
+    REQUIRE(launches == (SIZE + 127)/128);
+    check(output);
+  }
+
+  SUBCASE("Stream from and to files") {
+    FILE *in_file  = tmpfile();
+    FILE *out_file = tmpfile();
+    REQUIRE(in_file != nullptr);
+    REQUIRE(out_file != nullptr);
+
+    fwrite(input.data(), sizeof(float), input.size(), in_file);
+    rewind(in_file);
+
+    Stream stream(256, 3);
+    REQUIRE(stream.run(Stream::from_file(in_file), Stream::to_file(out_file), launch) == SIZE);
+
+    std::vector<float> output(SIZE);
+    rewind(out_file);
+    REQUIRE(fread(output.data(), sizeof(float), output.size(), out_file) == output.size());
+    REQUIRE(fgetc(out_file) == EOF);
+    check(output);
+
+    fclose(in_file);
+    fclose(out_file);
+  }
+
+  SUBCASE("Empty input does not launch the kernel") {
+    std::vector<float> empty;
+    std::vector<float> output;
+
+    Stream stream(128);
+    REQUIRE(stream.run(Stream::from_vector(empty), Stream::to_vector(output), launch) == 0);
+    REQUIRE(launches == 0);
+    REQUIRE(output.empty());
+  }
+}
+
+
+TEST_CASE("Test kernel blobs [dsl][blob]") {
+  using V3dDriver = V3DLib::v3d::KernelDriver;
+
+  REQUIRE(param_signature<Int, Float::Ptr, Complex::Ptr>() == "Int,Float::Ptr,Complex::Ptr");
+  REQUIRE(param_uniforms<Int, Float::Ptr, Complex::Ptr>() == 4);
+
+  auto k = compile(threads_kernel);
+  REQUIRE(!k.has_errors());
+
+  KernelBlob blob = k.blob();
+  REQUIRE(blob.signature == "Float::Ptr,Float::Ptr");
+  REQUIRE(blob.num_uniforms == 2);
+  REQUIRE(blob.vc4.present);
+  REQUIRE(blob.v3d.present);
+  REQUIRE(blob.vc4.numVars == k.vc4().numVars());
+  REQUIRE((int) blob.v3d.code.size() == static_cast<V3dDriver const &>(k.v3d()).kernel_size());
+  REQUIRE(!blob.vc4.code.empty());
+
+  SUBCASE("Blob survives a round trip through a file") {
+    char const *filename = "obj/test/threads_kernel.v3dk";
+    REQUIRE(blob.save(filename));
+
+    KernelBlob loaded;
+    REQUIRE(loaded.load(filename));
+    REQUIRE(loaded.signature    == blob.signature);
+    REQUIRE(loaded.num_uniforms == blob.num_uniforms);
+    REQUIRE(loaded.vc4.code     == blob.vc4.code);
+    REQUIRE(loaded.v3d.code     == blob.v3d.code);
+    REQUIRE(loaded.v3d.num_threads == blob.v3d.num_threads);
+    REQUIRE(loaded.serialize() == blob.serialize());
+  }
+
+  SUBCASE("Invalid blobs should be rejected") {
+    auto buf = blob.serialize();
+
+    KernelBlob bad;
+    auto truncated = buf;
+    truncated.resize(buf.size() - 4);
+    REQUIRE(!bad.deserialize(truncated));
+
+    auto wrong_version = buf;
+    wrong_version[4] = 99;
+    REQUIRE(!bad.deserialize(wrong_version));
+  }
+
+  SUBCASE("Blob kernel checks parameter types") {
+    REQUIRE_THROWS(BlobKernel<Int::Ptr, Float::Ptr>(blob));
+
+    BlobKernel<Float::Ptr, Float::Ptr> bk(blob);
+    REQUIRE(bk.has_vc4());
+    REQUIRE(bk.has_v3d());
+
+#ifndef QPU_MODE
+    Float::Array src(16*4);
+    Float::Array result(16);
+    bk.load(&result, &src);
+    REQUIRE_THROWS(bk.call());  // Blobs can not run on the emulator
+#endif  // QPU_MODE
+  }
+}
+
+
+
+void persistent_kernel(Int n, Float factor, Float::Ptr in, Float::Ptr out) {
+  in  += 16*me();
+  out += 16*me();
+
+  For (Int i = 16*me(), i < n, i += 16*numQPUs())
+    *out = factor*(*in);
+    in  += 16*numQPUs();
+    out += 16*numQPUs();
+  End
+}
+
+
+TEST_CASE("Test persistent kernels [dsl][persistent]") {
+  int const SIZE = 16*8;
+
+  Float::Array a(SIZE);
+  Float::Array b(SIZE);
+  Float::Array result_a(SIZE);
+  Float::Array result_b(SIZE);
+
+  for (int i = 0; i < SIZE; i++) {
+    a[i] = (float) i;
+    b[i] = (float) (SIZE - i);
+  }
+
+  auto check = [] (Float::Array &in, Float::Array &out, float factor, int count) {
+    for (int i = 0; i < SIZE; i++) {
+      INFO("i: " << i);
+      REQUIRE(out[i] == ((i < count)?factor*in[i]:0.0f));
+    }
+  };
+
+  auto k = compile_persistent(persistent_kernel, 4);
+
+  SUBCASE("Multiple calls run on a single launch") {
+    k.setNumQPUs(2);
+
+    for (int j = 0; j < 6; j++) {
+      result_a.fill(0);
+      result_b.fill(0);
+      k.load(SIZE, 1.0f + (float) j, &a, &result_a).emu();
+      k.load(SIZE/2, -2.0f, &b, &result_b).emu();
+      check(a, result_a, 1.0f + (float) j, SIZE);
+      check(b, result_b, -2.0f, SIZE/2);
+    }
+
+    REQUIRE(k.resident());
+    REQUIRE(k.launches() == 1);
+
+    k.stop();
+    REQUIRE(!k.resident());
+  }
+
+  SUBCASE("Multiple commands can be in flight") {
+    k.setNumQPUs(4);
+    result_a.fill(0);
+    result_b.fill(0);
+
+    // More commands than slots in the ring
+    int seq = 0;
+    for (int j = 0; j < 10; j++) {
+      seq = k.load(SIZE, 3.0f, &a, &result_a).submit();
+      k.load(SIZE, 0.5f, &b, &result_b).submit();
+    }
+
+    k.wait(seq + 1);
+    check(a, result_a, 3.0f, SIZE);
+    check(b, result_b, 0.5f, SIZE);
+    REQUIRE(k.launches() == 1);
+  }
+
+  SUBCASE("Number of QPUs can change between calls") {
+    int const num_qpus[] = { 2, 1, 3, 2 };
+    float factor = 1.0f;
+
+    for (int n : num_qpus) {
+      k.setNumQPUs(n);
+      result_a.fill(0);
+      k.load(SIZE, factor, &a, &result_a).emu();
+      check(a, result_a, factor, SIZE);
+      factor += 1.0f;
+    }
+
+    REQUIRE(k.launches() == 4);
+  }
+
+  SUBCASE("Idle kernel is stopped and relaunched on the next call") {
+    k.idle_timeout(0.1);
+    k.load(SIZE, 2.0f, &a, &result_a).emu();
+    REQUIRE(k.launches() == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    REQUIRE(!k.resident());
+
+    result_a.fill(0);
+    k.load(SIZE, 4.0f, &a, &result_a).emu();
+    check(a, result_a, 4.0f, SIZE);
+    REQUIRE(k.launches() == 2);
+  }
+}
+
+void cosched_light_kernel(Int::Ptr result) {
+  result += 16*me();
+  *result = 100*numQPUs() + me();
+}
+
+
+void cosched_heavy_kernel(Int n, Int::Ptr result) {
+  Int x = 0;
+
+  For (Int i = 0, i < n, i++)
+    x += i;
+  End
+
+  result += 16*me();
+  *result = x + 100*numQPUs() + me();
+}
+
+
+TEST_CASE("Test co-scheduled kernels [dsl][cosched]") {
+  int const N = 40;
+
+  Int::Array light_result(16*2);
+  Int::Array heavy_result(16*3);
+  light_result.fill(-1);
+  heavy_result.fill(-1);
+
+  auto light = compile(cosched_light_kernel);
+  auto heavy = compile(cosched_heavy_kernel);
+  light.load(&light_result);
+  heavy.load(N, &heavy_result);
+
+  CoSchedule sched;
+  sched.add(light, 2).add(heavy, 3);
+  REQUIRE(sched.numQPUs() == 5);
+  REQUIRE(!sched.done(0));
+
+  sched.emu();
+
+  // me() and numQPUs() are relative to the kernel
+  for (int i = 0; i < (int) light_result.size(); i++) {
+    INFO("i: " << i);
+    REQUIRE(light_result[i] == 200 + i/16);
+  }
+
+  for (int i = 0; i < (int) heavy_result.size(); i++) {
+    INFO("i: " << i);
+    REQUIRE(heavy_result[i] == N*(N - 1)/2 + 300 + i/16);
+  }
+
+  REQUIRE(sched.done(0));
+  REQUIRE(sched.done(1));
+  REQUIRE(sched.steps(0) > 0);
+  REQUIRE(sched.steps(0) < sched.steps(1));  // Light kernel is not held up by the heavy one
+
+  REQUIRE_THROWS(sched.add(heavy, Platform::max_qpus()));
+  REQUIRE(sched.size() == 2);
+}
+
+
+/**
+ * Write `count` values per QPU, with a masked store
+ */
+void cosched_masked_kernel(Int::Ptr result, Int base, Int count) {
+  result += 16*me();
+  store_masked(result, base + 16*me() + index(), count);
+}
+
+
+void cosched_barrier_kernel(Int::Ptr result) {
+  barrier();
+  result += 16*me();
+  *result = me();
+}
+
+
+TEST_CASE("Test co-scheduled kernels with shared resources [dsl][cosched]") {
+  SUBCASE("Masked stores do not interfere") {
+    int const COUNT = 5;
+    Int::Array a(16*2);
+    Int::Array b(16*2);
+    a.fill(-1);
+    b.fill(-1);
+
+    auto ka = compile(cosched_masked_kernel);
+    auto kb = compile(cosched_masked_kernel);
+    ka.load(&a, 1000, COUNT);
+    kb.load(&b, 2000, COUNT);
+
+    CoSchedule sched;
+    sched.add(ka, 2).add(kb, 2);
+    sched.emu();
+
+    for (int i = 0; i < 16*2; i++) {
+      INFO("i: " << i);
+      bool written = (i % 16 < COUNT);
+      REQUIRE(a[i] == (written? 1000 + i : -1));
+      REQUIRE(b[i] == (written? 2000 + i : -1));
+    }
+  }
+
+  SUBCASE("At most one kernel may use barrier()") {
+    auto k1 = compile(cosched_barrier_kernel);
+    auto k2 = compile(cosched_barrier_kernel);
+    auto k3 = compile(cosched_light_kernel);
+
+    CoSchedule sched;
+    sched.add(k1, 2).add(k3, 1);
+    REQUIRE_THROWS(sched.add(k2, 2));
+    REQUIRE(sched.size() == 2);
+  }
+}
+
+
 void nested_for_kernel(Int::Ptr result) {
   int const COUNT = 3;
   Int x = 0;
@@ -780,7 +1817,7 @@ TEST_CASE("Initialization with index() on uniform pointers should work as expect
     k.call();
     check("dma qpu");
 
-    LibSettings::use_tmu_for_load(false);
+    LibSettings::load_path(LibSettings::LOAD_TMU);
   }
 }
 
@@ -1,6 +1,7 @@
 #include "support/support.h"
 #include <iostream>
 #include <cmath>
+#include <complex>
 #include <V3DLib.h>
 #include "Support/Platform.h"
 #include "Support/Timer.h"
@@ -1494,3 +1495,88 @@ TEST_CASE("FFT Support [fft]") {
     }
   }
 }
+
+
+TEST_CASE("Test bulk conversion of complex arrays [fft][interleave]") {
+  struct cx { float re; float im; };  // Any type with two floats will do
+
+  int const N = 37;  // Not a multiple of the SIMD width
+
+  std::vector<std::complex<float>> src(N);
+  for (int i = 0; i < N; i++) {
+    src[i] = std::complex<float>((float) i, (float) -2*i);
+  }
+
+  SUBCASE("Complex::Array") {
+    Complex::Array arr(N);
+    arr.copyFrom(src.data(), N);
+
+    for (int i = 0; i < N; i++) {
+      REQUIRE(arr[i] == complex((float) i, (float) -2*i));
+    }
+
+    std::vector<cx> dst(N);
+    arr.copyTo(dst.data(), N);
+
+    for (int i = 0; i < N; i++) {
+      REQUIRE(dst[i].re == src[i].real());
+      REQUIRE(dst[i].im == src[i].imag());
+    }
+
+    // File round trip
+    FILE *f = tmpfile();
+    REQUIRE(f != nullptr);
+    REQUIRE(arr.write(f, N));
+    rewind(f);
+
+    Complex::Array arr2(N + 5);
+    arr2.fill(complex(-1, -1));
+    REQUIRE(arr2.read(f) == N);
+    fclose(f);
+
+    for (int i = 0; i < N; i++) {
+      REQUIRE(arr2[i] == arr[i]);
+    }
+    REQUIRE(arr2[N] == complex(-1, -1));
+  }
+
+  SUBCASE("Complex::Array2D") {
+    int const ROWS = 3;
+    int const COLS = 23;
+
+    std::vector<std::complex<float>> src2d(ROWS*COLS);
+    for (int i = 0; i < ROWS*COLS; i++) {
+      src2d[i] = std::complex<float>((float) i, (float) i + 0.5f);
+    }
+
+    for (auto type : { Layout2D::ROW_MAJOR, Layout2D::PADDED, Layout2D::BLOCKED, Layout2D::MORTON }) {
+      INFO("layout type: " << type);
+      Complex::Array2D arr(ROWS, COLS, type);
+      arr.copyFrom(src2d.data());
+
+      for (int r = 0; r < ROWS; r++) {
+        for (int c = 0; c < COLS; c++) {
+          auto const &v = src2d[r*COLS + c];
+          REQUIRE(arr[r][c] == complex(v.real(), v.imag()));
+        }
+      }
+
+      std::vector<std::complex<float>> dst(ROWS*COLS);
+      arr.copyTo(dst.data());
+      REQUIRE(dst == src2d);
+
+      FILE *f = tmpfile();
+      REQUIRE(f != nullptr);
+      REQUIRE(arr.write(f));
+      rewind(f);
+
+      Complex::Array2D arr2(ROWS, COLS);
+      REQUIRE(arr2.read(f) == (size_t) (ROWS*COLS));
+      fclose(f);
+
+      std::vector<std::complex<float>> dst2(ROWS*COLS);
+      arr2.copyTo(dst2.data());
+      REQUIRE(dst2 == src2d);
+    }
+  }
+}
@@ -63,6 +63,90 @@ TEST_CASE("Test functions [funcs]") {
 }
 
 
+namespace {
+
+void subroutine_kernel(Float::Ptr result, Int::Ptr result_int) {
+  Float x = toFloat(index())/16.0f;
+
+  *result = functions::cos(x);          result.inc();
+  *result = functions::sin(x);          result.inc();
+  *result = functions::cos(x + 0.25f);
+
+  Int q, r;
+  functions::integer_division(q, r, 100 + index(), 7);
+  *result_int = q;  result_int.inc();
+  *result_int = r;  result_int.inc();
+
+  functions::integer_division(q, r, -100 - index(), 3);
+  *result_int = q;  result_int.inc();
+  *result_int = r;
+}
+
+
+/**
+ * Count the occurences of a string in the output of a kernel
+ */
+int count_in(std::string const &haystack, std::string const &needle) {
+  int ret = 0;
+  size_t pos = haystack.find(needle);
+
+  while (pos != std::string::npos) {
+    ret++;
+    pos = haystack.find(needle, pos + needle.size());
+  }
+
+  return ret;
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test subroutines [funcs][subroutine]") {
+  auto check = [] (Float::Array &result, Int::Array &result_int) {
+    for (int i = 0; i < 16; i++) {
+      float x = ((float) i)/16.0f;
+      INFO("i: " << i);
+      REQUIRE(result[i]      == doctest::Approx(functions::cos(x)).epsilon(1e-5));
+      REQUIRE(result[16 + i] == doctest::Approx(functions::sin(x)).epsilon(1e-5));
+      REQUIRE(result[32 + i] == doctest::Approx(functions::cos(x + 0.25f)).epsilon(1e-5));
+
+      REQUIRE(result_int[i]      == (100 + i)/7);
+      REQUIRE(result_int[16 + i] == (100 + i)%7);
+      REQUIRE(result_int[32 + i] == (-100 - i)/3);
+      REQUIRE(result_int[48 + i] == (100 + i)%3);  // Remainder is taken over absolute values
+    }
+  };
+
+  auto k = compile(subroutine_kernel);
+
+  // Body of a subroutine is emitted only once per kernel
+  std::string code = k.vc4().targetCode().mnemonics(true);
+  REQUIRE(count_in(code, "Subroutine cos") == 1);
+  REQUIRE(count_in(code, "Subroutine integer_division") == 1);
+  REQUIRE(count_in(code, "Call cos") == 3);
+  REQUIRE(count_in(code, "Call integer_division") == 2);
+
+  Float::Array result(3*16);
+  Int::Array result_int(4*16);
+
+  SUBCASE("interpreter") {
+    result.fill(-1);
+    result_int.fill(-1);
+    k.load(&result, &result_int);
+    k.interpret();
+    check(result, result_int);
+  }
+
+  SUBCASE("emulator") {
+    result.fill(-1);
+    result_int.fill(-1);
+    k.load(&result, &result_int);
+    k.emu();
+    check(result, result_int);
+  }
+}
+
+
 template<typename T1, typename T2>
 void check_result(T1 const &result, T2 const &expected) {
   REQUIRE(expected.size() == result.size());
@@ -128,3 +212,363 @@ TEST_CASE("Test qpu sync [funcs][sync]") {
 
   Platform::use_main_memory(false);
 }
+
+
+/**
+ * Every phase, each QPU takes over the value of the next QPU.
+ * This only works if QPUs don't run ahead of each other.
+ */
+void barrier_kernel(Int::Ptr result, Int::Ptr buf) {
+  Int next = me() + 1;
+  If (next == numQPUs())
+    next = 0;
+  End
+
+  Int val = me();
+  Int::Ptr dst = buf + 16*me();
+  Int::Ptr src = buf + 16*next;
+
+  For (Int phase = 0, phase < 3, phase++)
+    // Let one qpu do extra work, to delay it
+    If (me() == 1)
+      For (Int i = 0, i < 64, i++)
+        *dst = -1;
+      End
+    End
+
+    *dst = val;
+    barrier();
+    val = *src;
+    val += 1;
+    barrier();
+  End
+
+  dst = result + 16*me();
+  *dst = val;
+}
+
+
+TEST_CASE("Test qpu barrier [funcs][barrier]") {
+  int const MAX_QPUS = 8;
+  int const PHASES   = 3;
+
+  Int::Array result(16*MAX_QPUS);
+  Int::Array buf(16*MAX_QPUS);
+
+  auto check = [&] (int num_qpus) {
+    for (int q = 0; q < num_qpus; q++) {
+      INFO("num_qpus: " << num_qpus << ", q: " << q);
+      int expected = (q + PHASES) % num_qpus + PHASES;
+
+      for (int i = 0; i < 16; i++) {
+        REQUIRE(result[16*q + i] == expected);
+      }
+    }
+  };
+
+  auto k = compile(barrier_kernel);
+  REQUIRE(!k.has_errors());
+
+  // The loads must see the stores of the other QPUs: vc4 loads with DMA instead of the TMU,
+  // v3d clears the TMU cache after every barrier.
+  std::string vc4_code = k.vc4().targetCode().mnemonics();
+  REQUIRE(vc4_code.find("TMU0_S") == std::string::npos);
+  REQUIRE(vc4_code.find("DMA_LD_ADDR") != std::string::npos);
+
+  std::string v3d_code = k.v3d().targetCode().mnemonics();
+  int num_l1_clear = 0;
+  for (auto pos = v3d_code.find("TMUAU"); pos != std::string::npos; pos = v3d_code.find("TMUAU", pos + 1)) {
+    num_l1_clear++;
+  }
+  REQUIRE(num_l1_clear == 2);
+
+  k.load(&result, &buf);
+
+  for (int num_qpus : {1, MAX_QPUS}) {
+    k.setNumQPUs(num_qpus);
+
+    result.fill(-1);
+    buf.fill(-1);
+    k.interpret();
+    check(num_qpus);
+
+    result.fill(-1);
+    buf.fill(-1);
+    k.emu();
+    check(num_qpus);
+  }
+}
+
+
+/**
+ * Barrier as very first statement, the generated code should not clash with the start of the program.
+ */
+void barrier_start_kernel(Int::Ptr result) {
+  barrier();
+  *(result + 16*me()) = me();
+}
+
+
+/**
+ * Barrier right after a short prefix
+ */
+void barrier_prefix_kernel(Int::Ptr result) {
+  Int y = me();
+  barrier();
+  *(result + 16*me()) = y + 1;
+}
+
+
+TEST_CASE("Test qpu barrier at kernel start [funcs][barrier]") {
+  int const NUM_QPUS = 4;
+  Int::Array result(16*NUM_QPUS);
+
+  auto check = [&] (int offset) {
+    for (int i = 0; i < (int) result.size(); i++) {
+      INFO("i: " << i);
+      REQUIRE(result[i] == i/16 + offset);
+    }
+  };
+
+  auto run = [&] (decltype(compile(barrier_start_kernel)) &k, int offset) {
+    REQUIRE(!k.has_errors());
+    k.setNumQPUs(NUM_QPUS);
+    k.load(&result);
+
+    result.fill(-1);
+    k.interpret();
+    check(offset);
+
+    result.fill(-1);
+    k.emu();
+    check(offset);
+  };
+
+  auto k1 = compile(barrier_start_kernel);
+  run(k1, 0);
+
+  auto k2 = compile(barrier_prefix_kernel);
+  run(k2, 1);
+}
+
+
+/**
+ * Copy `n` values, with a masked final vector.
+ * The loaded tail is also written to `tail` as a full vector.
+ */
+void masked_copy_kernel(Float::Ptr dst, Float::Ptr src, Float::Ptr tail, Int n) {
+  Int i = 0;
+
+  While (i + 16 <= n)
+    *dst = *src;
+    dst.inc();
+    src.inc();
+    i += 16;
+  End
+
+  If (i < n)
+    Float x = load_masked(src, n - i);
+    store_masked(dst, x, n - i);
+    *tail = x;
+  End
+}
+
+
+TEST_CASE("Test masked loads and stores [funcs][masked]") {
+  Platform::use_main_memory(true);
+
+  auto k = compile(masked_copy_kernel);
+
+  auto check = [&k] (int n, bool interpret) {
+    INFO("n: " << n << ", interpret: " << interpret);
+
+    Float::Array src(n);  // Size need not be a multiple of 16
+    for (int i = 0; i < n; i++) {
+      src[i] = (float) (i + 1);
+    }
+
+    Float::Array dst(64);
+    dst.fill(-1);
+
+    Float::Array tail(16);
+    tail.fill(-1);
+
+    k.load(&dst, &src, &tail, n);
+    if (interpret) {
+      k.interpret();
+    } else {
+      k.emu();
+    }
+
+    for (int i = 0; i < (int) dst.size(); i++) {
+      INFO("i: " << i);
+      REQUIRE(dst[i] == ((i < n)? (float) (i + 1) : -1.0f));
+    }
+
+    int rest = n % 16;
+    if (rest != 0) {
+      for (int i = 0; i < 16; i++) {
+        INFO("i: " << i);
+        REQUIRE(tail[i] == ((i < rest)? (float) (n - rest + i + 1) : 0.0f));
+      }
+    }
+  };
+
+  for (int n : { 16, 37, 1, 47 }) {
+    check(n, false);
+    check(n, true);
+  }
+
+  Platform::use_main_memory(false);
+}
+
+
+namespace {
+
+int const RANDOM_DRAWS = 3;
+
+void random_kernel(Int::Ptr ints, Float::Ptr uniforms, Float::Ptr normals, Float::Ptr pairs, Int seed) {
+  int const block = 16*RANDOM_DRAWS;
+  ints     += block*me();
+  uniforms += block*me();
+  normals  += block*me();
+  pairs    += 2*block*me();
+
+  Random rng(seed);
+
+  For (Int i = 0, i < RANDOM_DRAWS, i++)
+    *ints     = rng.next_int();
+    *uniforms = rng.uniform();
+    *normals  = rng.normal();
+    ints     += 16;
+    uniforms += 16;
+    normals  += 16;
+
+    Float u0, u1;
+    rng.uniform(u0, u1);
+    *pairs = u0;  pairs += 16;
+    *pairs = u1;  pairs += 16;
+  End
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test random number streams [funcs][random]") {
+  SUBCASE("Threefry matches the known-answer tests of Random123") {
+    uint32_t const ctr[3][2] = {{ 0, 0 }, { 0xffffffff, 0xffffffff }, { 0x243f6a88, 0x85a308d3 }};
+    uint32_t const key[3][2] = {{ 0, 0 }, { 0xffffffff, 0xffffffff }, { 0x13198a2e, 0x03707344 }};
+    uint32_t const expected13[3][2] = {{ 0x9d1c5ec6, 0x8bd50731 }, { 0xfd36d048, 0x2d17272c }, { 0xba3e4725, 0xf27d669e }};
+    uint32_t const expected20[3][2] = {{ 0x6b200159, 0x99ba4efe }, { 0x1cb996fc, 0xbb002be7 }, { 0xc4923a9c, 0x483df7a0 }};
+
+    for (int i = 0; i < 3; i++) {
+      INFO("i: " << i);
+      uint32_t out[2];
+
+      random::threefry2x32(ctr[i], key[i], out, 13);
+      REQUIRE(out[0] == expected13[i][0]);
+      REQUIRE(out[1] == expected13[i][1]);
+
+      random::threefry2x32(ctr[i], key[i], out, 20);
+      REQUIRE(out[0] == expected20[i][0]);
+      REQUIRE(out[1] == expected20[i][1]);
+    }
+  }
+
+  SUBCASE("Normal distribution has mean 0 and variance 1") {
+    int const N = 100000;
+    uint32_t const key[2] = { 1234, 0 };
+    double sum = 0;
+    double sum_sq = 0;
+
+    for (int n = 0; n < N; n++) {
+      uint32_t x[6];
+
+      for (int j = 0; j < 3; j++) {
+        uint32_t ctr[2] = { (uint32_t) (3*n + j), 0 };
+        random::threefry2x32(ctr, key, &x[2*j]);
+      }
+
+      double val = random::to_normal(x);
+      sum    += val;
+      sum_sq += val*val;
+    }
+
+    double mean = sum/N;
+    REQUIRE(mean == doctest::Approx(0.0).epsilon(0.01).scale(1.0));
+    REQUIRE(sum_sq/N - mean*mean == doctest::Approx(1.0).epsilon(0.01));
+  }
+
+  SUBCASE("Kernel streams are bit-identical to the host version") {
+    int const NUM_QPUS = 2;
+    int const SIZE     = 16*RANDOM_DRAWS*NUM_QPUS;
+    int const SEED     = 4321;
+
+    Int::Array ints(SIZE);
+    Float::Array uniforms(SIZE);
+    Float::Array normals(SIZE);
+    Float::Array pairs(2*SIZE);
+
+    auto check = [&] () {
+      for (int q = 0; q < NUM_QPUS; q++) {
+        for (int lane = 0; lane < 16; lane++) {
+          uint32_t const key[2] = { SEED, (uint32_t) (16*q + lane) };
+          uint32_t n = 0;
+
+          auto block = [&key, &n] (uint32_t out[2]) {
+            uint32_t ctr[2] = { n++, 0 };
+            random::threefry2x32(ctr, key, out);
+          };
+
+          for (int i = 0; i < RANDOM_DRAWS; i++) {
+            INFO("q: " << q << ", lane: " << lane << ", i: " << i);
+            int index = 16*(RANDOM_DRAWS*q + i) + lane;
+            uint32_t x[6];
+
+            block(x);
+            REQUIRE((uint32_t) ints[index] == x[0]);
+
+            block(x);
+            REQUIRE(uniforms[index] == random::to_uniform(x[0]));
+            REQUIRE(0.0f <= uniforms[index]);
+            REQUIRE(uniforms[index] < 1.0f);
+
+            block(&x[0]);
+            block(&x[2]);
+            block(&x[4]);
+            REQUIRE(normals[index] == random::to_normal(x));
+
+            int pair_index = 16*2*(RANDOM_DRAWS*q + i) + lane;
+            block(x);
+            REQUIRE(pairs[pair_index]      == random::to_uniform(x[0]));
+            REQUIRE(pairs[pair_index + 16] == random::to_uniform(x[1]));
+          }
+        }
+      }
+    };
+
+    auto reset = [&] () {
+      ints.fill(0);
+      uniforms.fill(-1.0f);
+      normals.fill(-100.0f);
+      pairs.fill(-1.0f);
+    };
+
+    auto k = compile(random_kernel);
+    REQUIRE(!k.has_errors());
+    k.setNumQPUs(NUM_QPUS);
+    k.load(&ints, &uniforms, &normals, &pairs, SEED);
+
+    reset();
+    k.interpret();
+    check();
+
+    reset();
+    k.emu();
+    check();
+
+    reset();
+    k.call();
+    check();
+  }
+}
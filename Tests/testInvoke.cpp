@@ -0,0 +1,109 @@
+#include "doctest.h"
+#include "Common/SharedArray.h"
+#include "Support/Platform.h"
+#include "vc4/Invoke.h"
+#include "vc4/vc4.h"
+
+using namespace V3DLib;
+
+namespace {
+
+/**
+ * Stand-in for the mailbox, counts the calls
+ */
+class CountingMailbox : public QPUMailbox {
+public:
+  int enables   = 0;
+  int disables  = 0;
+  int launches  = 0;
+  bool enabled  = false;
+  uint32_t last_messages = 0;
+
+  bool enable(bool on) override {
+    if (on) {
+      enables++;
+    } else {
+      disables++;
+    }
+
+    enabled = on;
+    return true;
+  }
+
+  bool execute(int numQPUs, uint32_t launch_messages, unsigned timeout_ms) override {
+    REQUIRE(enabled);
+    REQUIRE(numQPUs > 0);
+    REQUIRE(timeout_ms > 0);
+    last_messages = launch_messages;
+    launches++;
+    return true;
+  }
+};
+
+}  // anon namespace
+
+
+TEST_CASE("Test launch sessions on vc4 [vc4][session]") {
+  CountingMailbox mailbox;
+  set_qpu_mailbox(&mailbox);
+
+  Code code(8);
+  code.fill(0);
+
+  IntList params;
+  params << 1 << 2;
+
+  MailBoxInvoke invoker;
+
+  SUBCASE("Without session, every launch toggles the QPUs") {
+    for (int i = 0; i < 3; i++) {
+      invoker.invoke(4, code, params);
+    }
+
+    REQUIRE(mailbox.launches == 3);
+    REQUIRE(mailbox.enables  == 3);
+    REQUIRE(mailbox.disables == 3);
+    REQUIRE(!mailbox.enabled);
+  }
+
+  SUBCASE("Within a session, the QPUs are enabled once") {
+    uint32_t messages = 0;
+
+    {
+      LaunchSession session;
+      REQUIRE(LaunchSession::active());
+      REQUIRE(mailbox.enabled);
+
+      for (int i = 0; i < 10; i++) {
+        invoker.invoke(1 + (i % Platform::max_qpus()), code, params);
+
+        // Launch messages are set up once and reused
+        if (i == 0) messages = mailbox.last_messages;
+        REQUIRE(mailbox.last_messages == messages);
+      }
+
+      {
+        LaunchSession nested;
+        invoker.invoke(2, code, params);
+      }
+
+      REQUIRE(mailbox.enabled);
+      REQUIRE(mailbox.disables == 0);
+    }
+
+    REQUIRE(!LaunchSession::active());
+    REQUIRE(mailbox.launches == 11);
+    REQUIRE(mailbox.enables  == 1);
+    REQUIRE(mailbox.disables == 1);
+    REQUIRE(!mailbox.enabled);
+  }
+
+  set_qpu_mailbox(nullptr);
+}
+
+
+TEST_CASE("Test launch session without vc4 mailbox [vc4][session]") {
+  // Should not try to open the mailbox device
+  LaunchSession session;
+  REQUIRE(!LaunchSession::active());
+}
@@ -0,0 +1,99 @@
+#include "doctest.h"
+#include <V3DLib.h>
+#include "Liveness/Liveness.h"
+#include "Liveness/Optimizations.h"
+#include "Target/instr/Mnemonics.h"
+
+using namespace V3DLib;
+
+namespace {
+
+int const NUM_VARS = 8;
+
+Reg var(int id) { return Reg(REG_A, id); }
+
+
+/**
+ * Target code with a loop, repeated immediates and short-lived variables,
+ * so that both `combineImmediates()` and `introduceAccum()` have something to do.
+ */
+Instr::List loop_code() {
+  using namespace Target::instr;
+
+  Label start = freshLabel();
+  Label end   = freshLabel();
+
+  BranchCond cond;
+  cond.tag  = BranchCond::COND_ANY;
+  cond.flag = ZC;
+
+  Instr::List ret;
+
+  ret << li(var(0), 1000)                   // Immediate, loaded again in the loop
+      << li(var(1), 0)                      // Loop counter
+      << li(var(2), 7)                      // Basic immediate, substituted in uses
+      << label(start)
+      << li(var(3), 1000)
+      << add(var(4), var(3), var(1))        // Replaceable by accumulator
+      << add(var(5), var(4), var(2))
+      << li(var(6), 1000)
+      << add(var(7), var(5), var(6))
+      << add(var(1), var(1), var(2))
+      << sub(var(7), var(7), 1).setCondFlag(ZC)
+      << branch(start).branch_cond(cond)
+      << label(end)
+      << add(var(0), var(0), var(1))
+      << Instr(END);
+
+  return ret;
+}
+
+
+/**
+ * Compare the live sets with those of a liveness analysis from scratch
+ */
+void check_against_full(Liveness &live, Instr::List &instrs) {
+  Liveness full(NUM_VARS);
+  full.compute(instrs);
+
+  REQUIRE(live.size() == full.size());
+
+  for (int i = 0; i < live.size(); i++) {
+    INFO("instr " << i << ": " << instrs[i].dump());
+    INFO("incremental: " << live[i].dump() << ", full: " << full[i].dump());
+    REQUIRE(live[i] == full[i]);
+  }
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test incremental liveness update [liveness]") {
+  SUBCASE("Update per optimization") {
+    Instr::List instrs = loop_code();
+
+    Liveness live(NUM_VARS);
+    live.compute(instrs);
+    check_against_full(live, instrs);
+
+    RegIdSet changed;
+    REQUIRE(combineImmediates(live, instrs, changed));
+    REQUIRE(!changed.empty());
+    live.update(instrs, changed);
+    check_against_full(live, instrs);
+
+    changed.clear();
+    REQUIRE(introduceAccum(live, instrs, changed) > 0);
+    REQUIRE(!changed.empty());
+    live.update(instrs, changed);
+    check_against_full(live, instrs);
+  }
+
+  SUBCASE("Update after optimize()") {
+    Instr::List instrs = loop_code();
+
+    Liveness live(NUM_VARS);
+    live.optimize(instrs);     // Also removes the SKIPs
+    check_against_full(live, instrs);
+  }
+}
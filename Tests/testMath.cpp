@@ -0,0 +1,172 @@
+#include "doctest.h"
+#include <cmath>
+#include <functional>
+#include <V3DLib.h>
+
+using namespace V3DLib;
+
+namespace {
+
+enum Func {
+  F_RECIP,
+  F_RSQRT,
+  F_SQRT,
+  F_EXP,
+  F_LOG,
+  F_POW,
+  F_TANH,
+  F_ATAN2,
+  F_ASIN,
+  F_ACOS,
+  F_SIN,
+  F_COS
+};
+
+// Selection of the function to compile, read at compile time of the kernel
+Func            test_func;
+math::Precision test_precision;
+
+
+void math_kernel(Int n, Float::Ptr x, Float::Ptr y, Float::Ptr result) {
+  For (Int i = 0, i < n, i += 16)
+    Float a = *x;
+    Float b = *y;
+    Float r;
+    Float dummy;
+
+    auto p = test_precision;
+
+    switch (test_func) {
+      case F_RECIP: r = math::recip(a, p);    break;
+      case F_RSQRT: r = math::rsqrt(a, p);    break;
+      case F_SQRT:  r = math::sqrt(a, p);     break;
+      case F_EXP:   r = math::exp(a, p);      break;
+      case F_LOG:   r = math::log(a, p);      break;
+      case F_POW:   r = math::pow(a, b, p);   break;
+      case F_TANH:  r = math::tanh(a, p);     break;
+      case F_ATAN2: r = math::atan2(a, b, p); break;
+      case F_ASIN:  r = math::asin(a, p);     break;
+      case F_ACOS:  r = math::acos(a, p);     break;
+      case F_SIN:   math::sincos(a, r, dummy, p); break;
+      case F_COS:   math::sincos(a, dummy, r, p); break;
+    }
+
+    *result = r;
+    x += 16; y += 16; result += 16;
+  End
+}
+
+
+/**
+ * Error in units of the last place of the float closest to the reference value
+ */
+double ulp_error(float val, double expected) {
+  float e = (float) std::abs(expected);
+  double ulp = (double) std::nextafter(e, INFINITY) - (double) e;
+  return std::abs(val - expected)/ulp;
+}
+
+
+struct Range {
+  Func func;
+  float x_min;
+  float x_max;
+  float y_min;
+  float y_max;
+  std::function<double(double, double)> ref;
+
+  // Bound per precision tier, negative to skip.
+  // FAST: relative or absolute error, whichever is larger. MEDIUM, HIGH: ULP
+  double max_error[3];
+};
+
+
+/**
+ * Run the given function over a grid of inputs and return the max errors
+ */
+void measure(Range const &r, math::Precision p, bool use_emu, double &max_ulp, double &max_err) {
+  int const N = 16*64;
+
+  test_func      = r.func;
+  test_precision = p;
+  auto k = compile(math_kernel);
+
+  Float::Array x(N);
+  Float::Array y(N);
+  Float::Array result(N);
+
+  for (int i = 0; i < N; i++) {
+    // Two interleaved grids, so that x and y vary independently
+    x[i] = r.x_min + (r.x_max - r.x_min)*((float) i/(N - 1));
+    y[i] = r.y_min + (r.y_max - r.y_min)*((float) ((i*37) % N)/(N - 1));
+  }
+
+  k.load(N, &x, &y, &result);
+  if (use_emu) {
+    k.emu();
+  } else {
+    k.interpret();
+  }
+
+  max_ulp = 0;
+  max_err = 0;
+
+  for (int i = 0; i < N; i++) {
+    double expected = r.ref(x[i], y[i]);
+    max_ulp = std::max(max_ulp, ulp_error(result[i], expected));
+    max_err = std::max(max_err, std::abs(result[i] - expected)/std::max(1.0, std::abs(expected)));
+  }
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test math library [funcs][math]") {
+  auto ref = [] (double (*f)(double)) {
+    return [f] (double x, double) { return f(x); };
+  };
+
+  std::vector<Range> ranges = {
+    { F_RECIP,  0.01f,  100.0f,  0,  0, [] (double x, double) { return 1/x; },            { 1e-6, 1, 1 } },
+    { F_RSQRT,  0.01f,  100.0f,  0,  0, [] (double x, double) { return 1/std::sqrt(x); }, { 1e-6, 2, 2 } },
+    { F_SQRT,   0.0f,   100.0f,  0,  0, ref(std::sqrt),  { 1e-6, 2, 1 } },
+    { F_EXP,  -87.0f,    88.0f,  0,  0, ref(std::exp),   { 1e-5, 3, 1 } },
+    { F_LOG,    1e-30f,  1e30f,  0,  0, ref(std::log),   { 1e-6, 1, 1 } },
+    { F_LOG,    0.5f,     2.0f,  0,  0, ref(std::log),   { 1e-6, 3, 3 } },
+    { F_POW,    0.01f,   10.0f, -8,  8, [] (double x, double y) { return std::pow(x, y); }, { 1e-5, 20, 20 } },
+    { F_TANH, -10.0f,    10.0f,  0,  0, ref(std::tanh),  { 1e-6, 3, 3 } },
+    { F_TANH,  -0.1f,     0.1f,  0,  0, ref(std::tanh),  { 1e-6, 3, 3 } },
+    { F_ATAN2,-10.0f,    10.0f,-10, 10, [] (double y, double x) { return std::atan2(y, x); }, { 2e-5, 2, 2 } },
+    { F_ASIN,  -1.0f,     1.0f,  0,  0, ref(std::asin),  { 2e-5, 3, 3 } },
+    { F_ACOS,  -1.0f,     1.0f,  0,  0, ref(std::acos),  { 2e-5, 3, 3 } },
+    { F_SIN,   -3.14f,    3.14f, 0,  0, ref(std::sin),   { 0.06, 2, 2 } },
+    { F_COS,   -3.14f,    3.14f, 0,  0, ref(std::cos),   { 0.06, 2, 2 } },
+    { F_SIN, -8000.0f,  8000.0f, 0,  0, ref(std::sin),   {   -1,-1, 2 } },
+    { F_COS, -8000.0f,  8000.0f, 0,  0, ref(std::cos),   {   -1,-1, 2 } },
+  };
+
+  auto run = [&ranges] (bool use_emu) {
+    math::Precision const tiers[] = { math::FAST, math::MEDIUM, math::HIGH };
+
+    for (auto const &r : ranges) {
+      for (int t = 0; t < 3; t++) {
+        if (r.max_error[t] < 0) continue;
+
+        double max_ulp;
+        double max_err;
+        measure(r, tiers[t], use_emu, max_ulp, max_err);
+
+        INFO("func: " << r.func << ", tier: " << t << ", range: " << r.x_min << ".." << r.x_max);
+        CHECK(((t == 0)?max_err:max_ulp) <= r.max_error[t]);
+      }
+    }
+  };
+
+  SUBCASE("interpreter") {
+    run(false);
+  }
+
+  SUBCASE("emulator") {
+    run(true);
+  }
+}
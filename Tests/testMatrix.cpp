@@ -11,6 +11,9 @@
 #include "Support/basics.h"
 #include "Kernels/ComplexDotVector.h"
 #include "Kernels/Matrix.h"
+#include "Kernels/GEMM.h"
+#include "Kernels/SpMV.h"
+#include "Kernels/LayoutPtr.h"
 #include "support/matrix_support.h"
 #include "support/ProfileOutput.h"
 #include "Support/Timer.h"
@@ -805,3 +808,472 @@ TEST_CASE("Test matrix mult on emulator [matrix][emu]") {
 
   Platform::use_main_memory(false);
 }
+
+
+namespace {
+
+/**
+ * Calculate the expected result of a GEMM with epilogue on the CPU.
+ *
+ * Matrix b is transposed.
+ */
+std::vector<float> gemm_scalar(
+  int rows, int inner, int columns, int cols_result,
+  float const *a, float const *b, float const *bias,
+  kernels::Epilogue const &epilogue
+) {
+  std::vector<float> ret(rows*cols_result, 0.0f);
+
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < columns; c++) {
+      float sum = 0;
+
+      for (int i = 0; i < inner; i++) {
+        sum += a[r*inner + i]*b[c*inner + i];
+      }
+
+      ret[r*cols_result + c] = epilogue.apply(sum, bias, c);
+    }
+  }
+
+  return ret;
+}
+
+
+void check_gemm(Float::Array2D &result, std::vector<float> const &expected, int columns) {
+  for (int r = 0; r < result.rows(); r++) {
+    for (int c = 0; c < columns; c++) {
+      INFO("r: " << r << ", c: " << c);
+      REQUIRE(result[r][c] == doctest::Approx(expected[r*result.columns() + c]).epsilon(1e-4));
+    }
+  }
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test GEMM with epilogue [matrix][gemm]") {
+  Platform::use_main_memory(true);
+
+  int const ROWS    = 5;
+  int const INNER   = 2*16;
+  int const COLUMNS = 20;
+
+  std::vector<float> a_scalar(ROWS*INNER);
+  std::vector<float> b_scalar(COLUMNS*INNER);
+  fill_random(a_scalar);
+  fill_random(b_scalar);
+
+  Float::Array2D a(ROWS, INNER);
+  Float::Array2D b(COLUMNS, INNER);  // Remember, b transposed
+  copy_array(a, a_scalar);
+  copy_array(b, b_scalar);
+
+  Float::Array bias(32);
+  std::vector<float> bias_scalar(32);
+  for (int i = 0; i < (int) bias.size(); i++) {
+    bias_scalar[i] = 0.1f*((float) (i % 7)) - 0.3f;
+    bias[i] = bias_scalar[i];
+  }
+
+  auto test = [&] (kernels::Epilogue const &epilogue, bool use_bias, int num_qpus, int num_blocks) {
+    INFO("num QPUs: " << num_qpus << ", num blocks: " << num_blocks);
+
+    GEMM m(a, b);
+    m.epilogue(epilogue);
+    if (use_bias) m.bias(bias);
+    m.setNumQPUs(num_qpus);
+    m.num_blocks(num_blocks);
+    m.call(EMULATE);
+
+    auto check_epilogue = epilogue;
+    check_epilogue.bias = use_bias;
+    auto expected = gemm_scalar(ROWS, INNER, COLUMNS, m.result().columns(),
+                                a_scalar.data(), b_scalar.data(), bias_scalar.data(), check_epilogue);
+    check_gemm(m.result(), expected, COLUMNS);
+  };
+
+  SUBCASE("Scale, bias and ReLU") {
+    kernels::Epilogue epilogue;
+    epilogue.scale      = 0.5f;
+    epilogue.activation = kernels::Epilogue::RELU;
+
+    test(epilogue, true, 1, 1);
+    test(epilogue, true, 4, 1);
+    test(epilogue, true, 1, 2);   // Epilogue only on last block
+    test(epilogue, true, 3, 2);
+  }
+
+  SUBCASE("Clamp without bias") {
+    kernels::Epilogue epilogue;
+    epilogue.activation = kernels::Epilogue::CLAMP;
+    epilogue.clamp_min  = -0.5f;
+    epilogue.clamp_max  =  0.5f;
+
+    test(epilogue, false, 1, 2);
+  }
+
+  SUBCASE("Custom epilogue") {
+    kernels::Epilogue epilogue;
+    epilogue.custom = [] (Float &result, Int const &col) {
+      result = result + toFloat(col + index());
+    };
+
+    GEMM m(a, b);
+    m.epilogue(epilogue);
+    m.num_blocks(2);
+    m.call(EMULATE);
+
+    auto expected = gemm_scalar(ROWS, INNER, COLUMNS, m.result().columns(),
+                                a_scalar.data(), b_scalar.data(), nullptr, kernels::Epilogue());
+    for (int r = 0; r < ROWS; r++) {
+      for (int c = 0; c < COLUMNS; c++) {
+        expected[r*m.result().columns() + c] += (float) c;
+      }
+    }
+
+    check_gemm(m.result(), expected, COLUMNS);
+  }
+
+  SUBCASE("Batched GEMM") {
+    int const BATCH    = 7;
+    int const B_ROWS   = 3;
+    int const B_INNER  = 16;
+    int const B_COLS   = 5;
+
+    BatchedGEMM m(B_ROWS, B_INNER, B_COLS);
+    int const cols_result = m.cols_result();
+
+    std::vector<float> ba_scalar(BATCH*B_ROWS*B_INNER);
+    std::vector<float> bb_scalar(BATCH*B_COLS*B_INNER);
+    fill_random(ba_scalar);
+    fill_random(bb_scalar);
+
+    Float::Array ba(BATCH*B_ROWS*B_INNER);
+    Float::Array bb(BATCH*B_COLS*B_INNER);
+    Float::Array result(BATCH*B_ROWS*cols_result);
+    for (int i = 0; i < (int) ba.size(); i++) ba[i] = ba_scalar[i];
+    for (int i = 0; i < (int) bb.size(); i++) bb[i] = bb_scalar[i];
+    result.fill(-1);
+
+    kernels::Epilogue epilogue;
+    epilogue.scale      = 2.0f;
+    epilogue.activation = kernels::Epilogue::RELU;
+    m.epilogue(epilogue).bias(bias);
+    m.setNumQPUs(4);
+    m.call(ba, bb, result, BATCH, EMULATE);
+
+    epilogue.bias = true;
+
+    for (int n = 0; n < BATCH; n++) {
+      auto expected = gemm_scalar(B_ROWS, B_INNER, B_COLS, cols_result,
+                                  ba_scalar.data() + n*B_ROWS*B_INNER,
+                                  bb_scalar.data() + n*B_COLS*B_INNER,
+                                  bias_scalar.data(), epilogue);
+
+      for (int r = 0; r < B_ROWS; r++) {
+        for (int c = 0; c < B_COLS; c++) {
+          INFO("n: " << n << ", r: " << r << ", c: " << c);
+          int offset = r*cols_result + c;
+          REQUIRE(result[n*B_ROWS*cols_result + offset] == doctest::Approx(expected[offset]).epsilon(1e-4));
+        }
+      }
+    }
+  }
+
+  Platform::use_main_memory(false);
+}
+
+
+TEST_CASE("Test transpose on QPUs [matrix][transpose]") {
+  Platform::use_main_memory(true);
+
+  auto test = [] (int rows, int columns, int num_qpus, CallType call_type = EMULATE) {
+    INFO("rows: " << rows << ", columns: " << columns << ", num QPUs: " << num_qpus);
+
+    Float::Array2D src(rows, columns);
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < columns; c++) {
+        src[r][c] = (float) (1000*r + c);
+      }
+    }
+
+    Float::Array2D dst;
+    Transpose t;
+    t.setNumQPUs(num_qpus);
+    t.call(dst, src, call_type);
+    REQUIRE(!t.has_errors());
+
+    REQUIRE(dst.rows() == columns);
+    REQUIRE(dst.columns() == rows);
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < columns; c++) {
+        INFO("r: " << r << ", c: " << c);
+        REQUIRE(dst[c][r] == src[r][c]);
+      }
+    }
+  };
+
+  SUBCASE("Float arrays") {
+    test(16, 16, 1);
+    test(32, 20, 1);   // Partial tile in columns
+    test(48,  7, 3);
+    test(64, 48, 4);
+
+    // Any dimensions
+    test(20,  7, 1);
+    test( 5, 33, 2);
+    test(37, 50, 3);
+
+    test(32, 20, 2, INTERPRET);
+    test(20,  7, 1, INTERPRET);
+  }
+
+  SUBCASE("Complex arrays") {
+    Complex::Array2D src(16, 24);
+    for (int r = 0; r < src.rows(); r++) {
+      for (int c = 0; c < src.columns(); c++) {
+        src[r][c] = complex((float) r, (float) c);
+      }
+    }
+
+    Complex::Array2D dst;
+    Transpose t;
+    t.call(dst, src, EMULATE);
+
+    for (int r = 0; r < src.rows(); r++) {
+      for (int c = 0; c < src.columns(); c++) {
+        INFO("r: " << r << ", c: " << c);
+        REQUIRE(dst[c][r] == src[r][c]);
+      }
+    }
+  }
+
+  SUBCASE("Matrix with untransposed b") {
+    int const ROWS    = 5;
+    int const INNER   = 2*16;
+    int const COLUMNS = 20;
+
+    std::vector<float> a_scalar(ROWS*INNER);
+    std::vector<float> b_scalar(INNER*COLUMNS);
+    std::vector<float> b_transposed(COLUMNS*INNER);
+    fill_random(a_scalar);
+    fill_random(b_scalar);
+    copy_transposed(b_transposed, b_scalar, INNER, COLUMNS);
+
+    Float::Array2D a(ROWS, INNER);
+    Float::Array2D b(INNER, COLUMNS);
+    Float::Array2D b_t(COLUMNS, INNER);
+    copy_array(a, a_scalar);
+    copy_array(b, b_scalar);
+    copy_array(b_t, b_transposed);
+
+    Matrix expected(a, b_t);
+    expected.call(EMULATE);
+
+    Matrix m(a, b, false);
+    m.setNumQPUs(2);
+    m.call(EMULATE);
+
+    REQUIRE(m.result().rows()    == expected.result().rows());
+    REQUIRE(m.result().columns() == expected.result().columns());
+    for (int r = 0; r < ROWS; r++) {
+      for (int c = 0; c < COLUMNS; c++) {
+        INFO("r: " << r << ", c: " << c);
+        REQUIRE(m.result()[r][c] == doctest::Approx(expected.result()[r][c]).epsilon(1e-4));
+      }
+    }
+  }
+
+  Platform::use_main_memory(false);
+}
+
+
+namespace {
+
+/**
+ * Copy an array with given layout to a row-major array
+ *
+ * Even rows are read as vectors, odd rows per lane. Columns must be a multiple of 16.
+ */
+template<Layout2D::Type type>
+void layout_to_row_major(Float::Ptr dst, Float::Ptr src, Int rows, Int columns, Int pitch) {
+  LayoutPtr<Float> in(src, type, pitch);
+
+  For (Int r = 0, r < rows, r++)
+    For (Int c = 0, c < columns, c += 16)
+      Float::Ptr p = dst + (r*columns + c);
+
+      If ((r & 1) == 0)
+        *p = *in.at(r, c);
+      Else
+        *p = *in.lane_at(r, c + index());
+      End
+    End
+  End
+}
+
+
+void test_layout(Layout2D const &layout, int rows, int columns) {
+  Float::Array2D a(rows, columns, layout);
+  REQUIRE(a.layout().size() >= rows*columns);
+
+  std::vector<float> src(rows*columns);
+  for (int i = 0; i < (int) src.size(); i++) {
+    src[i] = (float) i;
+  }
+
+  a.copyFrom(src);
+
+  std::vector<float> dst;
+  a.copyTo(dst);
+  REQUIRE(dst == src);
+
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < columns; c++) {
+      REQUIRE(a[r][c] == src[r*columns + c]);
+    }
+  }
+
+  // Conversion between layouts
+  Float::Array2D b(rows, columns, Layout2D::PADDED);
+  b.copy_from(a);
+  REQUIRE(b == a);
+
+  Float::Array2D c(rows, columns, Layout2D::MORTON);
+  c.copy_from(b);
+  REQUIRE(c == a);
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test 2D array layouts [matrix][layout]") {
+  SUBCASE("Host access and conversion") {
+    test_layout(Layout2D(), 16, 20);
+    test_layout(Layout2D(Layout2D::PADDED), 7, 20);
+    test_layout(Layout2D(Layout2D::PADDED, 64), 16, 48);
+    test_layout(Layout2D(Layout2D::BLOCKED), 37, 41);
+    test_layout(Layout2D(Layout2D::MORTON), 37, 41);
+    test_layout(Layout2D(Layout2D::MORTON), 100, 20);
+
+    // Padding must be multiple of 16, and no more than needed for tiles
+    REQUIRE(Float::Array2D(7, 20, Layout2D::PADDED).pitch() == 32);
+    REQUIRE(Layout2D::morton(3, 5) == 0x1b);
+
+    Float::Array2D blocked(37, 41, Layout2D::BLOCKED);
+    REQUIRE(blocked.layout().size() == 48*48);
+    REQUIRE(blocked.layout().offset(17, 33) == (3 + 2)*256 + 1*16 + 1);
+  }
+
+
+  SUBCASE("Kernel access") {
+    Platform::use_main_memory(true);
+
+    int const ROWS    = 37;
+    int const COLUMNS = 48;
+
+    auto check = [] (Float::Array2D &src, auto kernel) {
+      INFO("layout type: " << src.layout().type());
+      for (int r = 0; r < ROWS; r++) {
+        for (int c = 0; c < COLUMNS; c++) {
+          src[r][c] = (float) (1000*r + c);
+        }
+      }
+
+      Float::Array2D dst(ROWS, COLUMNS);
+      dst.fill(-1);
+
+      auto k = compile(kernel);
+      k.load(&dst, &src, ROWS, COLUMNS, src.pitch());
+      k.emu();
+
+      REQUIRE(dst == src);
+    };
+
+    Float::Array2D padded(ROWS, COLUMNS, Layout2D(Layout2D::PADDED, 64));
+    check(padded, layout_to_row_major<Layout2D::PADDED>);
+
+    Float::Array2D blocked(ROWS, COLUMNS, Layout2D::BLOCKED);
+    check(blocked, layout_to_row_major<Layout2D::BLOCKED>);
+
+    Float::Array2D morton(ROWS, COLUMNS, Layout2D::MORTON);
+    check(morton, layout_to_row_major<Layout2D::MORTON>);
+
+    Platform::use_main_memory(false);
+  }
+}
+
+
+TEST_CASE("Test sparse matrix-vector multiplication [matrix][spmv]") {
+  Platform::use_main_memory(true);
+
+  int const ROWS    = 50;
+  int const COLUMNS = 40;
+
+  // Rows of varying length, including empty rows and one long row
+  std::vector<SparseEntry> entries;
+  for (int row = 0; row < ROWS; row++) {
+    int len = (row == 21)? COLUMNS : (row*7) % 5;
+
+    for (int k = 0; k < len; k++) {
+      int col = (row*13 + k*(COLUMNS/len + 1)) % COLUMNS;
+      entries.push_back({row, col, 0.1f*((float) ((row + 3*k) % 11)) - 0.5f});
+    }
+  }
+
+  CSRMatrix csr(ROWS, COLUMNS, entries);
+  REQUIRE(csr.nnz() == (int) entries.size());
+  REQUIRE(csr.row_length(21) == COLUMNS);
+
+  std::vector<float> x_scalar(COLUMNS);
+  fill_random(x_scalar);
+  Float::Array x(COLUMNS);
+  for (int i = 0; i < COLUMNS; i++) x[i] = x_scalar[i];
+
+  std::vector<float> expected(ROWS);
+  csr.mult_scalar(x_scalar.data(), expected.data());
+
+  Float::Array y(csr.rows_result());
+
+  auto check = [&] () {
+    for (int row = 0; row < ROWS; row++) {
+      INFO("row: " << row);
+      REQUIRE(y[row] == doctest::Approx(expected[row]).epsilon(1e-4));
+    }
+  };
+
+  SUBCASE("CSR") {
+    for (int num_qpus : {1, 3}) {
+      INFO("num QPUs: " << num_qpus);
+      csr.setNumQPUs(num_qpus);
+      y.fill(-1);
+      csr.mult(x, y, EMULATE);
+      check();
+    }
+
+    y.fill(-1);
+    csr.mult(x, y, INTERPRET);
+    check();
+  }
+
+  SUBCASE("SELL") {
+    SELLMatrix sell(csr);
+    REQUIRE(sell.num_slices() == 4);
+    REQUIRE(sell.stored_size() < 16*sell.num_slices()*COLUMNS);  // Less than plain ELLPACK
+
+    for (int num_qpus : {1, 3}) {
+      INFO("num QPUs: " << num_qpus);
+      sell.setNumQPUs(num_qpus);
+      y.fill(-1);
+      sell.mult(x, y, EMULATE);
+      check();
+    }
+
+    y.fill(-1);
+    sell.mult(x, y, INTERPRET);
+    check();
+  }
+
+  Platform::use_main_memory(false);
+}
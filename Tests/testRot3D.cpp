@@ -1,7 +1,9 @@
 #include "doctest.h"
 #include <math.h>
+#include <thread>
 #include "Kernels/Rot3D.h"
 #include "LibSettings.h"
+#include "Support/CoExecutor.h"
 
 using namespace kernels;
 
@@ -207,4 +209,57 @@ TEST_CASE("Test working of Rot3D example [rot3d]") {
 
     compareResults(x_1, y_1, x_2, y_2, N, "Rot3D_1 and Rot3D_2 1 QPU");
   }
+
+
+  SUBCASE("Co-execution on QPUs and host threads should return the same") {
+    int const NUM_QPUS = 2;
+
+    float* x_scalar = new float [N];
+    float* y_scalar = new float [N];
+    initArrays(x_scalar, y_scalar, N);
+    rot3D(N, cosf(THETA), sinf(THETA), x_scalar, y_scalar);
+
+    auto k = compile(rot3D_2);
+    k.setNumQPUs(NUM_QPUS);
+
+    Float::Array x(N), y(N);
+    CoExecutor co(16*NUM_QPUS, 3);
+
+    auto gpu = [&] (int begin, int end) {
+      REQUIRE(begin == 0);
+      k.load(end, cosf(THETA), sinf(THETA), &x, &y).call();
+    };
+
+    auto cpu = [&] (int begin, int end) {
+      rot3D(end - begin, cosf(THETA), sinf(THETA), x.ptr() + begin, y.ptr() + begin);
+    };
+
+    for (int run = 0; run < 3; run++) {
+      initArrays(x, y, N);
+      co.run(N, gpu, cpu);
+      REQUIRE(co.last_split() % (16*NUM_QPUS) == 0);
+      compareResults(x_scalar, y_scalar, x, y, N, "Rot3D co-execution", false);
+    }
+
+    delete [] x_scalar;
+    delete [] y_scalar;
+  }
+
+
+  SUBCASE("Co-execution should calibrate the split ratio") {
+    CoExecutor co(16, 2);
+    REQUIRE(co.gpu_ratio() == 0.5f);
+
+    auto fast = [] (int begin, int end) {};
+    auto slow = [] (int begin, int end) {
+      std::this_thread::sleep_for(std::chrono::microseconds(20*(end - begin)));
+    };
+
+    co.run(N, fast, slow);  // Host side slower, more to QPUs
+    REQUIRE(co.gpu_ratio() > 0.5f);
+
+    co.gpu_ratio(0.5f);
+    co.run(N, slow, fast);  // QPU side slower, more to host
+    REQUIRE(co.gpu_ratio() < 0.5f);
+  }
 }
@@ -0,0 +1,114 @@
+#include "doctest.h"
+#include <vector>
+#include "Kernels/Stencil.h"
+
+using namespace V3DLib;
+
+namespace {
+
+float const K = 0.25f;   // Heat dissipation constant, as in example HeatMap
+
+
+void heat_update(TemporalStencil::Block const &b, Float &output) {
+  Float sum = b.left(0) + b.current(0) + b.right(0) +
+              b.left(1) +                b.right(1) +
+              b.left(2) + b.current(2) + b.right(2);
+
+  output = b.current(1) - K * (b.current(1) - sum * 0.125f);
+}
+
+
+/**
+ * CPU version of the heat map, for checking results
+ */
+std::vector<float> heat_scalar(std::vector<float> map, int width, int height, int steps) {
+  std::vector<float> out(map);
+
+  for (int s = 0; s < steps; s++) {
+    for (int y = 1; y < height - 1; y++) {
+      for (int x = 1; x < width - 1; x++) {
+        auto at = [&map, width] (int y, int x) { return map[y*width + x]; };
+
+        float sum = at(y-1, x-1) + at(y-1, x) + at(y-1, x+1) +
+                    at(y, x-1)   +              at(y, x+1)   +
+                    at(y+1, x-1) + at(y+1, x) + at(y+1, x+1);
+        out[y*width + x] = at(y, x) - K*(at(y, x) - sum*0.125f);
+      }
+    }
+
+    map.swap(out);
+  }
+
+  return map;
+}
+
+}  // anon namespace
+
+
+TEST_CASE("Test temporal blocking of stencils [stencil]") {
+  int const WIDTH  = 64;
+  int const HEIGHT = 21;
+  int const SIZE   = WIDTH*HEIGHT;
+
+  std::vector<float> init(SIZE);
+  for (int i = 0; i < SIZE; i++) {
+    init[i] = (float) ((7*i) % 23);
+  }
+
+  Float::Array a(SIZE);
+  Float::Array b(SIZE);
+
+  auto check = [&] (TemporalStencil &stencil, int steps, int num_qpus, CallType call_type = CALL) {
+    for (int i = 0; i < SIZE; i++) {
+      a[i] = init[i];
+    }
+    b.fill(-1.0f);
+
+    stencil.setNumQPUs(num_qpus);
+    Float::Array &result = stencil.run(a, b, steps, call_type);
+    REQUIRE(!stencil.has_errors());
+
+    auto expected = heat_scalar(init, WIDTH, HEIGHT, steps);
+
+    for (int i = 0; i < SIZE; i++) {
+      INFO("steps: " << steps << ", num_qpus: " << num_qpus << ", x: " << i % WIDTH << ", y: " << i / WIDTH);
+      REQUIRE(result[i] == doctest::Approx(expected[i]).epsilon(0.001));
+    }
+  };
+
+  SUBCASE("Default block steps and strip") {
+    TemporalStencil stencil(WIDTH, HEIGHT, heat_update);
+    check(stencil, 4, 1);
+    check(stencil, 10, 3);  // Final round is partial
+    check(stencil, 9, 2);
+  }
+
+  SUBCASE("Maximum block steps") {
+    TemporalStencil stencil(WIDTH, HEIGHT, heat_update, TemporalStencil::MAX_BLOCK_STEPS);
+    check(stencil, 8, 4);
+    check(stencil, 3, 2);
+  }
+
+  SUBCASE("Wider strip") {
+    TemporalStencil stencil(WIDTH, HEIGHT, heat_update, 3, 3);
+    check(stencil, 7, 3);
+  }
+
+  SUBCASE("Multiple rounds in a single launch") {
+    // The QPUs swap the buffers in the kernel, the loads need to see the stores of the previous round
+    TemporalStencil stencil(WIDTH, HEIGHT, heat_update, 2);
+    check(stencil, 7, 3, INTERPRET);
+    check(stencil, 7, 3, EMULATE);
+  }
+
+  SUBCASE("Zero steps leave the input as is") {
+    TemporalStencil stencil(WIDTH, HEIGHT, heat_update);
+    a.fill(1.0f);
+    REQUIRE(&stencil.run(a, b, 0) == &a);
+  }
+
+  SUBCASE("Width must be a multiple of 16") {
+    REQUIRE_THROWS(TemporalStencil(WIDTH + 8, HEIGHT, heat_update));
+    REQUIRE_THROWS(TemporalStencil(WIDTH, HEIGHT, heat_update, TemporalStencil::MAX_BLOCK_STEPS + 1));
+  }
+}
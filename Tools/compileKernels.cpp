@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// Example of ahead-of-time compilation of kernels
+//
+// Compiles a kernel and writes the result to a kernel blob file,
+// `<kernel name>.v3dk` in the current directory. The blob can be run
+// with `BlobKernel`, without compiling the kernel at run time.
+//
+// This handles the `rot3D` kernels of the library only. Other kernels with the
+// same parameter types can be added to `kernel_names` and `funcs` in `main()`;
+// kernels with other parameter types need a separate `compile()` call.
+//
+// Kernels of your own can be handled in the same way:
+//
+//    auto k = compile(my_kernel, V3D);
+//    k.blob().save("my_kernel.v3dk");
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <string>
+#include <CmdParameters.h>
+#include "V3DLib.h"
+#include "Kernels/Rot3D.h"
+
+using namespace V3DLib;
+
+std::vector<const char *> const kernel_names = { "rot3D_2", "rot3D_1", "rot3D_1a" };  // First is default
+std::vector<const char *> const targets      = { "both", "vc4", "v3d" };              // idem
+
+CmdParameters params = {
+  "compileKernels - compile a rot3D kernel to a kernel blob file (example)\n",
+  {{
+    "Kernel",
+    "-k=",
+    kernel_names,
+    "Select the kernel to compile"
+  }, {
+    "Target",
+    "-t=",
+    targets,
+    "Select the platform(s) to compile for"
+  }}
+};
+
+
+struct Settings {
+  int kernel;
+  std::string kernel_name;
+  CompileFor compile_for;
+
+  int init(int argc, const char *argv[]) {
+    auto ret = params.handle_commandline(argc, argv, false);
+    if (ret != CmdParameters::ALL_IS_WELL) return ret;
+
+    kernel      = params.parameters()["Kernel"]->get_int_value();
+    kernel_name = params.parameters()["Kernel"]->get_string_value();
+
+    CompileFor const target_values[] = { BOTH, VC4, V3D };
+    compile_for = target_values[params.parameters()["Target"]->get_int_value()];
+
+    return CmdParameters::ALL_IS_WELL;
+  }
+} settings;
+
+
+int main(int argc, char const *argv[]) {
+  int ret = settings.init(argc, argv);
+  if (ret != CmdParameters::ALL_IS_WELL) return ret;
+
+  using KernelType = decltype(kernels::rot3D_1);
+  KernelType *funcs[] = { kernels::rot3D_2, kernels::rot3D_1, kernels::rot3D_1a };
+
+  auto k = compile(funcs[settings.kernel], settings.compile_for);
+  if (k.has_errors()) {
+    printf("Errors during compile:\n%s\n", k.get_errors().c_str());
+    return 1;
+  }
+
+  std::string filename = settings.kernel_name + ".v3dk";
+  if (!k.blob().save(filename.c_str())) {
+    return 1;
+  }
+
+  printf("Kernel '%s' written to '%s'\n", settings.kernel_name.c_str(), filename.c_str());
+  return 0;
+}
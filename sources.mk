@@ -24,6 +24,9 @@ OBJ := \
   Target/Emulator.o  \
   Target/Satisfy.o  \
   BaseKernel.o  \
+  BlobKernel.o  \
+  PersistentKernel.o  \
+  CoSchedule.o  \
   Source/Lang.o  \
   Source/Cond.o  \
   Source/OpItems.o  \
@@ -33,22 +36,30 @@ OBJ := \
   Source/Pretty.o  \
   Source/BExpr.o  \
   Source/Int.o  \
+  Source/Int8x4.o  \
   Source/Functions.o  \
+  Source/MathLib.o  \
+  Source/Random.o  \
   Source/gather.o  \
   Source/Op.o  \
   Source/Expr.o  \
   Source/StmtStack.o  \
   Source/CExpr.o  \
   Source/Float.o  \
+  Source/Half.o  \
+  Source/Atomic.o  \
+  Source/Local.o  \
   Source/Complex.o  \
   Source/Var.o  \
   Source/Stmt.o  \
   Support/debug.o  \
   Support/Timer.o  \
+  Support/CoExecutor.o  \
   Support/InstructionComment.o  \
   Support/basics.o  \
   Support/RegIdSet.o  \
   Support/pgm.o  \
+  Support/interleave.o  \
   Support/Helpers.o  \
   Support/Platform.o  \
   Support/HeapManager.o  \
@@ -56,11 +67,16 @@ OBJ := \
   Common/SharedArray.o  \
   Common/BufferObject.o  \
   Common/CompileData.o  \
+  Common/KernelBlob.o  \
   Kernels/DotVector.o  \
   Kernels/Cursor.o  \
+  Kernels/LayoutPtr.o  \
   Kernels/Rot3D.o  \
   Kernels/ComplexDotVector.o  \
   Kernels/Matrix.o  \
+  Kernels/GEMM.o  \
+  Kernels/SpMV.o  \
+  Kernels/Stencil.o  \
   Liveness/Range.o  \
   Liveness/LiveSet.o  \
   Liveness/UseDef.o  \
@@ -85,10 +101,13 @@ OBJ := \
   v3d/Driver.o  \
   v3d/RegisterMapping.o  \
   v3d/KernelDriver.o  \
+  v3d/Threading.o  \
+  v3d/Invoke.o  \
   vc4/PerformanceCounters.o  \
   vc4/Mailbox.o  \
   vc4/BufferObject.o  \
   vc4/SourceTranslate.o  \
+  vc4/LoadPath.o  \
   vc4/RegAlloc.o  \
   vc4/Invoke.o  \
   vc4/RegisterMap.o  \
@@ -117,6 +136,7 @@ EXAMPLES := \
   Rot3D  \
   Matrix  \
   detectPlatform  \
+  compileKernels  \
 
 # support files for examples
 EXAMPLES_EXTRA := \
@@ -125,13 +145,17 @@ EXAMPLES_EXTRA := \
 TESTS_FILES := \
   Tests/testRegMap.o  \
   Tests/testImmediates.o  \
+  Tests/testLiveness.o  \
   Tests/testBO.o  \
+  Tests/testInvoke.o  \
   Tests/testMatrix.o  \
   Tests/testFFT.o  \
   Tests/testV3d.o  \
   Tests/testRot3D.o  \
+  Tests/testStencil.o  \
   Tests/testPrefetch.o  \
   Tests/testFunctions.o  \
+  Tests/testMath.o  \
   Tests/support/ProfileOutput.o  \
   Tests/support/disasm_kernel.o  \
   Tests/support/rotate_kernel.o  \